@@ -0,0 +1,32 @@
+/*
+ * acquire.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Periodic data acquisition task - samples the DS3231 time registers at a fixed rate.
+ *  Runs as a kernel task at a priority above the command line, so acquisition isn't delayed
+ *  by long running commands.
+ */
+
+#ifndef INC_ACQUIRE_H_
+#define INC_ACQUIRE_H_
+
+#include <stdint.h>
+
+#define ACQ_STACK_WORDS    160
+#define ACQ_DEFAULT_PERIOD 0     // ms, 0: acquisition stopped
+#define ACQ_SAMPLE_BUFFER_SIZE 128 // bytes, power of two (ringbuf.h)
+
+typedef struct {
+    uint8_t seconds;  // DS3231 registers 0-2, BCD
+    uint8_t minutes;
+    uint8_t hours;
+} ACQ_SAMPLE;
+
+void acq_init(void);
+
+// Command Line functions
+int cl_acq(void);
+
+#endif /* INC_ACQUIRE_H_ */
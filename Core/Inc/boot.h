@@ -0,0 +1,62 @@
+/*
+ * boot.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Boot time profile, and fast start to the first prompt
+ *
+ *  main() marks the end of each initialization stage with boot_mark().  Times are measured with
+ *  the DWT cycle counter from the start of main() (the startup code before it isn't measured),
+ *  each interval converted at the CPU clock it started with: SystemClock_Config() waits for the
+ *  HSE and PLL at the 8MHz reset clock.
+ *
+ *  The profile is kept in RAM that isn't initialized at start-up (section .noinit, see the linker
+ *  script), with the previous boot's profile, the boot count and the reset cause - so it survives
+ *  a reset ("reset" command, watchdog, NRST), but not a power cycle.  "boot" displays them.
+ *
+ *  With BOOT_FAST_START 1, the prompt is displayed as soon as the command line can take input.
+ *  Non-critical initialization - the greeting, and the soft I2C bus check (a slave left holding
+ *  SDA low by a reset is clocked free) - is deferred to a task, which runs on the first scheduler
+ *  pass.  Otherwise it is done in main(), before the prompt.
+ */
+
+#ifndef INC_BOOT_H_
+#define INC_BOOT_H_
+
+#include <stdint.h>
+
+#ifndef BOOT_FAST_START
+#define BOOT_FAST_START 0
+#endif
+
+// Initialization stages, in order: X(id, name)
+#define BOOT_STAGES(X) \
+    X(HAL_INIT,   "HAL_Init") \
+    X(CLOCK,      "SystemClock_Config") \
+    X(MX_INIT,    "MX_*_Init") \
+    X(UART,       "uart_start") \
+    X(TIMEBASE,   "timebase_init") \
+    X(PROF,       "prof_init") \
+    X(POOL,       "pool_init") \
+    X(I2C_CHECK,  "soft_i2c_bus_check") \
+    X(GREETING,   "greeting") \
+    X(PROMPT,     "prompt") \
+    X(DEFERRED,   "deferred init done")
+
+#define BOOT_STAGE_ENUM_X(id, name) BOOT_STAGE_##id,
+typedef enum {
+    BOOT_STAGES(BOOT_STAGE_ENUM_X)
+    BOOT_STAGE_COUNT
+} BOOT_STAGE;
+
+#define BOOT_MAGIC  0x424F4F54  // "BOOT"
+
+void boot_start(void);              // first thing in main(), after dwt_init()
+void boot_mark(BOOT_STAGE stage);   // end of a stage
+void boot_finish(void);             // greeting, I2C bus check and the first prompt, after cl_setup()
+
+// Command Line functions
+int cl_boot(void);
+
+#endif /* INC_BOOT_H_ */
@@ -0,0 +1,53 @@
+/*
+ * clock.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  System clock profiles, switchable at run time
+ *
+ *  The 8MHz HSE (ST-LINK MCO, bypass mode) is used directly, or multiplied by the PLL.
+ *  Switching profiles re-derives everything that depends on the clock:
+ *  - flash wait states (HAL_RCC_ClockConfig())
+ *  - SysTick reload for the 1ms HAL tick (HAL_RCC_ClockConfig())
+ *  - TIM4 prescaler, so the microsecond timebase and I2C delays don't change (timebase.h)
+ *  - USART2 baud rate register
+ *  - CPU cycles per microsecond, for cycle counter (DWT) timing, see clock_cycles_per_us()
+ *
+ *  The switch is made with interrupts disabled, after buffered serial output has been sent.
+ *  (With the tick stopped, the HAL's clock start-up timeouts can't expire - the HSE from the
+ *  ST-LINK is always present.)
+ *  The timebase loses the few hundred microseconds taken to switch (PLL lock time).
+ */
+
+#ifndef INC_CLOCK_H_
+#define INC_CLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"   // SystemCoreClock
+
+typedef struct {
+    uint8_t mhz;              // HCLK (and SYSCLK) frequency
+    uint32_t pll_mul;         // RCC_PLL_MULx, 0: no PLL, HSE is SYSCLK
+    uint32_t apb1_div;        // RCC_HCLK_DIVx, PCLK1 must not exceed 36MHz
+    uint32_t flash_latency;   // FLASH_LATENCY_x, 0: <= 24MHz, 1: <= 48MHz, 2: <= 72MHz
+} CLOCK_PROFILE;
+
+#define CLOCK_PROFILE_DEFAULT  3  // 72MHz, as set by SystemClock_Config()
+
+bool clock_set_profile(int profile);
+void clock_restore(void);   // re-apply the current profile, after stop mode
+const CLOCK_PROFILE * clock_profile(void);
+uint32_t clock_apb1_timer_hz(void); // TIM2-TIM4 clock
+
+// CPU clock cycles per microsecond
+static inline uint32_t clock_cycles_per_us(void)
+{
+    return SystemCoreClock / 1000000;
+}
+
+// Command Line functions
+int cl_clock(void);
+
+#endif /* INC_CLOCK_H_ */
@@ -9,6 +9,7 @@
 #include <stdio.h>	// printf()
 #include <stdint.h> // uint8_t
 #include <stdlib.h> // strtol()
+#include "sched.h"  // TASK
 
 
 // ANSI Examples: To get black letters on white background use ESC[30;47m
@@ -32,10 +33,14 @@
 #define _BS  '\b' /*(char)8 */
 #define _CR  '\r'
 #define _LF  '\n'
+#define _CTRL_C  '\003' /* cancel foreground task */
 
 // Defines
 #define MAXWORDS 10     // support up to 10 (command and parameters)
 #define MAXSERIALBUF 64 // Our command line will use a 64 byte buffer
+#define CL_EVERY_MAX_MS 2147483 // longest "every" period - under 2^31 us, as software timers need
+#define CL_BATCH_MAX_WORDS 20 // words of "repeat", "every" and ';' separated commands, separators included
+#define CL_STDOUT_BUFFER_SIZE 128 // stdout line buffer, see cl_setup()
 
 // Externs
 extern char buffer[]; // holds command strings from user
@@ -48,8 +53,10 @@ extern int __io_getchar(void);
 int cl_isWhiteSpace(char c);
 int cl_parseArgcArgv(char * inBuf,char **words, int count);
 void cl_setup(void);
-void cl_loop(void);
+bool cl_loop(void);
 void cl_process_buffer(void);
+TASK * cl_start_task(const char * name, TASK_FUNC function, void * ctx);
+uint16_t timer_delay_us(uint16_t delay_us);
 
 // command line functions
 char * PrintHalStatus(int status);
@@ -59,6 +66,10 @@ int cl_id(void);
 int cl_info(void);
 int cl_reset(void);
 int cl_version(void);
+int cl_time(void);
+int cl_cmdstats(void);
+int cl_repeat(void);
+int cl_every(void);
 int cl_timer(void);
 int cl_timer_delay_test(void);
 int cl_collect_int(void);
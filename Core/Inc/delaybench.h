@@ -0,0 +1,29 @@
+/*
+ * delaybench.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Delay accuracy benchmark
+ *
+ *  Sweeps requested delays from 250ns to 1ms through each delay engine, measuring the actual
+ *  delay with the DWT cycle counter (dwt.h).  The error (actual - requested) of each sample is
+ *  added to a histogram.  Interrupts taken during a sample (irq_counts[], stm32f1xx_it.h) mark
+ *  the sample, so outliers can be blamed on SysTick, DMA, UART or timer interrupts.
+ *
+ *  Engines:
+ *    i2c    i2c_delay_us() - the soft I2C bit timing, TIM4 based
+ *    timer  timer_delay_us() - TIM4 based, returns the delta it saw
+ *    dwt    dwt_delay_cycles() - CPU cycle counter, sub-microsecond resolution
+ *  The microsecond engines round requests up to whole microseconds.
+ */
+
+#ifndef INC_DELAYBENCH_H_
+#define INC_DELAYBENCH_H_
+
+#define DELAYBENCH_DEFAULT_N  100  // samples per engine and delay
+
+// Command Line functions
+int cl_delay_bench(void);
+
+#endif /* INC_DELAYBENCH_H_ */
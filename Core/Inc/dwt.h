@@ -0,0 +1,38 @@
+/*
+ * dwt.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Cortex-M3 DWT cycle counter - CPU clock resolution timing
+ *
+ *  The 32-bit count wraps every 59.6 seconds at 72MHz.  Convert cycles to time with
+ *  clock_cycles_per_us() (clock.h), as the CPU clock changes with the clock profile.
+ */
+
+#ifndef INC_DWT_H_
+#define INC_DWT_H_
+
+#include <stdint.h>
+#include "main.h"   // CMSIS core registers
+
+// Enable the cycle counter (trace must be enabled first)
+static inline void dwt_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t dwt_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+// Spin for a number of CPU cycles
+static inline void dwt_delay_cycles(uint32_t cycles)
+{
+    uint32_t start = DWT->CYCCNT;
+    while(DWT->CYCCNT - start < cycles) ;
+}
+
+#endif /* INC_DWT_H_ */
@@ -0,0 +1,37 @@
+/*
+ * histogram.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Log-linear histogram for latency measurements
+ *
+ *  Each power of two range is split into 4 buckets, so a bucket is at most 25% wide:
+ *  0, 1, 2, 3, 4, 5, 6, 7, 8-9, 10-11, 12-13, 14-15, 16-19, ...  Values approaching 2^20 (about
+ *  a second, in microseconds) and above share the last bucket.  Adding a value is constant time.
+ *  Percentiles are reported as the upper bound of the bucket holding them.
+ */
+
+#ifndef INC_HISTOGRAM_H_
+#define INC_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#define HIST_SUB_BITS  2                        // 4 buckets per power of two
+#define HIST_BUCKETS   ((20 - 1) << HIST_SUB_BITS) // up to 2^20
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[HIST_BUCKETS];
+} HISTOGRAM;
+
+void hist_clear(HISTOGRAM * hist);
+void hist_add(HISTOGRAM * hist, uint32_t value);
+uint32_t hist_percentile(const HISTOGRAM * hist, unsigned percent);
+uint32_t hist_mean(const HISTOGRAM * hist);
+void hist_print(const HISTOGRAM * hist, const char * units);
+
+#endif /* INC_HISTOGRAM_H_ */
@@ -0,0 +1,61 @@
+/*
+ * i2c_stats.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Per-device and per-bus I2C statistics
+ *
+ *  soft_i2c.c counts each transaction into the bus totals, and into the device's slot.  Slots are
+ *  found through a 128 byte map indexed by the 7-bit address, so lookup is a single array read.
+ *  A slot is assigned the first time an address is acknowledged - scans probing empty addresses
+ *  only count towards the bus totals.  With all slots in use, other devices are only counted
+ *  in the bus totals ("unslotted").
+ *
+ *  "i2cstats bin" prints the statistics as one line, "I2CSTATS <hex>", for host polling.
+ *  The binary image (little-endian):
+ *    I2C_STATS_HEADER
+ *    I2C_STATS bus totals
+ *    slot_count x (uint8_t address, 3 reserved bytes, I2C_STATS)
+ *  Counters (and elapsed_us) are 32-bit and wrap - a poller works with differences.
+ */
+
+#ifndef INC_I2C_STATS_H_
+#define INC_I2C_STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define I2C_STATS_SLOTS    16
+#define I2C_STATS_MAGIC    "I2ST"
+#define I2C_STATS_VERSION  1
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes_written;   // data bytes, not including addresses
+    uint32_t bytes_read;
+    uint32_t nak_addr;        // address not acknowledged
+    uint32_t nak_data;        // written byte not acknowledged
+    uint32_t timeouts;        // SCL held low (clock stretching) longer than I2C_STRETCH_TIMEOUT_US
+    uint32_t recoveries;      // bus recovery sequences, after a timeout
+    uint32_t stretch_us;      // time waiting for SCL to rise
+    uint32_t busy_us;         // time holding the bus
+} I2C_STATS;
+
+typedef struct {
+    char magic[4];            // I2C_STATS_MAGIC
+    uint8_t version;          // I2C_STATS_VERSION
+    uint8_t slot_count;       // slots in use
+    uint16_t reserved;
+    uint32_t elapsed_us;      // since the statistics were cleared - for utilisation
+    uint32_t unslotted;       // acknowledged transactions with no slot free
+} I2C_STATS_HEADER;
+
+// Add a transaction's counts.  Called by soft_i2c.c with the bus mutex held.
+void i2c_stats_add(uint8_t addr, const I2C_STATS * tx, bool acked);
+void i2c_stats_clear(void);
+
+// Command Line functions
+int cl_i2c_stats(void);
+
+#endif /* INC_I2C_STATS_H_ */
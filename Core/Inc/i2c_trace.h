@@ -0,0 +1,75 @@
+/*
+ * i2c_trace.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Soft I2C edge tracer - an on-board logic analyzer for the bit engine (soft_i2c.c)
+ *
+ *  With I2C_TRACE_ENABLED 1, every SCL/SDA transition driven by soft_i2c.c, and every SDA sample
+ *  read back, is recorded in a RAM ring with a DWT cycle count timestamp.  The ring holds the
+ *  latest I2C_TRACE_SIZE events, older ones are overwritten.  "i2ctrace" dumps it.
+ *
+ *  Each event is one 32-bit word: cycle count << 3 | flags.  Recording costs a DWT read, a
+ *  store and an index increment.  Timestamps keep 29 bits of the cycle count, so times between
+ *  events are correct up to 7.4 seconds (at 72MHz).
+ *
+ *  The driven level is recorded, not the pin level - a released (open drain) line rises as fast
+ *  as the pull-up allows.  SDA samples record the level read, e.g. a slave's ACK.
+ */
+
+#ifndef INC_I2C_TRACE_H_
+#define INC_I2C_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"   // DWT
+
+// Set to 1 to compile in the tracer
+#ifndef I2C_TRACE_ENABLED
+#define I2C_TRACE_ENABLED  0
+#endif
+
+#define I2C_TRACE_SIZE     256   // events, power of two
+
+// Event flags
+#define I2C_TRACE_SCL      0x01  // SCL level
+#define I2C_TRACE_SDA      0x02  // SDA level
+#define I2C_TRACE_SAMPLE   0x04  // SDA read (not driven)
+#define I2C_TRACE_FLAGS    3     // bits
+
+#if I2C_TRACE_ENABLED
+extern uint32_t i2c_trace_events[I2C_TRACE_SIZE];
+extern uint16_t i2c_trace_head;        // free running event count
+extern uint8_t i2c_trace_lines;        // driven SCL/SDA levels
+extern volatile bool i2c_trace_paused; // set while the ring is dumped
+
+static inline void i2c_trace_record(uint8_t flags)
+{
+    if(i2c_trace_paused) return;
+    i2c_trace_events[i2c_trace_head++ & (I2C_TRACE_SIZE - 1)] = (DWT->CYCCNT << I2C_TRACE_FLAGS) | flags;
+}
+
+// A line was driven - recorded when its level changes
+static inline void i2c_trace_line(uint8_t line, bool high)
+{
+    uint8_t lines = high ? (i2c_trace_lines | line) : (i2c_trace_lines & ~line);
+    if(lines == i2c_trace_lines) return;
+    i2c_trace_lines = lines;
+    i2c_trace_record(lines);
+}
+
+// SDA was read
+static inline void i2c_trace_sample(bool sda)
+{
+    i2c_trace_record((i2c_trace_lines & I2C_TRACE_SCL) | (sda ? I2C_TRACE_SDA : 0) | I2C_TRACE_SAMPLE);
+}
+#else
+#define i2c_trace_line(line,high)
+#define i2c_trace_sample(sda)
+#endif
+
+// Command Line functions
+int cl_i2c_trace(void);
+
+#endif /* INC_I2C_TRACE_H_ */
@@ -0,0 +1,75 @@
+/*
+ * i2c_txtrace.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  I2C transaction trace - every i2c_write_read() and i2c_device_ready() call is recorded
+ *
+ *  Records go into a RAM ring holding the latest I2C_TXTRACE_SIZE transactions.  Each has the
+ *  call time, the time spent waiting for the bus mutex, the end time, the address, direction,
+ *  byte counts, ACK status and the caller (cooperative task, kernel task, or "main").
+ *  Records are written with the bus mutex held, so there is a single writer.
+ *
+ *  "i2ctx dump" prints the ring as a binary image, hex encoded between "I2CTX BEGIN <bytes>"
+ *  and "I2CTX END" lines.  The image (little-endian):
+ *    I2C_TX_HEADER
+ *    caller names: caller_count x (uint8_t length, characters)
+ *    I2C_TX_RECORD x record_count, oldest first
+ *  Tools/i2ctx2json converts a capture of it to Chrome trace JSON, for Perfetto.
+ *
+ *  No HAL dependencies - this header is shared with the host tools (Tools/).
+ */
+
+#ifndef INC_I2C_TXTRACE_H_
+#define INC_I2C_TXTRACE_H_
+
+#include <stdint.h>
+
+#define I2C_TXTRACE_SIZE     64   // records, power of two
+#define I2C_TXTRACE_CALLERS  16   // distinct caller names
+#define I2C_TX_MAGIC         "I2TX"
+#define I2C_TX_VERSION       1
+
+// Record flags
+#define I2C_TX_PROBE   0x01  // i2c_device_ready()
+#define I2C_TX_WRITE   0x02  // write phase
+#define I2C_TX_READ    0x04  // read phase
+#define I2C_TX_NAK     0x08  // not acknowledged (or timed out)
+#define I2C_TX_TIMEOUT 0x10  // SCL held low too long, bus recovered
+
+typedef struct {
+    char magic[4];            // I2C_TX_MAGIC
+    uint8_t version;          // I2C_TX_VERSION
+    uint8_t record_size;      // sizeof(I2C_TX_RECORD)
+    uint8_t caller_count;
+    uint8_t reserved;
+    uint32_t record_count;
+    uint32_t dump_us;         // timebase_us32() when dumped
+} I2C_TX_HEADER;
+
+typedef struct {
+    uint32_t start_us;        // timebase_us32() at the call, before waiting for the bus
+    uint32_t end_us;
+    uint16_t wait_us;         // waiting for the bus mutex, limited to 65535
+    uint8_t addr;             // 7-bit address
+    uint8_t flags;            // I2C_TX_xxx
+    uint8_t write_count;
+    uint8_t read_count;
+    uint8_t caller;           // index of the caller's name
+    uint8_t reserved;
+} I2C_TX_RECORD;
+
+#ifndef __cplusplus
+_Static_assert(sizeof(I2C_TX_HEADER) == 16, "I2C_TX_HEADER layout");
+_Static_assert(sizeof(I2C_TX_RECORD) == 16, "I2C_TX_RECORD layout");
+#endif
+
+// Called by soft_i2c.c with the bus mutex held.  start_us: call time, locked_us: mutex acquired.
+void i2c_txtrace_record(uint32_t start_us, uint32_t locked_us, uint8_t addr, uint8_t flags,
+                        uint8_t write_count, uint8_t read_count);
+
+// Command Line functions
+int cl_i2c_txtrace(void);
+
+#endif /* INC_I2C_TXTRACE_H_ */
@@ -0,0 +1,56 @@
+/*
+ * i2c_vcd.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Soft I2C trace to VCD (Value Change Dump) converter, for viewing in GTKWave
+ *
+ *  Events (i2c_trace.h flags) are fed in one at a time, with a time in nanoseconds, and the VCD
+ *  text is written as they arrive - nothing is buffered, so traces of any length can be streamed.
+ *  Along with SCL and SDA, decoded annotation signals are written:
+ *    start, stop  pulse at each START / STOP condition
+ *    data         8-bit byte value, after the 8th bit of each byte
+ *    ack          1: acknowledged, 0: not acknowledged, after the 9th bit
+ *
+ *  Bits are latched on the falling edge of SCL.  SDA is the driven level, or the level sampled
+ *  while the slave drives SDA (ACK, read data).
+ *
+ *  No HAL dependencies - this file is also compiled into the host tools (Tools/).
+ */
+
+#ifndef INC_I2C_VCD_H_
+#define INC_I2C_VCD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Receives the VCD text, in pieces
+typedef void (*I2C_VCD_WRITE)(void * arg, const char * text);
+
+typedef struct {
+    I2C_VCD_WRITE write;
+    void * arg;
+    uint64_t time_ns;      // time of the last change written
+    bool started;          // first event seen (initial values written)
+    uint8_t driven;        // driven SCL/SDA levels (I2C_TRACE_SCL | I2C_TRACE_SDA)
+    uint8_t sda;           // SDA level shown
+    uint8_t pulses;        // start/stop signals to return to 0 at the next time step
+    bool clocked;          // SCL rose since the START - the next SCL fall ends a bit
+    uint8_t bits;          // bits received since START, or the last ACK
+    uint8_t byte;          // byte being received
+} I2C_VCD;
+
+void i2c_vcd_begin(I2C_VCD * vcd, I2C_VCD_WRITE write, void * arg, const char * source);
+void i2c_vcd_event(I2C_VCD * vcd, uint64_t time_ns, uint8_t flags);
+void i2c_vcd_end(I2C_VCD * vcd, uint64_t time_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_I2C_VCD_H_ */
@@ -0,0 +1,31 @@
+/*
+ * i2cbench.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  I2C throughput and latency benchmark
+ *
+ *  Runs one of four workloads against a device, for a number of transactions or a duration:
+ *    probe - address only (i2c_device_ready()), takes no length argument
+ *    write - register byte followed by zeros, see I2CBENCH_WRITE_REG, up to I2CBENCH_WRITE_MAX_LEN
+ *    read  - read from the device's current register
+ *    wr    - write register 0, then read (i2c_write_read())
+ *  Each transaction is timed with the microsecond timebase, and added to a latency histogram.
+ *  The benchmark runs as a task, yielding after each transaction.
+ */
+
+#ifndef INC_I2CBENCH_H_
+#define INC_I2CBENCH_H_
+
+#define I2CBENCH_MAX_LEN       32   // largest transfer (bytes)
+#define I2CBENCH_DEFAULT_N     100  // transactions, if not given
+#define I2CBENCH_MAX_MS        (UINT32_MAX / 1000) // longest duration, duration_us is 32 bits
+#define I2CBENCH_WRITE_REG     0x07 // DS3231 alarm 1 and 2 registers, 0x07 - 0x0D
+#define I2CBENCH_WRITE_MAX_LEN 8    // register byte and the 7 alarm bytes: further writes would
+                                    // reach control, status, aging offset, then wrap to the time
+
+// Command Line functions
+int cl_i2c_bench(void);
+
+#endif /* INC_I2CBENCH_H_ */
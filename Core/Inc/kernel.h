@@ -0,0 +1,116 @@
+/*
+ * kernel.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Minimal fixed priority preemptive kernel
+ *
+ *  - Static task control blocks and stacks, provided by the caller
+ *  - Higher number is higher priority.  The highest priority READY task always runs.
+ *  - Tasks of equal priority are time sliced (round robin) by the SysTick interrupt
+ *  - Context switches are performed by PendSV (lowest priority exception), see kernel_port.c
+ *  - Mutex with priority inheritance, used to guard the soft I2C bus
+ *  - Event (binary semaphore) a task can block on, signalled from an interrupt handler
+ *  - The idle task sleeps the processor (power.h) until the next interrupt or delayed task wake
+ *
+ *  The scheduling logic (kernel.c) doesn't touch the hardware.  Everything processor specific
+ *  (stack frame layout, PendSV, critical sections) lives behind the "port" functions below.
+ *
+ *  Mutex notes:
+ *  - A task is expected to hold one mutex at a time.  When the mutex is released, the
+ *    owner's priority returns to its base priority.
+ *  - Mutexes must not be used from interrupt handlers.
+ *  - Before kernel_start(), or with KERNEL_ENABLED 0, lock/unlock do nothing.
+ */
+
+#ifndef INC_KERNEL_H_
+#define INC_KERNEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Set to 0 to run the command line from the main() super-loop instead of as a kernel task
+#ifndef KERNEL_ENABLED
+#define KERNEL_ENABLED  1
+#endif
+
+#define KERNEL_MAX_TASKS      4
+#define KERNEL_TIME_SLICE_MS  10          // round robin period for tasks of equal priority
+#define KERNEL_STACK_FILL     0xDEADBEEF  // stack "paint", used to find stack high water mark
+#define KERNEL_WAIT_FOREVER   0xFFFFFFFF  // kevent_wait() timeout
+
+// Task priorities
+#define KERNEL_PRIORITY_IDLE  0
+#define KERNEL_PRIORITY_CLI   1
+#define KERNEL_PRIORITY_ACQ   3
+
+// Task states
+#define KTASK_READY    0
+#define KTASK_DELAYED  1  // waiting for wake_tick
+#define KTASK_BLOCKED  2  // waiting for a mutex or event
+#define KTASK_DEAD     3  // task function returned
+
+typedef struct KMUTEX KMUTEX;
+
+typedef struct {
+    uint32_t * sp;            // saved stack pointer - must be first, used by PendSV_Handler
+    const char * name;
+    void (*entry)(void *);    // task function
+    void * arg;
+    uint32_t * stack;         // lowest address of the task's stack
+    uint32_t stack_words;     // stack size, 32-bit words
+    uint8_t base_priority;    // assigned priority
+    uint8_t priority;         // effective priority (may be raised by priority inheritance)
+    uint8_t state;            // KTASK_xxx
+    uint32_t wake_tick;       // HAL_GetTick() value to wake up, when KTASK_DELAYED
+    uint32_t wake_us;         // timebase_us32() when made READY by the tick, for latency measurement
+    KMUTEX * waiting_on;      // mutex this task is blocked on
+    uint32_t switches;        // number of times the task was switched in
+} KTASK;
+
+struct KMUTEX {
+    KTASK * volatile owner;
+    uint8_t count;            // recursive lock count
+    uint32_t contentions;     // number of times a task had to wait for this mutex
+};
+
+typedef struct {
+    KTASK * volatile waiter;  // task blocked on the event
+    volatile bool pending;    // signalled, not yet consumed by kevent_wait()
+} KEVENT;
+
+// Kernel API
+void kernel_init(void);
+void kernel_task_create(KTASK * task, const char * name, void (*entry)(void *), void * arg,
+                        uint32_t * stack, uint32_t stack_words, uint8_t priority);
+void kernel_start(void);   // does not return
+bool kernel_running(void);
+void kernel_tick(void);    // called from SysTick_Handler()
+void kernel_yield(void);
+void kernel_delay(uint32_t ms);
+void kernel_delay_until(uint32_t * last_wake, uint32_t period_ms);
+uint32_t kernel_stack_unused(const KTASK * task);
+void kernel_task_exit(void);
+uint32_t kernel_idle_ms(void);
+
+bool kevent_wait(KEVENT * event, uint32_t timeout_ms);
+void kevent_signal(KEVENT * event);
+
+void kmutex_lock(KMUTEX * mutex);
+void kmutex_unlock(KMUTEX * mutex);
+
+// Port layer - processor specific, see kernel_port.c
+void port_init_stack(KTASK * task);
+void port_start(KTASK * first);  // does not return
+void port_request_switch(void);
+uint32_t port_enter_critical(void);
+void port_exit_critical(uint32_t state);
+
+extern KTASK * volatile kernel_current; // running task
+extern KTASK * volatile kernel_next;    // task PendSV_Handler will switch to
+
+// Command Line functions
+int cl_ps(void);
+
+#endif /* INC_KERNEL_H_ */
@@ -0,0 +1,45 @@
+/*
+ * latency.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Main loop latency and command line responsiveness monitor
+ *
+ *  Two delays are measured, into histograms (histogram.h):
+ *  - loop interval: time between the starts of consecutive sched_run() passes, while busy.
+ *    A pass that follows a sleep (sched_idle()) isn't counted.  The longest interval is reported
+ *    with the task that took the most time in that pass.
+ *  - RX delay: time from a console character's arrival to __io_getchar() reading it.  The USART
+ *    idle line interrupt records the DMA position and the arrival time of the last character of
+ *    a burst (one character time before the interrupt).  The delay is measured when the read
+ *    position reaches the recorded DMA position (or, when it was read before the line went idle,
+ *    from the time it was read).  Keystrokes are single character bursts.
+ *
+ *  A latency budget can be set: each interval or delay over it is counted, and optionally
+ *  logged (at most every LATENCY_LOG_MS), or stops the processor (Error_Handler()), so the
+ *  state can be examined with a debugger.
+ */
+
+#ifndef INC_LATENCY_H_
+#define INC_LATENCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LATENCY_LOG_MS  100   // minimum time between budget log messages
+
+typedef enum {
+    LATENCY_ACTION_COUNT,     // count budget overruns
+    LATENCY_ACTION_LOG,       // count and display
+    LATENCY_ACTION_ASSERT,    // display, then Error_Handler()
+} LATENCY_ACTION;
+
+void latency_loop(bool slept, const char * slowest); // sched_run(), start of each pass
+void latency_rx_idle(uint16_t dma_pos);   // USART2 idle line interrupt, DMA position in the RX buffer
+void latency_rx_read(uint16_t read_pos);  // __io_getchar(), position after the character read
+
+// Command Line functions
+int cl_latency(void);
+
+#endif /* INC_LATENCY_H_ */
@@ -0,0 +1,40 @@
+/*
+ * mem.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  RAM usage: static data, heap and main stack high water marks
+ *
+ *  RAM layout (STM32F103RBTX_FLASH.ld), 20KB:
+ *    .data | .bss | .noinit | newlib heap ->  ...free...  <- MSP stack | _estack
+ *  The linker only checks that _Min_Heap_Size and _Min_Stack_Size fit - at run time the heap
+ *  (_sbrk(), sysmem.c) may grow up to _Min_Stack_Size below the top of RAM.
+ *
+ *  mem_paint() fills the RAM between the heap and the stack with MEM_STACK_FILL, first thing in
+ *  main().  The lowest word no longer holding the fill is the stack's high water mark.  _sbrk()
+ *  records the heap's highest end.  Kernel task stacks are statically allocated (in .bss), their
+ *  usage is shown by "ps".
+ */
+
+#ifndef INC_MEM_H_
+#define INC_MEM_H_
+
+#include <stdint.h>
+
+#define MEM_STACK_FILL    0xDEADBEEF  // as KERNEL_STACK_FILL
+#define MEM_PAINT_MARGIN  64          // bytes below the stack pointer left unpainted
+
+void mem_paint(void);
+void mem_boot_done(void);        // initialization complete, record the heap's end
+uint32_t mem_stack_peak(void);   // bytes of MSP stack used since start-up
+
+// sysmem.c
+uint8_t * sysmem_heap_end(void);
+uint8_t * sysmem_heap_peak(void);
+uint32_t sysmem_sbrk_failures(void);
+
+// Command Line functions
+int cl_mem(void);
+
+#endif /* INC_MEM_H_ */
@@ -0,0 +1,40 @@
+/*
+ * pcsample.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Statistical profiler - samples the program counter from a timer interrupt
+ *
+ *  TIM2 interrupts at the sample rate, at the highest priority (0).  The handler takes the PC and
+ *  LR of the interrupted code from its exception stack frame (MSP or PSP - kernel tasks run on
+ *  the process stack), and counts them in two hash tables.  PC counts give a flat profile of
+ *  where the time goes, LR counts point at the callers of leaf functions (delays, HAL calls).
+ *  Everything is sampled - HAL, newlib, interrupt handlers of lower priority, the idle task.
+ *
+ *  Interrupts disabled with PRIMASK, and DMA interrupts (also priority 0), delay the sample until
+ *  they finish, so their time is charged to the instruction that follows.
+ *
+ *  "pcsample dump" prints the counts, which Tools/pcprof symbolizes against the ELF file:
+ *    PCSAMPLE BEGIN rate=<Hz> samples=<n> dropped=<n>
+ *    P <pc hex> <count>
+ *    L <lr hex> <count>
+ *    PCSAMPLE END
+ *  TIM2 isn't configured by CubeMX - it is set up here, like the RTC in power.c.  The prescaler
+ *  is set from the clock profile when sampling starts.
+ */
+
+#ifndef INC_PCSAMPLE_H_
+#define INC_PCSAMPLE_H_
+
+#include <stdint.h>
+
+#define PCSAMPLE_PC_SLOTS      128   // distinct PCs, power of two
+#define PCSAMPLE_LR_SLOTS      64    // distinct LRs, power of two
+#define PCSAMPLE_DEFAULT_HZ    1000
+#define PCSAMPLE_MAX_HZ        20000
+
+// Command Line functions
+int cl_pcsample(void);
+
+#endif /* INC_PCSAMPLE_H_ */
@@ -0,0 +1,48 @@
+/*
+ * pool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Fixed block pool allocator - deterministic replacement for malloc()
+ *
+ *  Newlib's malloc() fragments the small heap and its run time depends on the heap's history.
+ *  Here each size class is an array of equal blocks, carved from a static arena, with a free
+ *  list threaded through the free blocks:
+ *  - pool_alloc() takes a block from the smallest class that fits and has one free (a full
+ *    class falls back to the next larger one), pool_free() returns it to its own class.  Both
+ *    are constant time - a list push or pop, after at most POOL_CLASS_COUNT comparisons.
+ *  - Both may be called from interrupt handlers, the lists are updated with interrupts disabled.
+ *  - Each class counts allocations, failures and its lowest free count, see "pool".  A free of
+ *    a pointer that isn't an allocated block (not a block start, or a double free) is refused,
+ *    and counted as a bad free.
+ *
+ *  Intended for transaction descriptors and buffers of queued I2C work.  Nothing here calls
+ *  malloc(), and stdio's buffer is static (cl_setup()), so the heap doesn't grow after start-up
+ *  ("mem" shows any growth).
+ */
+
+#ifndef INC_POOL_H_
+#define INC_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Size classes: X(block size in bytes, multiple of 4, ascending; number of blocks)
+#define POOL_CLASSES(X) \
+    X(16,  16) \
+    X(32,  8)  \
+    X(64,  8)  \
+    X(128, 4)
+
+#define POOL_CLASS_COUNT_X(size, count) + 1
+#define POOL_CLASS_COUNT (0 POOL_CLASSES(POOL_CLASS_COUNT_X))
+
+void pool_init(void);
+void * pool_alloc(size_t size);  // NULL if no block is free
+void pool_free(void * ptr);      // NULL is ignored
+
+// Command Line functions
+int cl_pool(void);
+
+#endif /* INC_POOL_H_ */
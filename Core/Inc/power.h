@@ -0,0 +1,50 @@
+/*
+ * power.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Idle power management
+ *
+ *  When there is nothing to do, the processor waits for an interrupt instead of polling:
+ *  - Without the kernel, the main loop calls sched_idle() when every cooperative task is idle
+ *  - With the kernel, the command line task blocks on an event, and the idle task sleeps
+ *
+ *  Modes ("power" command):
+ *  - run    busy polling, no sleep (for comparison)
+ *  - sleep  WFI - the core clock stops, peripherals and DMA keep running.  Any interrupt wakes.
+ *  - stop   As sleep, but when idle for at least POWER_STOP_MIN_MS, enter stop mode: all clocks
+ *           stop, RAM and registers are retained.  The RTC (32.768kHz LSE) alarm wakes the
+ *           processor for the next delayed kernel task (acquisition), as do the B1 button and
+ *           a falling edge on the console RX pin (the first character typed is lost).
+ *           On wake, the system clock is restored, and the HAL tick and microsecond timebase
+ *           are advanced by the time spent stopped (from the RTC).
+ *
+ *  The wake latency - time from an interrupt making work for a task (sched_notify()) until the
+ *  scheduler runs - is measured and displayed by the "power" command.
+ */
+
+#ifndef INC_POWER_H_
+#define INC_POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POWER_STOP_MIN_MS  10   // shortest idle time worth stopping for
+#define POWER_RTC_HZ       1024 // RTC counter rate, LSE / 32
+#define POWER_IDLE_FOREVER 0xFFFFFFFF // power_idle() idle_ms, nothing scheduled
+
+typedef enum {
+    POWER_MODE_RUN,
+    POWER_MODE_SLEEP,
+    POWER_MODE_STOP,
+} POWER_MODE;
+
+void power_idle(uint32_t idle_ms);   // sleep until an interrupt, idle_ms: time until the next scheduled wake
+void power_sleep(uint32_t idle_ms);  // as power_idle(), called with interrupts disabled
+void power_wake_latency(uint32_t us); // record interrupt to scheduler latency
+
+// Command Line functions
+int cl_power(void);
+
+#endif /* INC_POWER_H_ */
@@ -0,0 +1,90 @@
+/*
+ * prof.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Function level cycle profiler, using the DWT cycle counter (dwt.h)
+ *
+ *  Each profiled site has an entry in PROF_SITES below, and enter/exit markers in the code:
+ *      void soft_i2c_sda_write(bool pinstate)
+ *      {
+ *          PROF_ENTER(GPIO_WRITE);
+ *          HAL_GPIO_WritePin(...);
+ *          PROF_EXIT(GPIO_WRITE);
+ *      }
+ *  Per site: calls, total, min and max cycles.  The cost of an empty enter/exit pair, measured
+ *  by prof_init(), is subtracted from every measurement.  A site nested inside another still
+ *  adds its own marker overhead to the outer site's time.
+ *
+ *  With PROF_ENABLED 0 (default) the markers compile to nothing.  "prof" displays the results,
+ *  "prof clear" resets them.
+ */
+
+#ifndef INC_PROF_H_
+#define INC_PROF_H_
+
+#include <stdint.h>
+#include "dwt.h"
+
+// Set to 1 to compile in the profiling markers
+#ifndef PROF_ENABLED
+#define PROF_ENABLED  0
+#endif
+
+// Profiled sites: X(id, name)
+#define PROF_SITES(X) \
+    X(GPIO_WRITE,    "HAL_GPIO_WritePin") \
+    X(I2C_DELAY,     "i2c_delay_us") \
+    X(I2C_WRITE8,    "soft_i2c_write8") \
+    X(I2C_READ8,     "soft_i2c_read8") \
+    X(CL_COMMAND,    "command") \
+    X(STDIO_WRITE,   "_write (printf)") \
+    X(PUTCHAR,       "__io_putchar") \
+    X(UART_TX_START, "uart_tx_start")
+
+#define PROF_SITE_ID(id, name)  PROF_##id,
+typedef enum {
+    PROF_SITES(PROF_SITE_ID)
+    PROF_SITE_COUNT
+} PROF_SITE;
+#undef PROF_SITE_ID
+
+typedef struct {
+    uint32_t calls;
+    uint32_t min;             // cycles
+    uint32_t max;
+    uint64_t total;
+} PROF_STATS;
+
+#if PROF_ENABLED
+extern PROF_STATS prof_stats[PROF_SITE_COUNT];
+extern uint32_t prof_overhead; // cycles, empty enter/exit pair
+
+static inline void prof_record(PROF_SITE site, uint32_t cycles)
+{
+    PROF_STATS * s = &prof_stats[site];
+    cycles = cycles > prof_overhead ? cycles - prof_overhead : 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq(); // a site may be used by more than one task
+    s->calls++;
+    s->total += cycles;
+    if(cycles < s->min) s->min = cycles;
+    if(cycles > s->max) s->max = cycles;
+    __set_PRIMASK(primask);
+}
+
+#define PROF_ENTER(id)  uint32_t prof_start_##id = dwt_cycles()
+#define PROF_EXIT(id)   prof_record(PROF_##id, dwt_cycles() - prof_start_##id)
+
+void prof_init(void);
+#else
+#define PROF_ENTER(id)
+#define PROF_EXIT(id)
+static inline void prof_init(void) {}
+#endif
+
+// Command Line functions
+int cl_prof(void);
+
+#endif /* INC_PROF_H_ */
@@ -0,0 +1,167 @@
+/*
+ * ringbuf.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Lock-free single producer / single consumer (SPSC) byte ring buffer
+ *
+ *  One side (ISR, DMA or task) only writes, the other side only reads.  No locking is required:
+ *  - head is only written by the producer, tail is only written by the consumer
+ *  - head and tail are free running 16-bit counts, so count = head - tail, with no wasted slot
+ *  - size must be a power of two (and no larger than 32768), index = count & (size - 1)
+ *  - A data memory barrier orders the buffer accesses with respect to the head / tail updates
+ *
+ *  Bulk copy functions ringbuf_write() / ringbuf_read() are provided, along with "span" functions
+ *  returning a pointer to the largest contiguous region that can be written / read in place.
+ *  Spans let a DMA controller move data directly to or from the ring (zero copy):
+ *      len = ringbuf_read_span(&tx, &ptr);    // start DMA with ptr, len
+ *      ...
+ *      ringbuf_read_commit(&tx, len);         // DMA complete, release the bytes
+ *
+ *  For a DMA controller in circular mode writing the ring buffer directly, the consumer calls
+ *  ringbuf_dma_head() with the DMA's current position, to advance head.
+ */
+
+#ifndef INC_RINGBUF_H_
+#define INC_RINGBUF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h> // memcpy()
+#include "main.h"   // __DMB()
+
+typedef struct {
+    uint8_t * buffer;
+    uint16_t size;            // power of two
+    volatile uint16_t head;   // free running write count, producer only
+    volatile uint16_t tail;   // free running read count, consumer only
+    uint16_t high_water;      // most bytes ever held, producer only
+    volatile uint32_t overflows; // bytes dropped, producer found buffer full
+} RINGBUF;
+
+static inline void ringbuf_init(RINGBUF * rb, uint8_t * buffer, uint16_t size)
+{
+    rb->buffer = buffer;
+    rb->size = size;
+    rb->head = 0;
+    rb->tail = 0;
+    rb->high_water = 0;
+    rb->overflows = 0;
+}
+
+// Bytes available to read
+static inline uint16_t ringbuf_count(const RINGBUF * rb)
+{
+    return (uint16_t)(rb->head - rb->tail);
+}
+
+// Bytes available to write
+static inline uint16_t ringbuf_free(const RINGBUF * rb)
+{
+    return rb->size - ringbuf_count(rb);
+}
+
+// Producer: make n bytes, already written at head, visible to the consumer
+static inline void ringbuf_write_commit(RINGBUF * rb, uint16_t n)
+{
+    __DMB(); // data written before head is advanced
+    rb->head += n;
+    uint16_t count = ringbuf_count(rb);
+    if(count > rb->high_water) rb->high_water = count;
+}
+
+// Producer: return contiguous space at head, write up to that many bytes then ringbuf_write_commit()
+static inline uint16_t ringbuf_write_span(RINGBUF * rb, uint8_t ** ptr)
+{
+    uint16_t index = rb->head & (rb->size - 1);
+    uint16_t space = ringbuf_free(rb);
+    uint16_t to_end = rb->size - index;
+    *ptr = &rb->buffer[index];
+    return space < to_end ? space : to_end;
+}
+
+// Producer: write one byte, returns false (and counts an overflow) when full
+static inline bool ringbuf_put(RINGBUF * rb, uint8_t data)
+{
+    if(!ringbuf_free(rb)) {
+        rb->overflows++;
+        return false;
+    }
+    rb->buffer[rb->head & (rb->size - 1)] = data;
+    ringbuf_write_commit(rb, 1);
+    return true;
+}
+
+// Producer: write up to len bytes, returns bytes written
+static inline uint16_t ringbuf_write(RINGBUF * rb, const uint8_t * data, uint16_t len)
+{
+    uint16_t written = 0;
+    while(written < len) {
+        uint8_t * ptr;
+        uint16_t span = ringbuf_write_span(rb, &ptr);
+        if(!span) {
+            rb->overflows += len - written;
+            break;
+        }
+        if(span > len - written) span = len - written;
+        memcpy(ptr, data + written, span);
+        written += span;
+        ringbuf_write_commit(rb, span);
+    }
+    return written;
+}
+
+// Consumer: return contiguous data at tail, read up to that many bytes then ringbuf_read_commit()
+static inline uint16_t ringbuf_read_span(RINGBUF * rb, uint8_t ** ptr)
+{
+    uint16_t count = ringbuf_count(rb);
+    uint16_t index = rb->tail & (rb->size - 1);
+    uint16_t to_end = rb->size - index;
+    __DMB(); // head read before the data
+    *ptr = &rb->buffer[index];
+    return count < to_end ? count : to_end;
+}
+
+// Consumer: release n bytes back to the producer
+static inline void ringbuf_read_commit(RINGBUF * rb, uint16_t n)
+{
+    __DMB(); // data read before tail is advanced
+    rb->tail += n;
+}
+
+// Consumer: read one byte, returns -1 when empty
+static inline int ringbuf_get(RINGBUF * rb)
+{
+    if(!ringbuf_count(rb)) return -1;
+    __DMB(); // head read before the data
+    uint8_t data = rb->buffer[rb->tail & (rb->size - 1)];
+    ringbuf_read_commit(rb, 1);
+    return data;
+}
+
+// Consumer: read up to len bytes, returns bytes read
+static inline uint16_t ringbuf_read(RINGBUF * rb, uint8_t * data, uint16_t len)
+{
+    uint16_t read = 0;
+    while(read < len) {
+        uint8_t * ptr;
+        uint16_t span = ringbuf_read_span(rb, &ptr);
+        if(!span) break;
+        if(span > len - read) span = len - read;
+        memcpy(data + read, ptr, span);
+        read += span;
+        ringbuf_read_commit(rb, span);
+    }
+    return read;
+}
+
+// Consumer: a circular DMA is the producer - advance head to the DMA's write position (0 to size-1)
+// Data the DMA writes faster than it is consumed is lost (overwritten) without notice
+static inline void ringbuf_dma_head(RINGBUF * rb, uint16_t position)
+{
+    uint16_t new_data = (uint16_t)(position - rb->head) & (rb->size - 1);
+    if(new_data) ringbuf_write_commit(rb, new_data);
+}
+
+#endif /* INC_RINGBUF_H_ */
@@ -0,0 +1,96 @@
+/*
+ * sched.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Cooperative (run to yield) task scheduler
+ *
+ *  Tasks are "stackless" - similar to Adam Dunkels' protothreads.  A task function is called
+ *  over and over by sched_run().  Each call runs until the task yields (returns TASK_RC_YIELD),
+ *  or completes (returns TASK_RC_DONE).  The resume point is saved in the TASK structure, so
+ *  anything that must survive a yield has to live in the task's context (not on the stack).
+ *
+ *  Example:
+ *    int my_task(TASK * task) {
+ *        MY_CONTEXT * ctx = task->ctx;
+ *        TASK_BEGIN(task);
+ *        for(ctx->i=0; ctx->i<10; ctx->i++) {
+ *            do_something();
+ *            TASK_YIELD(task);   // let the command line (and others) run
+ *        }
+ *        TASK_END(task);
+ *    }
+ *
+ *  A task with nothing to do until an interrupt occurs (e.g. the command line, waiting for a
+ *  character) returns TASK_RC_IDLE.  When every task is idle or sleeping, sched_run() returns
+ *  true, and the caller uses sched_idle() to sleep until an interrupt handler calls sched_notify().
+ *
+ *  Note: Since TASK_BEGIN() opens a switch statement, TASK_YIELD() can't be used from within
+ *  another switch statement inside the task function.
+ */
+
+#ifndef INC_SCHED_H_
+#define INC_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "swtimer.h"
+
+#define SCHED_MAX_TASKS  6   // includes the command line task
+
+// Task function return codes
+#define TASK_RC_YIELD    0   // call again
+#define TASK_RC_DONE     1   // task complete, release the slot
+#define TASK_RC_IDLE     2   // call again, after an interrupt (sched_notify())
+
+// Task flags
+#define TASK_FLAG_ACTIVE      0x01  // slot in use
+#define TASK_FLAG_FOREGROUND  0x02  // command line waits for this task to complete
+#define TASK_FLAG_CANCEL      0x04  // cancel requested (Ctrl-C or "kill")
+#define TASK_FLAG_QUIET       0x08  // console output discarded, see "repeat -q"
+
+typedef struct TASK TASK;
+typedef int (*TASK_FUNC)(TASK * task);
+
+struct TASK {
+    const char * name;
+    TASK_FUNC function;
+    void * ctx;          // task specific context - preserved across yields
+    uint16_t line;       // resume point, 0: start of task
+    uint8_t flags;       // TASK_FLAG_xxx
+    uint8_t id;          // job number displayed by "jobs"
+    volatile uint8_t sleeping; // not called until timer expires, see TASK_SLEEP()
+    SWTIMER timer;       // wakes a sleeping task
+    // Run time accounting
+    uint32_t start_tick; // HAL_GetTick() when task was started
+    uint32_t runs;       // number of times the task function was called
+    uint32_t run_us;     // total microseconds spent in the task function
+    uint32_t max_us;     // longest single call (time between yields)
+};
+
+// Protothread style macros - see example above
+#define TASK_BEGIN(task)    switch((task)->line) { case 0:
+#define TASK_YIELD(task)    do { (task)->line = __LINE__; return TASK_RC_YIELD; case __LINE__: ; } while(0)
+#define TASK_WAIT_UNTIL(task,cond) do { (task)->line = __LINE__; case __LINE__: if(!(cond)) return TASK_RC_YIELD; } while(0)
+#define TASK_END(task)      } (task)->line = 0; return TASK_RC_DONE
+// Sleep without spinning - the task isn't called again until a software timer (swtimer.h) wakes it
+#define TASK_SLEEP(task,us) do { sched_sleep((task),(us)); TASK_WAIT_UNTIL((task), !(task)->sleeping); } while(0)
+
+TASK * sched_start(const char * name, TASK_FUNC function, void * ctx, bool foreground);
+void sched_cancel(TASK * task);
+void sched_cancel_foreground(void);
+void sched_sleep(TASK * task, uint32_t us);
+TASK * sched_foreground(void);
+TASK * sched_find(TASK_FUNC function);
+TASK * sched_current(void);
+bool sched_quiet(void);
+bool sched_run(void);
+void sched_idle(void);
+void sched_notify(void);
+
+// Command Line functions
+int cl_jobs(void);
+int cl_kill(void);
+
+#endif /* INC_SCHED_H_ */
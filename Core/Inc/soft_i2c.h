@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stm32f1xx_hal.h> // Use F1XX HAL includes
+#include "kernel.h"        // KMUTEX
 
 // Our Pin Selections: GPIO.C0 and GPIO.C1
 #define Soft_SCL_Pin GPIO_PIN_0
@@ -19,10 +20,37 @@
 #define Soft_SDA_GPIO_Port GPIOC
 
 // Looking at STM32-F103RB, Hardware I2C, the START_DELAY and STOP_DELAY both appear to be 5us
-#define I2C_SCL_LOW_DELAY   5    // us units delay, SCL LOW
+// These are the Standard-mode (100KHz) delays, see I2C_TIMING for the other speeds
+#define I2C_SCL_LOW_DELAY   6    // us units delay, SCL LOW
 #define I2C_SCL_HIGH_DELAY  5	 // us units delay, SCL HIGH
 #define I2C_START_DELAY		5    // us units delay between SDA falling for Start Condition and SCL going low
 #define I2C_STOP_DELAY      5    // us units delay between SCL going high and SDA going high for Stop Condition
+#define I2C_BUF_DELAY       6    // us units bus free time between a Stop and the next Start
+#define I2C_RESTART_DELAY   6    // us units delay between SCL going high and SDA falling for a repeated Start
+#define I2C_STRETCH_TIMEOUT_US  25000 // longest a slave may hold SCL low (SMBus tTIMEOUT)
+
+// Bus speeds (UM10204 speed modes), selected with soft_i2c_set_speed() or "i2cspeed"
+// i2c_delay_us(n) waits n-1 to n microseconds from its start, which an interrupt can put anywhere
+// in a microsecond: each delay is the UM10204 minimum plus 1us, rounded up.  tBUF is counted from
+// the STOP's SDA release, it includes the rise time (tr).  tSU;STA follows the wait for SCL to
+// read high, which already covers Fast-mode's 0.6us with a 1us delay.  Tools/i2csim/i2c_conformance.cpp checks
+// them, see README.md.
+typedef enum {
+	I2C_SPEED_STANDARD,  // Standard-mode, up to 100KHz
+	I2C_SPEED_FAST,      // Fast-mode, up to 400KHz
+	I2C_SPEEDS
+} I2C_SPEED;
+
+typedef struct {
+	const char * name;
+	uint16_t max_khz;    // the speed mode's highest SCL clock
+	uint8_t low_us;      // tLOW
+	uint8_t high_us;     // tHIGH
+	uint8_t start_us;    // tHD;STA
+	uint8_t stop_us;     // tSU;STO
+	uint8_t restart_us;  // tSU;STA, before a repeated START
+	uint8_t buf_us;      // tBUF + tr
+} I2C_TIMING;
 
 // Defines for valid I2C slave device addresses
 #define I2C_ADDRESS_MIN	0x03
@@ -30,15 +58,25 @@
 
 #define DS3231_ADDRESS	0x68	// 7-bit address (does not include I2C R/W bit)
 
+void i2c_delay_us(uint16_t delay_us);
 void soft_i2c_start(void);
 void soft_i2c_stop(void);
 bool soft_i2c_write8(uint8_t data_byte);
 uint8_t soft_i2c_read8(bool ack);
+bool i2c_device_ready(uint8_t i2c_address);
+bool soft_i2c_bus_check(void);
+bool soft_i2c_set_speed(I2C_SPEED speed); // between transactions, false if speed isn't valid
+I2C_SPEED soft_i2c_speed(void);
+const I2C_TIMING * soft_i2c_timing(I2C_SPEED speed);
 int i2c_write_read(uint8_t i2c_address, uint8_t * write_data, uint8_t write_count, uint8_t * read_data, uint8_t read_count);
 
+// Guards the bus - held by i2c_device_ready() and i2c_write_read() for the whole transaction
+extern KMUTEX i2c_bus_mutex;
+
 // Command Line functions
 int cl_i2c_scan(void);
 int cl_i2c_write(void);
 int cl_i2c_read(void);
+int cl_i2c_speed(void);
 
 #endif /* INC_SOFT_I2C_H_ */
@@ -32,6 +32,14 @@
 
 /* Exported types ------------------------------------------------------------*/
 /* USER CODE BEGIN ET */
+// Interrupt sources counted in irq_counts[]
+typedef enum {
+  IRQ_COUNT_SYSTICK,
+  IRQ_COUNT_DMA,
+  IRQ_COUNT_UART,
+  IRQ_COUNT_TIMER,
+  IRQ_COUNT_SOURCES
+} IRQ_COUNT_SOURCE;
 
 /* USER CODE END ET */
 
@@ -53,11 +61,15 @@ void BusFault_Handler(void);
 void UsageFault_Handler(void);
 void SVC_Handler(void);
 void DebugMon_Handler(void);
-void PendSV_Handler(void);
 void SysTick_Handler(void);
 void DMA1_Channel6_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
+void TIM3_IRQHandler(void);
+void TIM4_IRQHandler(void);
+void USART2_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+extern volatile uint32_t irq_counts[IRQ_COUNT_SOURCES]; // interrupts taken, see delaybench.c
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,57 @@
+/*
+ * swtimer.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Software timers - hierarchical timer wheel multiplexed on TIM4
+ *
+ *  TIM4 is the free running 1us counter.  Its compare channels drive the timer wheel:
+ *  - CC1 interrupts at each 1024us "granule" boundary while timers are pending, advancing the wheel
+ *  - CC2 interrupts at the exact (1us resolution) expiry time of timers due in the current granule
+ *  Expiry times are timebase_us32() times (see timebase.h).
+ *
+ *  The wheel has SWTIMER_LEVELS levels of SWTIMER_SLOTS slots.  Each level's slot covers
+ *  SWTIMER_SLOTS times the span of the level below (1.024ms, 32.8ms, 1.05s, 33.6s).  A timer is
+ *  inserted into the slot for its expiry time, and cascades to lower levels as time advances.
+ *  Insert and cancel are O(1), timers are doubly linked.
+ *
+ *  Times are 32-bit microseconds.  Delays (and periods) must be less than 2^31 us (35 minutes).
+ *
+ *  Callbacks run from the TIM4 interrupt - keep them short (set a flag, wake a task, ...).
+ *  A callback may restart or cancel its own timer.
+ */
+
+#ifndef INC_SWTIMER_H_
+#define INC_SWTIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SWTIMER_GRANULE_SHIFT 10  // 1024us per level 0 slot
+#define SWTIMER_SLOT_BITS     5
+#define SWTIMER_SLOTS         (1 << SWTIMER_SLOT_BITS)
+#define SWTIMER_LEVELS        4
+
+typedef void (*SWTIMER_CALLBACK)(void * arg);
+
+typedef struct SWTIMER SWTIMER;
+struct SWTIMER {
+    SWTIMER * next;
+    SWTIMER * prev;
+    SWTIMER ** list;           // list the timer is linked on, NULL when not active
+    uint32_t expires;          // timebase_us32() time to call the callback
+    uint32_t period;           // us, 0: one-shot
+    SWTIMER_CALLBACK callback;
+    void * arg;
+};
+
+void swtimer_start(SWTIMER * timer, uint32_t delay_us, uint32_t period_us, SWTIMER_CALLBACK callback, void * arg);
+void swtimer_cancel(SWTIMER * timer);
+bool swtimer_active(const SWTIMER * timer);
+bool swtimer_pending(void);
+
+// Command Line functions
+int cl_timers(void);
+
+#endif /* INC_SWTIMER_H_ */
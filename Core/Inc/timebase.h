@@ -0,0 +1,101 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Monotonic microsecond timebase - TIM4 chained to TIM3
+ *
+ *  TIM4 counts microseconds.  Its update event is TIM4's trigger output (TRGO), which clocks TIM3
+ *  (slave, external clock mode 1, internal trigger ITR3).  TIM3:TIM4 is a 32-bit hardware count of
+ *  microseconds, wrapping every 71.6 minutes.  The TIM3 update interrupt counts those wraps,
+ *  extending the time to 64 bits.
+ *
+ *  All reads are lock-free (interrupts stay enabled), and safe from any interrupt priority:
+ *  - timebase_cnt16()  TIM4 count, single register read, for intervals up to 65.5ms
+ *  - timebase_us32()   32-bit time, TIM3 read before and after TIM4, repeated if TIM3 changed
+ *  - timebase_us64()   64-bit time, repeated if the overflow count changed
+ *
+ *  Measure an interval by subtracting two reads of the same width, using unsigned arithmetic:
+ *      uint32_t start = timebase_us32();
+ *      ...
+ *      uint32_t elapsed = timebase_us32() - start;
+ *
+ *  With TIMEBASE_SYSTICK 1, for machines without TIM3/TIM4 (the QEMU image, Tools/qemu), the time
+ *  is the HAL's 1ms tick plus the SysTick count down.  The API is the same, still in microseconds,
+ *  but TIM4's compare channels (swtimer.c) aren't available and the time wraps with the tick count,
+ *  after 49.7 days.
+ */
+
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include <stdint.h>
+#include "main.h"   // TIM3, TIM4 registers
+
+#ifndef TIMEBASE_SYSTICK
+#define TIMEBASE_SYSTICK  0
+#endif
+
+extern volatile uint32_t timebase_overflows; // TIM3 wraps, upper 32 bits of timebase_us64()
+
+#if TIMEBASE_SYSTICK
+
+uint64_t timebase_systick_us(void);
+
+static inline uint16_t timebase_cnt16(void)
+{
+    return (uint16_t)timebase_systick_us();
+}
+
+static inline uint32_t timebase_us32(void)
+{
+    return (uint32_t)timebase_systick_us();
+}
+
+static inline uint64_t timebase_us64(void)
+{
+    return timebase_systick_us();
+}
+
+#else
+
+// 16-bit microsecond count
+static inline uint16_t timebase_cnt16(void)
+{
+    return (uint16_t)TIM4->CNT;
+}
+
+// 32-bit microsecond count
+static inline uint32_t timebase_us32(void)
+{
+    uint32_t high, low;
+    do {
+        high = TIM3->CNT;
+        low = TIM4->CNT;
+    } while(high != TIM3->CNT); // TIM4 wrapped between the reads
+    return (high << 16) | low;
+}
+
+// 64-bit microsecond count
+static inline uint64_t timebase_us64(void)
+{
+    uint32_t overflows, high, low;
+    do {
+        overflows = timebase_overflows;
+        low = timebase_us32();
+        high = overflows;
+        // A wrap may be pending (interrupts disabled, or read from a higher priority interrupt)
+        if((TIM3->SR & TIM_SR_UIF) && low < 0x80000000UL) high++;
+    } while(overflows != timebase_overflows); // wrap counted between the reads
+    return ((uint64_t)high << 32) | low;
+}
+
+#endif /* TIMEBASE_SYSTICK */
+
+void timebase_init(void);
+void timebase_advance(uint32_t us);
+void timebase_set_clock(uint32_t timer_hz);
+void timebase_overflow_irq(void);
+
+#endif /* INC_TIMEBASE_H_ */
@@ -0,0 +1,109 @@
+/*
+ * acquire.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Periodic data acquisition task - see acquire.h
+ *
+ *  The task uses kernel_delay_until() for a jitter free period.  Wake latency (time between
+ *  the SysTick making the task READY and the task running) is recorded to show the
+ *  acquisition isn't delayed by the command line.
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include <string.h>
+#include "acquire.h"
+#include "kernel.h"
+#include "ringbuf.h"
+#include "soft_i2c.h"
+#include "command_line.h"
+#include "main.h"   // HAL_GetTick()
+#include "timebase.h"
+
+static uint32_t acq_stack[ACQ_STACK_WORDS];
+static KTASK acq_ktask;
+
+static volatile uint32_t acq_period_ms = ACQ_DEFAULT_PERIOD;
+static ACQ_SAMPLE acq_last;
+// Captured samples, acq task is the producer, "acq dump" is the consumer
+static uint8_t acq_sample_buffer[ACQ_SAMPLE_BUFFER_SIZE];
+static RINGBUF acq_samples_rb;
+static uint32_t acq_samples;
+static uint32_t acq_overruns;      // sample time missed
+static uint32_t acq_latency_last;  // us
+static uint32_t acq_latency_max;   // us
+
+static void acq_task(void * arg)
+{
+    (void)arg;
+    uint32_t last_wake = HAL_GetTick();
+    while(1) {
+        uint32_t period = acq_period_ms;
+        if(!period) {
+            kernel_delay(100); // stopped, check again later
+            last_wake = HAL_GetTick();
+            continue;
+        }
+        uint32_t expected = last_wake + period;
+        kernel_delay_until(&last_wake, period);
+        if(last_wake != expected)
+            acq_overruns++;
+        else {
+            uint32_t latency = timebase_us32() - acq_ktask.wake_us;
+            acq_latency_last = latency;
+            if(latency > acq_latency_max) acq_latency_max = latency;
+        }
+        // Read DS3231 seconds, minutes, hours registers
+        uint8_t reg = 0;
+        uint8_t data[3];
+        i2c_write_read(DS3231_ADDRESS, &reg, sizeof(reg), data, sizeof(data));
+        acq_last.seconds = data[0];
+        acq_last.minutes = data[1];
+        acq_last.hours = data[2];
+        acq_samples++;
+        // Capture the sample, whole samples only
+        if(ringbuf_free(&acq_samples_rb) >= sizeof(ACQ_SAMPLE))
+            ringbuf_write(&acq_samples_rb, (const uint8_t *)&acq_last, sizeof(ACQ_SAMPLE));
+        else
+            acq_samples_rb.overflows++;
+    }
+}
+
+void acq_init(void)
+{
+    ringbuf_init(&acq_samples_rb, acq_sample_buffer, ACQ_SAMPLE_BUFFER_SIZE);
+    kernel_task_create(&acq_ktask, "acq", acq_task, NULL, acq_stack, ACQ_STACK_WORDS, KERNEL_PRIORITY_ACQ);
+}
+
+// acq [period ms] - set acquisition period (0 stops), display acquisition status
+// acq dump - display (and remove) captured samples
+int cl_acq(void)
+{
+    if(!kernel_running()) {
+        printf("Kernel not running\n");
+        return 1;
+    }
+    if(argc > 1 && strcmp(argv[1], "dump") == 0) {
+        ACQ_SAMPLE sample;
+        unsigned count = 0;
+        while(ringbuf_read(&acq_samples_rb, (uint8_t *)&sample, sizeof(sample)) == sizeof(sample)) {
+            printf("%02X:%02X:%02X%s", sample.hours, sample.minutes, sample.seconds, (++count % 8) ? " " : "\n");
+        }
+        printf("\n%u samples, %lu dropped\n", count, acq_samples_rb.overflows);
+        return 0;
+    }
+    if(argc > 1) {
+        acq_period_ms = (uint32_t) strtol(argv[1], NULL, 0);
+        acq_latency_max = 0;
+        acq_overruns = 0;
+    }
+    printf("Period: %lu ms, samples: %lu, overruns: %lu\n", acq_period_ms, acq_samples, acq_overruns);
+    printf("Wake latency: %lu us, max %lu us\n", acq_latency_last, acq_latency_max);
+    printf("Last sample: %02X:%02X:%02X\n", acq_last.hours, acq_last.minutes, acq_last.seconds);
+    printf("I2C bus mutex contentions: %lu\n", i2c_bus_mutex.contentions);
+    printf("Captured: %u samples, high water %u, dropped %lu\n", ringbuf_count(&acq_samples_rb) / sizeof(ACQ_SAMPLE),
+            acq_samples_rb.high_water / sizeof(ACQ_SAMPLE), acq_samples_rb.overflows);
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * boot.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Boot time profile, and fast start to the first prompt - see boot.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "boot.h"
+#include "dwt.h"
+#include "sched.h"
+#include "soft_i2c.h"
+#include "command_line.h"
+#include "version.h"
+#include "main.h"   // HAL functions and defines for RCC access
+
+#define BOOT_NOT_REACHED  UINT32_MAX
+
+typedef struct {
+    uint32_t magic;
+    uint32_t boots;             // since power on
+    uint32_t reset_flags;       // RCC_CSR
+    uint32_t us[BOOT_STAGE_COUNT]; // end of each stage, from the start of main()
+} BOOT_RECORD;
+
+// [0] this boot, [1] the previous boot - not initialized by the startup code
+__attribute__((section(".noinit"))) static BOOT_RECORD boot_records[2];
+
+#define BOOT_NAME_X(id, name) name,
+static const char * const stage_names[] = {
+    BOOT_STAGES(BOOT_NAME_X)
+};
+
+static uint32_t boot_cycles;    // cycle count at the last mark
+static uint32_t boot_us;        // time of the last mark
+static uint32_t boot_mhz;       // CPU clock since the last mark
+static bool i2c_bus_ok = true;
+
+void boot_start(void)
+{
+    boot_cycles = dwt_cycles();
+    boot_mhz = SystemCoreClock / 1000000;
+    BOOT_RECORD * boot = &boot_records[0];
+    if(boot->magic == BOOT_MAGIC) {
+        boot_records[1] = *boot;
+        boot->boots++;
+    } else {
+        boot_records[1].magic = 0;
+        boot->magic = BOOT_MAGIC;
+        boot->boots = 1;
+    }
+    boot->reset_flags = RCC->CSR;
+    RCC->CSR |= RCC_CSR_RMVF; // clear the reset flags for the next boot
+    for(int i=0;i<BOOT_STAGE_COUNT;i++) boot->us[i] = BOOT_NOT_REACHED;
+}
+
+void boot_mark(BOOT_STAGE stage)
+{
+    uint32_t now = dwt_cycles();
+    boot_us += (now - boot_cycles) / boot_mhz;
+    boot_cycles = now;
+    boot_mhz = SystemCoreClock / 1000000;
+    boot_records[0].us[stage] = boot_us;
+}
+
+static void boot_greeting(void)
+{
+    // Turn on yellow text, print greeting, reset attributes
+    printf("\n" COLOR_YELLOW "Command Line parser, %s, %s" COLOR_RESET "\n",szversion,__DATE__);
+    printf(COLOR_YELLOW "Enter \"help\" or \"?\" for list of commands" COLOR_RESET "\n");
+    boot_mark(BOOT_STAGE_GREETING);
+}
+
+static void boot_i2c_check(void)
+{
+    i2c_bus_ok = soft_i2c_bus_check();
+    boot_mark(BOOT_STAGE_I2C_CHECK);
+}
+
+// Non-critical initialization
+static void boot_deferred(void)
+{
+    boot_i2c_check();
+    boot_greeting();
+    if(!i2c_bus_ok) printf("I2C bus stuck - SCL or SDA held low\n");
+    boot_mark(BOOT_STAGE_DEFERRED);
+}
+
+static void boot_prompt(void)
+{
+    printf("\n>");
+    fflush(stdout);
+    boot_mark(BOOT_STAGE_PROMPT);
+}
+
+#if BOOT_FAST_START
+// Runs on the first scheduler pass, the command line is already taking input
+static int boot_task(TASK * task)
+{
+    (void)task;
+    boot_deferred();
+    printf(">"); // prompt again, after the greeting
+    return TASK_RC_DONE;
+}
+#endif
+
+void boot_finish(void)
+{
+#if BOOT_FAST_START
+    boot_prompt();
+    sched_start("boot", boot_task, NULL, false);
+#else
+    boot_deferred();
+    boot_prompt();
+#endif
+}
+
+static void boot_print(const BOOT_RECORD * boot)
+{
+    static const struct {
+        uint32_t flag;
+        const char * name;
+    } causes[] = {
+        {RCC_CSR_LPWRRSTF, "low power"}, {RCC_CSR_WWDGRSTF, "window watchdog"},
+        {RCC_CSR_IWDGRSTF, "watchdog"}, {RCC_CSR_SFTRSTF, "software"},
+        {RCC_CSR_PORRSTF, "power on"}, {RCC_CSR_PINRSTF, "NRST pin"},
+    };
+    printf("Boot %lu, reset:", boot->boots);
+    for(unsigned i=0;i<sizeof(causes)/sizeof(causes[0]);i++) {
+        if(boot->reset_flags & causes[i].flag) printf(" %s", causes[i].name);
+    }
+    printf("\nStage                    End us   Stage us\n");
+    // In the order reached - with BOOT_FAST_START, the prompt comes before the deferred stages
+    uint32_t last = 0;
+    bool shown[BOOT_STAGE_COUNT] = {0};
+    for(int n=0;n<BOOT_STAGE_COUNT;n++) {
+        int next = -1;
+        for(int i=0;i<BOOT_STAGE_COUNT;i++) {
+            if(!shown[i] && boot->us[i] != BOOT_NOT_REACHED && (next < 0 || boot->us[i] < boot->us[next]))
+                next = i;
+        }
+        if(next < 0) break;
+        shown[next] = true;
+        printf("%-20s  %9lu  %9lu\n", stage_names[next], boot->us[next], boot->us[next] - last);
+        last = boot->us[next];
+    }
+}
+
+// boot [prev] - boot time profile of this (or the previous) boot
+int cl_boot(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"prev")) {
+        if(boot_records[1].magic != BOOT_MAGIC) {
+            printf("No previous boot recorded (power on)\n");
+            return 1;
+        }
+        boot_print(&boot_records[1]);
+        return 0;
+    }
+    boot_print(&boot_records[0]);
+    printf("Fast start: %s\n", BOOT_FAST_START ? "on" : "off (BOOT_FAST_START, boot.h)");
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * clock.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  System clock profiles - see clock.h
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include "clock.h"
+#include "timebase.h"
+#include "command_line.h"
+#include "main.h"   // HAL functions and defines for RCC, UART access
+
+extern UART_HandleTypeDef huart2; // main.c
+
+static const CLOCK_PROFILE profiles[] = {
+    { 8, 0,             RCC_HCLK_DIV1, FLASH_LATENCY_0},
+    {24, RCC_PLL_MUL3,  RCC_HCLK_DIV1, FLASH_LATENCY_0},
+    {48, RCC_PLL_MUL6,  RCC_HCLK_DIV2, FLASH_LATENCY_1},
+    {72, RCC_PLL_MUL9,  RCC_HCLK_DIV2, FLASH_LATENCY_2},
+};
+#define CLOCK_PROFILES (sizeof(profiles) / sizeof(profiles[0]))
+
+static int current = CLOCK_PROFILE_DEFAULT;
+
+// Program the RCC for a profile.  SYSCLK moves to the HSE while the PLL is reconfigured.
+static bool clock_configure(const CLOCK_PROFILE * p)
+{
+    RCC_OscInitTypeDef osc = {0};
+    RCC_ClkInitTypeDef clk = {0};
+
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSE; // HSE is off after stop mode
+    osc.HSEState = RCC_HSE_BYPASS;
+    osc.HSEPredivValue = RCC_HSE_PREDIV_DIV1;
+    osc.PLL.PLLState = RCC_PLL_NONE;
+    if(HAL_RCC_OscConfig(&osc) != HAL_OK) return false;
+
+    clk.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK|RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
+    clk.SYSCLKSource = RCC_SYSCLKSOURCE_HSE;
+    clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+    clk.APB1CLKDivider = RCC_HCLK_DIV1;
+    clk.APB2CLKDivider = RCC_HCLK_DIV1;
+    if(HAL_RCC_ClockConfig(&clk, FLASH_LATENCY_0) != HAL_OK) return false;
+
+    osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+    if(p->pll_mul) {
+        osc.PLL.PLLState = RCC_PLL_ON;
+        osc.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+        osc.PLL.PLLMUL = p->pll_mul;
+    } else {
+        osc.PLL.PLLState = RCC_PLL_OFF;
+    }
+    if(HAL_RCC_OscConfig(&osc) != HAL_OK) return false;
+
+    clk.SYSCLKSource = p->pll_mul ? RCC_SYSCLKSOURCE_PLLCLK : RCC_SYSCLKSOURCE_HSE;
+    clk.APB1CLKDivider = p->apb1_div;
+    return HAL_RCC_ClockConfig(&clk, p->flash_latency) == HAL_OK;
+}
+
+// TIM2-7 run at PCLK1, doubled when the APB1 prescaler isn't 1
+uint32_t clock_apb1_timer_hz(void)
+{
+    uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+    return (RCC->CFGR & RCC_CFGR_PPRE1) == RCC_HCLK_DIV1 ? pclk1 : pclk1 * 2;
+}
+
+// Switch to a profile (index into profiles[]), returns false if the clocks failed to start
+bool clock_set_profile(int profile)
+{
+    if(profile < 0 || profile >= (int)CLOCK_PROFILES) return false;
+    uart_tx_flush(); // the baud rate is about to change
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool ok = clock_configure(&profiles[profile]);
+    if(ok) current = profile;
+    else clock_configure(&profiles[current]); // back to the previous profile
+    timebase_set_clock(clock_apb1_timer_hz());
+    huart2.Instance->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), huart2.Init.BaudRate);
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+// Stop mode leaves the HSI as the system clock, the peripherals are still set for the profile
+void clock_restore(void)
+{
+    clock_configure(&profiles[current]);
+}
+
+const CLOCK_PROFILE * clock_profile(void)
+{
+    return &profiles[current];
+}
+
+// clock [MHz] - list clock profiles, or switch to one
+int cl_clock(void)
+{
+    if(argc > 1) {
+        int mhz = (int) strtol(argv[1], NULL, 0);
+        int profile;
+        for(profile=0;profile<(int)CLOCK_PROFILES;profile++) {
+            if(profiles[profile].mhz == mhz) break;
+        }
+        if(profile == (int)CLOCK_PROFILES) {
+            printf("No %d MHz profile\n",mhz);
+            return 1;
+        }
+        uint32_t start = timebase_us32();
+        if(!clock_set_profile(profile)) {
+            printf("Clock switch failed\n");
+            return 1;
+        }
+        printf("Switched in %lu us\n", timebase_us32() - start);
+    }
+    printf("  HCLK MHz  PCLK1 MHz  Flash\n");
+    for(int i=0;i<(int)CLOCK_PROFILES;i++) {
+        const CLOCK_PROFILE * p = &profiles[i];
+        unsigned pclk1 = p->apb1_div == RCC_HCLK_DIV1 ? p->mhz : p->mhz / 2;
+        printf("%c %8u  %9u  %lu ws\n", i == current ? '*' : ' ', p->mhz, pclk1, p->flash_latency);
+    }
+    printf("SystemCoreClock: %lu Hz, TIM4 prescaler %lu\n", SystemCoreClock, TIM4->PSC + 1);
+    return 0;
+}
@@ -9,8 +9,9 @@
 // Since no arguments are passed in the function call, all commands will have int command_name(void) prototype.
 
 // Notes:
-// The stdio library's stdout stream is buffered by default.  This makes printf() and putchar() work strangely
-// for character I/O.  Buffering needs to be disabled for this code module.  See setvbuf() in cl_setup().
+// The stdio library's stdout stream is fully buffered by default, so echoed characters and the prompt
+// wouldn't appear.  cl_setup() makes it line buffered (static buffer, see setvbuf()), and sched_run()
+// flushes partial lines (prompt, echo) each pass.  stdin is unbuffered.
 
 #include <stdio.h> // printf()
 #include <string.h>
@@ -19,7 +20,25 @@
 #include "command_line.h"
 #include "main.h"   // HAL functions and defines
 #include "soft_i2c.h"
+#include "sched.h"
+#include "kernel.h"
+#include "acquire.h"
 #include "version.h"
+#include "timebase.h"
+#include "dwt.h"
+#include "power.h"
+#include "clock.h"
+#include "i2cbench.h"
+#include "i2c_trace.h"
+#include "i2c_txtrace.h"
+#include "i2c_stats.h"
+#include "prof.h"
+#include "pcsample.h"
+#include "latency.h"
+#include "mem.h"
+#include "pool.h"
+#include "boot.h"
+#include "delaybench.h"
 
 
 // Typedefs
@@ -42,14 +61,96 @@ const COMMAND_ITEM cmd_table[] = {
     {"info",      "processor info",                               1, cl_info},
     {"reset",     "reset processor",                              1, cl_reset},
 	{"version",   "display version",                              1, cl_version},
-    {"timer",     "timer test - testing 50ms delay",              1, cl_timer},
-//	{"delaytest", "test microsecond delays",                      1, cl_timer_delay_test},
+	{"time",      "time <command> [args] - time one command",     2, cl_time},
+	{"cmdstats",  "cmdstats [clear] - command execution times",   1, cl_cmdstats},
+	{"repeat",    "repeat [-q] <n> <command...> - run n times",   3, cl_repeat},
+	{"every",     "every [-q] <ms> <command...> - run each ms",   3, cl_every},
+    {"timer",     "timer [ms] - time HAL_Delay(), default 50ms",  1, cl_timer},
+	{"delaytest", "test microsecond delays",                      1, cl_timer_delay_test},
+	{"delaybench","delaybench [samples] [hist] - delay accuracy", 1, cl_delay_bench},
+	{"jobs",      "list running tasks",                           1, cl_jobs},
+	{"kill",      "kill <job> - cancel a running task",           2, cl_kill},
+	{"ps",        "list kernel tasks with stack usage",           1, cl_ps},
+	{"boot",      "boot [prev] - boot time profile",              1, cl_boot},
+	{"mem",       "RAM usage: data, heap, stack peak, free",      1, cl_mem},
+	{"pool",      "pool [bench] - block allocator statistics",    1, cl_pool},
+	{"acq",       "acq [ms|dump] - periodic DS3231 acquisition",  1, cl_acq},
+	{"uart",      "UART ring buffer statistics",                  1, cl_uart},
+	{"timers",    "timers [us] [period] - software timer stats",  1, cl_timers},
+	{"power",     "power [run|sleep|stop|clear] - idle mode",     1, cl_power},
+	{"clock",     "clock [MHz] - list or select clock profile",   1, cl_clock},
+	{"prof",      "prof [clear] - function cycle profile",        1, cl_prof},
+	{"latency",   "latency [clear|budget <us> [log|assert]]",     1, cl_latency},
+	{"pcsample",  "pcsample [start [Hz]|stop|dump] - PC sampling", 1, cl_pcsample},
 	{"i2cscan",   "scan i2c bus for connected devices",           1, cl_i2c_scan},
 	{"i2cwrite",  "test - write 0 to DS3231",                     1, cl_i2c_write},
 	{"i2cread",   "test - read byte from DS3231",                 1, cl_i2c_read},
+	{"i2ctrace",  "i2ctrace [clear|vcd|raw] - dump edge trace",   1, cl_i2c_trace},
+	{"i2ctx",     "i2ctx [clear|dump] - I2C transaction trace",   1, cl_i2c_txtrace},
+	{"i2cstats",  "i2cstats [clear|bin] - I2C bus/device stats",  1, cl_i2c_stats},
+	{"i2cbench",  "i2cbench <mode> [addr] [len] [n|<n>ms] [csv]", 1, cl_i2c_bench},
+	{"i2cspeed",  "i2cspeed [standard|fast] - I2C bus speed",     1, cl_i2c_speed},
 
     {NULL,NULL,0,NULL}, /* end of table */
 };
+#define CMD_TABLE_SIZE (sizeof(cmd_table) / sizeof(cmd_table[0]))
+
+// Execution time of each command, indexed as cmd_table[].  The time runs until the prompt is
+// displayed again, so includes a foreground task started by the command.  Cycles are for the
+// command function itself (the 32-bit cycle count would wrap in a long running task).
+typedef struct {
+    uint32_t runs;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t last_cycles;
+    uint32_t min_cycles;
+} CMD_STATS;
+
+// A command being timed
+typedef struct {
+    int index;          // cmd_table[] index, -1: none
+    int report;         // cmd_table[] index run by "time", its duration is displayed when done
+    uint32_t start_us;
+    uint32_t cycles;
+    TASK * task;        // foreground task started by the command
+    uint8_t task_id;    // job number of the task (its slot may be reused)
+    bool wait_any;      // batch command: its task is waited for, even in the background
+} CMD_TIMING;
+
+static CMD_STATS cmd_stats[CMD_TABLE_SIZE];
+static CMD_TIMING cl_timing = {-1, -1};  // command entered at the prompt
+static int cmd_time_index = -1; // set by "time", while its command runs
+static TASK * cl_started;       // task started by the command running, see cl_start_task()
+
+// Commands run by "repeat", "every" and ';' separated lines, see cl_batch_task()
+typedef struct {
+    char buf[MAXSERIALBUF];     // the commands' words, see cl_batch_start()
+    char * words[CL_BATCH_MAX_WORDS]; // into buf[], NULL: end of a command
+    int nwords;
+    int next;                   // next word of words[]
+    uint32_t count;             // iterations, 0: until cancelled
+    uint32_t period_us;         // "every": iterations start this far apart, 0: back to back
+    bool quiet;                 // discard command output
+    bool background;            // start command tasks in the background
+    bool running;               // results not yet reported
+    uint32_t runs;
+    uint32_t start_us;          // first iteration
+    uint32_t run_start_us;      // current iteration
+    uint32_t due_us;            // "every": start of the next iteration
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t late;              // "every": iterations that overran the period
+    uint32_t wait_us;           // "every": until the next iteration
+    CMD_TIMING timing;
+} CL_BATCH;
+
+static CL_BATCH batch;
+
+static void cl_command_done(CMD_TIMING * timing);
+static void cl_batch_report(void);
+static int cl_batch_task(TASK * task);
 
 // Globals:
 char cmd_buffer[MAXSERIALBUF]; // holds command strings from user
@@ -60,91 +161,411 @@ int argc; // number of words (command & arguments)
 const VERSION_MAJOR_MINOR fw_version = {VERSION_MAJOR,VERSION_MINOR,VERSION_BUILD};
 char szversion[16];
 
+static bool cl_waiting;    // command line is waiting for a foreground task to complete
+static bool cl_background; // command line ended with "&", start task(s) in the background
+
+// The command line runs as a task, so it keeps running along side long running commands
+static int cl_task(TASK * task)
+{
+    (void)task;
+    if(!cl_loop())
+        return TASK_RC_IDLE; // no input - nothing to do until a character is received
+    return TASK_RC_YIELD; // never completes
+}
+
 void cl_setup(void) {
-    // The STM32 development environment's stdio library provides buffering of stdout stream by default.  Turn it off!
-    setvbuf(stdout, NULL, _IONBF, 0);
+    // The STM32 development environment's stdio library allocates stdout's buffer from the heap
+    // by default.  Use a static line buffer instead - sched_run() flushes partial lines (prompt,
+    // echo) each pass.  (Unbuffered, newlib's printf() formats into a 1KB buffer on the stack.)
+    // stdin isn't used (see __io_getchar()), unbuffered it never allocates one.
+    static char stdout_buffer[CL_STDOUT_BUFFER_SIZE];
+    setvbuf(stdout, stdout_buffer, _IOLBF, sizeof(stdout_buffer));
+    setvbuf(stdin, NULL, _IONBF, 0);
     // Write version string
     sprintf(szversion,"Ver %u.%u.%u",fw_version.major,fw_version.minor,fw_version.build);
-    // Turn on yellow text, print greeting, reset attributes
-    printf("\n" COLOR_YELLOW "Command Line parser, %s, %s" COLOR_RESET "\n",szversion,__DATE__);
-    printf(COLOR_YELLOW "Enter \"help\" or \"?\" for list of commands" COLOR_RESET "\n");
-    __io_putchar('>'); // initial prompt
+    // The greeting and initial prompt are displayed by boot_finish() (boot.h)
+    sched_start("cli", cl_task, NULL, false); // first task started, slot 0
+}
+
+// Start a command's task.  Unless the command line ended with "&", the task runs in the
+// foreground: the prompt isn't displayed until it completes, and Ctrl-C cancels it.
+TASK * cl_start_task(const char * name, TASK_FUNC function, void * ctx)
+{
+    if(sched_find(function)) {
+        printf("\"%s\" is already running\n",name);
+        return NULL;
+    }
+    TASK * task = sched_start(name, function, ctx, !cl_background);
+    cl_started = task;
+    if(task && cl_background)
+        printf("[%u] %s\n",task->id,name);
+    return task;
 }
 
 // Externals
 int __io_getchar(void);   // main.c
 int __io_putchar(int ch); // main.c
 
-// Check for data available from USART interface.  If none present, just return.
-// If data available, process it (add it to character buffer if appropriate)
-void cl_loop(void)
+// Check for data available from USART interface.  If none present, just return false.
+// If data available, process it (add it to character buffer if appropriate), and return true
+// While a foreground task is running, characters are still echoed and collected (type-ahead).
+// A completed line is held until the task completes.  Ctrl-C cancels the foreground task.
+bool cl_loop(void)
 {
     static int index = 0; // index into global buffer
+    static bool line_ready = false; // line entered while waiting on foreground task
     int c;
 
+    if(batch.running && !sched_find(cl_batch_task))
+        cl_batch_report(); // cancelled
+    if(cl_waiting && !sched_foreground()) {
+        // Foreground task completed or was cancelled - display prompt and any type-ahead
+        cl_waiting = false;
+        cl_command_done(&cl_timing);
+        cmd_buffer[index] = 0;
+        printf("\n>%s",line_ready ? "" : cmd_buffer);
+    }
+
     // Spin, reading characters until EOF character is received (no data), buffer is full, or
     // a <line feed> character is received.  Null terminate the global string, don't return the <LF>
     while(1) {
+      if(line_ready && !cl_waiting) {
+          // Process the line entered while the foreground task was running
+          line_ready = false;
+          printf("%s\n",cmd_buffer);
+          cl_process_buffer();
+          cl_waiting = (sched_foreground() != NULL);
+          if(!cl_waiting) printf("\n>");
+          index = 0;
+          return true;
+      }
       c = __io_getchar();
       switch(c) {
           case EOF:
-              return; // non-blocking - return
+              return false; // non-blocking - return, no more input
+          case _CTRL_C:
+              // Cancel foreground task, discard any type-ahead
+              printf("^C");
+              index = 0;
+              line_ready = false;
+              if(cl_waiting)
+                  sched_cancel_foreground(); // prompt is displayed once the task is released
+              else
+                  printf("\n>");
+              return true;
           case _CR:
           case _LF:
+              if(line_ready) continue; // already holding a line
         	  cmd_buffer[index] = 0; // null terminate
+              if(cl_waiting) {
+                  if(index) line_ready = true; // hold until foreground task completes
+                  continue;
+              }
             if(index) {
         		putchar(_LF); // newline
             	cl_process_buffer(); // process the null terminated buffer
+            	cl_waiting = (sched_foreground() != NULL);
             }
-    		printf("\n>");
+            if(!cl_waiting) printf("\n>");
             index = 0; // reset buffer index
-            return;
+            return true;
           case _BS:
-            if(index<1) continue;
+            if(index<1 || line_ready) continue;
             printf("\b \b"); // remove the previous character from the screen and buffer
             index--;
             break;
           default:
-        	if(index<(MAXSERIALBUF - 1) && c >= ' ' && c <= '~') {
+        	if(!line_ready && index<(MAXSERIALBUF - 1) && c >= ' ' && c <= '~') {
 				putchar(c); // write character to terminal
 				cmd_buffer[index] = (char)c;
 				index++;
         	}
       } // switch
   } // while(1)
-  return;
+  return true;
+}
+
+// Record a command's execution time, once the prompt is about to be displayed
+static void cl_command_done(CMD_TIMING * timing)
+{
+    if(timing->index < 0) return;
+    uint32_t us = timebase_us32() - timing->start_us;
+    CMD_STATS * stats = &cmd_stats[timing->index];
+    stats->last_us = us;
+    if(us > stats->max_us) stats->max_us = us;
+    stats->total_us += us;
+    stats->last_cycles = timing->cycles;
+    if(!stats->runs || timing->cycles < stats->min_cycles) stats->min_cycles = timing->cycles;
+    stats->runs++;
+    if(timing->report >= 0)
+        printf("%s: %lu us, %lu cycles\n", cmd_table[timing->report].command, us, timing->cycles);
+    timing->index = timing->report = -1;
+    timing->task = NULL;
+}
+
+// True while the foreground task started by a command is running
+static bool cl_command_busy(const CMD_TIMING * timing)
+{
+    const TASK * task = timing->task;
+    return task && (task->flags & TASK_FLAG_ACTIVE) && task->id == timing->task_id;
+}
+
+// Call the function associated with the command, timing it
+static void cl_execute(int index, CMD_TIMING * timing)
+{
+    timing->start_us = timebase_us32();
+    cl_started = NULL;
+    uint32_t start = dwt_cycles();
+    PROF_ENTER(CL_COMMAND);
+    (*cmd_table[index].function)();
+    PROF_EXIT(CL_COMMAND);
+    timing->cycles = dwt_cycles() - start;
+    timing->index = cmd_time_index >= 0 ? cmd_time_index : index; // "time" is charged to its command
+    timing->report = cmd_time_index;
+    cmd_time_index = -1;
+    timing->task = (cl_started && (timing->wait_any || (cl_started->flags & TASK_FLAG_FOREGROUND))) ?
+            cl_started : NULL;
+    timing->task_id = timing->task ? timing->task->id : 0;
+    if(!timing->task) cl_command_done(timing);
+}
+
+// Look up argv[0] in the command table, and run it
+static void cl_run_command(CMD_TIMING * timing)
+{
+    // See if command has a match in the command table
+    // If null function pointer found, exit for-loop
+    int cmdIndex;
+    for (cmdIndex = 0; cmd_table[cmdIndex].function; cmdIndex++) {
+        if (strcmp(argv[0], cmd_table[cmdIndex].command) == 0) {
+            // We found a match in the table
+            // Enough arguments?
+            if (argc < cmd_table[cmdIndex].arg_cnt) {
+                printf("\r\nInvalid Arg cnt: %d Expected: %d\n", argc - 1,
+                        cmd_table[cmdIndex].arg_cnt - 1);
+                break;
+            }
+            cl_execute(cmdIndex, timing);
+            break; // exit for-loop
+        }
+    } // for-loop
+      // If we compared all the command strings and didn't find the command, or we want to fake that event
+    if (!cmd_table[cmdIndex].command) {
+        printf("Command \"%s\" not found\r\n", argv[0]);
+    }
+}
+
+// True if argv[i] was double quoted at the prompt - the parser leaves the opening quote
+static bool cl_quoted(int i)
+{
+    return argv[i] > cmd_buffer && argv[i] < cmd_buffer + sizeof(cmd_buffer) && argv[i][-1] == '"';
+}
+
+// Add a word (NULL: end of a command) to the batch, returns false if words[] is full
+static bool cl_batch_add(char * word)
+{
+    if(batch.nwords >= CL_BATCH_MAX_WORDS) return false;
+    batch.words[batch.nwords++] = word;
+    return true;
+}
+
+// Start the batch task, running argv[first] onwards (';' separated commands)
+static void cl_batch_start(const char * name, int first, uint32_t count, uint32_t period_us, bool quiet)
+{
+    TASK * running = sched_find(cl_batch_task);
+    if(running) {
+        printf("\"%s\" is already running\n", running->name);
+        return;
+    }
+    // Keep the words as parsed (re-joining them would lose the quotes), splitting unquoted
+    // words at each ';'
+    char * out = batch.buf;
+    batch.nwords = 0;
+    for(int i=first;i<argc;i++) {
+        size_t len = strlen(argv[i]) + 1;
+        if(out + len > batch.buf + sizeof(batch.buf)) break;
+        char * word = memcpy(out, argv[i], len);
+        out += len;
+        if(cl_quoted(i)) {
+            if(!cl_batch_add(word)) break;
+            continue;
+        }
+        char * semi;
+        while((semi = strchr(word, ';'))) {
+            *semi = 0;
+            if(*word && !cl_batch_add(word)) break;
+            if(!cl_batch_add(NULL)) break;
+            word = semi + 1;
+        }
+        if(*word) cl_batch_add(word);
+    }
+    batch.count = count;
+    batch.period_us = period_us;
+    batch.quiet = quiet;
+    batch.background = cl_background;
+    batch.runs = batch.late = batch.max_us = 0;
+    batch.min_us = UINT32_MAX;
+    batch.total_us = 0;
+    batch.timing.index = batch.timing.report = -1;
+    batch.running = true;
+    if(!cl_start_task(name, cl_batch_task, &batch))
+        batch.running = false;
+}
+
+// Point argv[] at the batch's next command, returns false at the end of the line
+static bool cl_batch_next(CL_BATCH * b)
+{
+    while(b->next < b->nwords) {
+        argc = 0;
+        for(;b->next < b->nwords && b->words[b->next];b->next++) {
+            if(argc < MAXWORDS) argv[argc++] = b->words[b->next];
+        }
+        b->next++; // past the end of the command
+        // A batch started with "&" starts its tasks in the background, but still waits for each
+        // to complete.  A command ending with "&" isn't waited for.
+        cl_background = b->background;
+        b->timing.wait_any = true;
+        if(argc > 1 && !strcmp(argv[argc - 1], "&")) {
+            argc--;
+            cl_background = true;
+            b->timing.wait_any = false;
+        }
+        if(argc) return true;
+    }
+    return false;
+}
+
+// Iteration complete, returns the time to wait until the next one
+static uint32_t cl_batch_end_run(CL_BATCH * b)
+{
+    uint32_t now = timebase_us32();
+    uint32_t us = now - b->run_start_us;
+    if(us < b->min_us) b->min_us = us;
+    if(us > b->max_us) b->max_us = us;
+    b->total_us += us;
+    b->runs++;
+    if(!b->period_us) return 0;
+    b->due_us += b->period_us; // period_us < 2^31, see CL_EVERY_MAX_MS
+    if((int32_t)(b->due_us - now) > 0) return b->due_us - now;
+    b->late++;
+    b->due_us = now; // start again from now, don't try to catch up
+    return 0;
+}
+
+// -q: only the batch's commands are quiet, and the tasks they start (see sched_start()).  The
+// output so far goes out (or is discarded) first.
+static void cl_batch_quiet(TASK * task, bool quiet)
+{
+    fflush(stdout);
+    if(quiet)
+        task->flags |= TASK_FLAG_QUIET;
+    else
+        task->flags &= ~TASK_FLAG_QUIET;
+}
+
+// Run the batch's commands, one after another, waiting for the task a command starts to complete
+static int cl_batch_task(TASK * task)
+{
+    CL_BATCH * b = task->ctx;
+    TASK_BEGIN(task);
+    b->start_us = b->due_us = timebase_us32();
+    while(!b->count || b->runs < b->count) {
+        b->run_start_us = timebase_us32();
+        b->next = 0;
+        while(cl_batch_next(b)) {
+            cl_batch_quiet(task, b->quiet);
+            cl_run_command(&b->timing);
+            cl_batch_quiet(task, false);
+            TASK_WAIT_UNTIL(task, !cl_command_busy(&b->timing));
+            cl_batch_quiet(task, b->quiet);
+            cl_command_done(&b->timing); // "time" report
+            cl_batch_quiet(task, false);
+        }
+        b->wait_us = cl_batch_end_run(b);
+        if(b->wait_us)
+            TASK_SLEEP(task, b->wait_us);
+        else
+            TASK_YIELD(task); // let Ctrl-C through
+    }
+    cl_batch_report();
+    TASK_END(task);
+}
+
+// Display the aggregate timing of "repeat" and "every"
+static void cl_batch_report(void)
+{
+    batch.running = false;
+    if(batch.count == 1 || !batch.runs) return; // ';' separated line
+    uint32_t elapsed_us = timebase_us32() - batch.start_us;
+    printf("%lu runs in %lu us: min %lu, mean %lu, max %lu us per run", batch.runs, elapsed_us,
+            batch.min_us, (uint32_t)(batch.total_us / batch.runs), batch.max_us);
+    if(batch.period_us) printf(", %lu overran the period", batch.late);
+    printf("\n");
+}
+
+// True if any unquoted word contains a ';'
+static bool cl_has_separator(void)
+{
+    for(int i=0;i<argc;i++) {
+        if(!cl_quoted(i) && strchr(argv[i], ';')) return true;
+    }
+    return false;
 }
 
 void cl_process_buffer(void)
 {
     argc = cl_parseArgcArgv(cmd_buffer, argv, MAXWORDS);
+    // A trailing "&" runs the command's task in the background
+    cl_background = false;
+    if (argc > 1 && strcmp(argv[argc - 1], "&") == 0) {
+        argc--;
+        cl_background = true;
+    }
     // Display each of the "words" / command and arguments
     //for(int i=0;i<argc;i++)
     //  printf("%d >%s<\n",i,argv[i]);
-    if (argc) {
-        // At least one "word" / argument found
-        // See if command has a match in the command table
-        // If null function pointer found, exit for-loop
-        int cmdIndex;
-        for (cmdIndex = 0; cmd_table[cmdIndex].function; cmdIndex++) {
-            if (strcmp(argv[0], cmd_table[cmdIndex].command) == 0) {
-                // We found a match in the table
-                // Enough arguments?
-                if (argc < cmd_table[cmdIndex].arg_cnt) {
-                    printf("\r\nInvalid Arg cnt: %d Expected: %d\n", argc - 1,
-                            cmd_table[cmdIndex].arg_cnt - 1);
-                    break;
-                }
-                // Call the function associated with the command
-                (*cmd_table[cmdIndex].function)();
-                break; // exit for-loop
-            }
-        } // for-loop
-          // If we compared all the command strings and didn't find the command, or we want to fake that event
-        if (!cmd_table[cmdIndex].command) {
-            printf("Command \"%s\" not found\r\n", argv[0]);
-        }
-    } // At least one "word" / argument found
+    if (!argc) return;
+    // Several commands, "repeat" and "every" take the rest of the line (';' included)
+    if (strcmp(argv[0], "repeat") && strcmp(argv[0], "every") && cl_has_separator()) {
+        cl_batch_start("batch", 0, 1, 0, false);
+        return;
+    }
+    cl_run_command(&cl_timing);
+}
+
+// [-q] option of "repeat" and "every", returns the index of the next argument
+static int cl_batch_options(bool * quiet)
+{
+    *quiet = argc > 1 && !strcmp(argv[1], "-q");
+    return *quiet ? 2 : 1;
+}
+
+// repeat [-q] <n> <command> [args] [; <command> ...] - run commands n times, back to back
+int cl_repeat(void)
+{
+    bool quiet;
+    int arg = cl_batch_options(&quiet);
+    long count = arg < argc ? strtol(argv[arg], NULL, 0) : 0;
+    if(count < 1 || arg + 1 >= argc) {
+        printf("Usage: repeat [-q] <n> <command> [args] [; <command> ...]\n");
+        return 1;
+    }
+    cl_batch_start("repeat", arg + 1, (uint32_t)count, 0, quiet);
+    return 0;
+}
+
+// every [-q] <ms> <command> [args] [; <command> ...] - run commands periodically, until Ctrl-C
+int cl_every(void)
+{
+    bool quiet;
+    int arg = cl_batch_options(&quiet);
+    long ms = arg < argc ? strtol(argv[arg], NULL, 0) : 0;
+    if(ms < 1 || ms > CL_EVERY_MAX_MS || arg + 1 >= argc) {
+        printf("Usage: every [-q] <ms> <command> [args] [; <command> ...], ms: 1 - %lu\n",
+                (uint32_t)CL_EVERY_MAX_MS);
+        return 1;
+    }
+    cl_batch_start("every", arg + 1, 0, (uint32_t)ms * 1000, quiet);
+    return 0;
 }
 
 // Return true (non-zero) if character is a white space character
@@ -194,6 +615,45 @@ int cl_parseArgcArgv(char * inBuf,char **words, int count)
   return wordcount;
 } // parseArgcArgv()
 
+// time <command> [args] - run a command, then display its duration
+int cl_time(void)
+{
+    for(int i=1;i<argc;i++) argv[i - 1] = argv[i];
+    argc--;
+    int index;
+    for(index=0;cmd_table[index].function;index++) {
+        if(!strcmp(argv[0], cmd_table[index].command)) break;
+    }
+    if(!cmd_table[index].function) {
+        printf("Command \"%s\" not found\n", argv[0]);
+        return 1;
+    }
+    if(argc < cmd_table[index].arg_cnt) {
+        printf("Invalid Arg cnt: %d Expected: %d\n", argc - 1, cmd_table[index].arg_cnt - 1);
+        return 1;
+    }
+    cmd_time_index = index;
+    return (*cmd_table[index].function)();
+}
+
+// cmdstats [clear] - display execution time of each command run
+int cl_cmdstats(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"clear")) {
+        memset(cmd_stats, 0, sizeof(cmd_stats));
+        return 0;
+    }
+    printf("%s, %lu MHz\n", szversion, SystemCoreClock / 1000000);
+    printf("Command       Runs   Last us    Max us   Mean us  Last cycles   Min cycles\n");
+    for(int i=0;cmd_table[i].function;i++) {
+        const CMD_STATS * stats = &cmd_stats[i];
+        if(!stats->runs) continue;
+        printf("%-10s %7lu %9lu %9lu %9lu %12lu %12lu\n", cmd_table[i].command, stats->runs, stats->last_us,
+                stats->max_us, (uint32_t)(stats->total_us / stats->runs), stats->last_cycles, stats->min_cycles);
+    }
+    return 0;
+}
+
 #define COMMENT_START_COL  12  //Argument quantity displayed at column 12
 // We may want to add a comment/description field to the table to describe each command
 int cl_help(void) {
@@ -279,6 +739,7 @@ char * PrintHalStatus(int status)
 
 // Reset the processor
 int cl_reset(void) {
+    uart_tx_flush(); // let any buffered output go out first
     NVIC_SystemReset(); // CMSIS Cortex-M3 function - see Drivers/CMSIS/Include/core_cm3.h
     while (1) ; // wait here until reset completes
 
@@ -293,23 +754,25 @@ int cl_version(void)
 }
 
 
-// Perform a timer4 test.
-// Timer2 is a 16-bit free-running timer with pre-scale counter.
+// Perform a timebase test.
+// TIM4 is a 16-bit free-running timer with pre-scale counter, chained to TIM3 (timebase.h)
 // Is the us timer tracking System Ticks?
-// Timer2 is configured to increment each micro-second
-// Alternatively, if used a GPIO, we could toggle a pin after X micro-seconds
+// timer [ms] - time a HAL_Delay(), default 50ms.  Delays longer than 65.5ms no longer wrap.
 int cl_timer(void)
 {
-    printf("%s(), Timing HAL_Delay(50)\n",__func__);
-    volatile TIM_TypeDef *TIMx = TIM4; // Use timer 4
+    uint32_t delay_ms = 50;
+    if(argc > 1) delay_ms = (uint32_t) strtol(argv[1], NULL, 0);
+    printf("%s(), Timing HAL_Delay(%lu)\n",__func__,delay_ms);
     uint32_t start_ticks = HAL_GetTick();
-    uint16_t start_us = TIMx->CNT; // read us hardware timer
-    HAL_Delay(50); // delay 50us
-    uint16_t stop_us = TIMx->CNT; // read us hardware timer
+    uint32_t start_us = timebase_us32(); // read us hardware timer
+    HAL_Delay(delay_ms);
+    uint32_t stop_us = timebase_us32(); // read us hardware timer
     uint32_t stop_ticks = HAL_GetTick();
     // Report results
     printf("HAL_GetTick() time: %lu ms\n",stop_ticks-start_ticks);
-    printf("TIMx->CNT time: %u us\n",(uint16_t)(stop_us - start_us));
+    printf("timebase_us32() time: %lu us\n",stop_us - start_us);
+    uint64_t now = timebase_us64();
+    printf("Uptime: %lu.%06lu s (64-bit us, TIM3 wraps: %lu)\n",(uint32_t)(now / 1000000),(uint32_t)(now % 1000000),timebase_overflows);
     return 0;
 }
 
@@ -322,59 +785,50 @@ int cl_timer(void)
 uint16_t timer_delay_us(uint16_t delay_us)
 {
     //printf("%s(%lu)\n",__func__,delay_us);
-    volatile TIM_TypeDef *TIMx = TIM4; // Establish pointer to timer 4 registers
-    uint16_t start_us = TIMx->CNT; // function entry count
+    uint16_t start_us = timebase_cnt16(); // function entry count
     uint16_t delta;
     do {
-    	delta = TIMx->CNT - start_us;
+    	delta = timebase_cnt16() - start_us;
     } while(delta < delay_us);
 
     return delta;
 }
 
-#if 0
-// Comment out the following define to use the non-array method
-//#define USEARRAY	1
-
 // Test timer_delay_us() function
-int cl_timer_delay_test(void)
+// For 60 seconds, test the timer_delay_us timer, looking for a delta that isn't 1000us
+// Runs as a task, yielding after each delay, so the command line remains responsive (Ctrl-C to cancel)
+typedef struct {
+    int seconds; // 60 seconds count down
+    uint16_t i;  // 1024 1 ms delays (1 second or so)
+} DELAY_TEST_CONTEXT;
+
+static DELAY_TEST_CONTEXT delay_test_ctx;
+
+static int delay_test_task(TASK * task)
 {
-    printf("%s()\n",__func__);
-#ifdef USEARRAY
-    // Use array to collect and then display the results of 1024 tests
-    uint16_t delay_results[1024];
-    uint16_t i;
-
-	// collect results from 1024 1 ms delays (1 second or so)
-	for(i=0; i<1024; i++)
-		delay_results[i] = timer_delay_us(1000); // 1ms delay
-
-	// When using array, dump the array contents
-	for(i=0; i<1024; i++)
-		printf("%u:%u%s\n",i,delay_results[i],delay_results[i]<=1002?"":" <======="); // display marker for larger values
-
-#else
-    	// Analyze the delta time returned
-        uint16_t delta;
-        uint16_t i;
-
-        // For 60 seconds, test the timer_delay_us timer, looking for a delta that isn't 1000us
-        // 60 seconds count down
-        for(int seconds=59; seconds >= 0; seconds--) {
-        	// 1024 1 ms delays (1 second or so)
-        	for(i=0; i<1024; i++) {
-    			delta = timer_delay_us(1000); // 1ms delay
-    			if(delta > 1000) {
-    				printf("Not 1000us: %u\n",delta);
-    				return 1;
-    			}
-        	}
-        	printf("\b\b  \b\b%d",seconds); // seconds count down - erase previous display each time
+    DELAY_TEST_CONTEXT * ctx = task->ctx;
+    uint16_t delta;
+
+    TASK_BEGIN(task);
+    for(ctx->seconds=59; ctx->seconds >= 0; ctx->seconds--) {
+        for(ctx->i=0; ctx->i<1024; ctx->i++) {
+            delta = timer_delay_us(1000); // 1ms delay
+            if(delta > 1000) {
+                printf("Not 1000us: %u\n",delta);
+                return TASK_RC_DONE;
+            }
+            TASK_YIELD(task);
         }
-        printf("\b \n"); // erase the remaining '0', then line feed
-        printf("60 seconds worth of 1000us delays - each delay returned 1000us!\n");
-#endif
+        printf("\b\b  \b\b%d",ctx->seconds); // seconds count down - erase previous display each time
+    }
+    printf("\b \n"); // erase the remaining '0', then line feed
+    printf("60 seconds worth of 1000us delays - each delay returned 1000us!\n");
+    TASK_END(task);
+}
 
+int cl_timer_delay_test(void)
+{
+    printf("%s()\n",__func__);
+    cl_start_task("delaytest", delay_test_task, &delay_test_ctx);
     return 0;
 }
-#endif
@@ -0,0 +1,228 @@
+/*
+ * delaybench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Delay accuracy benchmark - see delaybench.h
+ *
+ *  Each engine is called through a function pointer, with the request in nanoseconds.  The cost
+ *  of that call (measured with an empty engine) is subtracted from every sample, so the error is
+ *  that of the delay function itself.  The task yields after each sample, letting the command
+ *  line (and its interrupts) run as they normally would.
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include <string.h>
+#include <stdint.h>
+#include "delaybench.h"
+#include "histogram.h"
+#include "soft_i2c.h"
+#include "clock.h"
+#include "dwt.h"
+#include "command_line.h"
+#include "sched.h"
+#include "stm32f1xx_it.h" // irq_counts[]
+
+typedef void (*DELAY_FUNC)(uint32_t ns);
+
+typedef struct {
+    const char * name;
+    DELAY_FUNC delay;
+} DELAY_ENGINE;
+
+static void engine_none(uint32_t ns)
+{
+    (void)ns;
+}
+
+static void engine_i2c(uint32_t ns)
+{
+    i2c_delay_us((uint16_t)((ns + 999) / 1000));
+}
+
+static void engine_timer(uint32_t ns)
+{
+    timer_delay_us((uint16_t)((ns + 999) / 1000));
+}
+
+static void engine_dwt(uint32_t ns)
+{
+    dwt_delay_cycles(ns * clock_cycles_per_us() / 1000);
+}
+
+static const DELAY_ENGINE engines[] = {
+    {"i2c",   engine_i2c},
+    {"timer", engine_timer},
+    {"dwt",   engine_dwt},
+};
+#define DELAY_ENGINES (sizeof(engines) / sizeof(engines[0]))
+
+// Requested delays, nanoseconds
+static const uint32_t requests_ns[] = {250, 500, 1000, 2000, I2C_SCL_LOW_DELAY * 1000, 10000, 100000, 1000000};
+#define DELAY_REQUESTS (sizeof(requests_ns) / sizeof(requests_ns[0]))
+
+static const char irq_letters[IRQ_COUNT_SOURCES] = {'S','D','U','T'}; // SysTick, DMA, UART, timer
+
+typedef struct {
+    uint32_t samples;     // per engine and delay
+    bool show_hist;
+    uint8_t engine;
+    uint8_t request;
+    uint32_t sample;
+    uint32_t overhead;    // cycles, engine_none() call and cycle counter reads
+    // Current row
+    HISTOGRAM error;      // |actual - requested| ns
+    int32_t min_err;      // signed, ns
+    int32_t max_err;
+    uint32_t irq_samples; // samples with interrupts
+    int32_t max_clean;    // largest error without interrupts
+    int32_t max_irq;      // largest error with interrupts
+    uint8_t max_irq_mask; // sources of the largest error with interrupts
+    // Summary - the soft I2C half bit delay
+    int32_t half_bit_under; // most negative error - a short half bit violates the bus timing
+    int32_t half_bit_clean;
+    int32_t half_bit_irq;
+} DELAY_BENCH_CONTEXT;
+
+static DELAY_BENCH_CONTEXT bench_ctx;
+
+// Cycles taken by one call of the delay, including the measurement itself
+static uint32_t delaybench_measure(DELAY_FUNC delay, uint32_t ns, uint8_t * irq_mask)
+{
+    uint32_t before[IRQ_COUNT_SOURCES];
+    for(int i=0;i<IRQ_COUNT_SOURCES;i++) before[i] = irq_counts[i];
+    uint32_t start = dwt_cycles();
+    delay(ns);
+    uint32_t cycles = dwt_cycles() - start;
+    *irq_mask = 0;
+    for(int i=0;i<IRQ_COUNT_SOURCES;i++) {
+        if(irq_counts[i] != before[i]) *irq_mask |= 1 << i;
+    }
+    return cycles;
+}
+
+static void delaybench_clear_row(DELAY_BENCH_CONTEXT * ctx)
+{
+    hist_clear(&ctx->error);
+    ctx->min_err = INT32_MAX;
+    ctx->max_err = INT32_MIN;
+    ctx->irq_samples = 0;
+    ctx->max_clean = INT32_MIN;
+    ctx->max_irq = INT32_MIN;
+    ctx->max_irq_mask = 0;
+}
+
+static void delaybench_sample(DELAY_BENCH_CONTEXT * ctx)
+{
+    uint8_t mask;
+    uint32_t ns = requests_ns[ctx->request];
+    uint32_t cycles = delaybench_measure(engines[ctx->engine].delay, ns, &mask);
+    cycles = cycles > ctx->overhead ? cycles - ctx->overhead : 0;
+    int32_t err = (int32_t)((uint64_t)cycles * 1000 / clock_cycles_per_us()) - (int32_t)ns;
+    hist_add(&ctx->error, err < 0 ? -err : err);
+    if(err < ctx->min_err) ctx->min_err = err;
+    if(err > ctx->max_err) ctx->max_err = err;
+    if(mask) {
+        ctx->irq_samples++;
+        if(err > ctx->max_irq) {
+            ctx->max_irq = err;
+            ctx->max_irq_mask = mask;
+        }
+    } else if(err > ctx->max_clean) {
+        ctx->max_clean = err;
+    }
+}
+
+static void delaybench_print_err(int32_t err)
+{
+    if(err == INT32_MIN) printf("%9s","-");
+    else printf("%+9ld",err);
+}
+
+static void delaybench_print_row(DELAY_BENCH_CONTEXT * ctx)
+{
+    printf("%-6s%8lu ", engines[ctx->engine].name, requests_ns[ctx->request]);
+    delaybench_print_err(ctx->min_err);
+    printf("%8lu%8lu", hist_percentile(&ctx->error, 50), hist_percentile(&ctx->error, 99));
+    delaybench_print_err(ctx->max_err);
+    printf("%5lu%%", ctx->irq_samples * 100 / ctx->error.count);
+    delaybench_print_err(ctx->max_clean);
+    delaybench_print_err(ctx->max_irq);
+    printf(" ");
+    for(int i=0;i<IRQ_COUNT_SOURCES;i++) {
+        if(ctx->max_irq_mask & (1 << i)) printf("%c",irq_letters[i]);
+    }
+    printf("\n");
+    if(ctx->show_hist) hist_print(&ctx->error, "ns");
+}
+
+static int delay_bench_task(TASK * task)
+{
+    DELAY_BENCH_CONTEXT * ctx = task->ctx;
+
+    TASK_BEGIN(task);
+    // Cost of the call and measurement, with nothing to delay - the least of a few tries
+    ctx->overhead = UINT32_MAX;
+    for(int i=0;i<16;i++) {
+        uint8_t mask;
+        uint32_t cycles = delaybench_measure(engine_none, 0, &mask);
+        if(cycles < ctx->overhead) ctx->overhead = cycles;
+    }
+    printf("Delay bench - %lu samples, %lu MHz CPU, %lu cycles overhead removed\n",
+            ctx->samples, clock_cycles_per_us(), ctx->overhead);
+    printf("Errors in ns (actual - requested), p50/p99 of |error|, irq%%: samples with interrupts\n");
+    printf("engine  req ns      min     p50     p99      max  irq    clean  max irq\n");
+    for(ctx->engine=0;ctx->engine<DELAY_ENGINES;ctx->engine++) {
+        for(ctx->request=0;ctx->request<DELAY_REQUESTS;ctx->request++) {
+            delaybench_clear_row(ctx);
+            for(ctx->sample=0;ctx->sample<ctx->samples;ctx->sample++) {
+                delaybench_sample(ctx);
+                TASK_YIELD(task); // one sample per call
+            }
+            delaybench_print_row(ctx);
+            if(engines[ctx->engine].delay == engine_i2c && requests_ns[ctx->request] == I2C_SCL_LOW_DELAY * 1000) {
+                ctx->half_bit_under = ctx->min_err;
+                ctx->half_bit_clean = ctx->max_clean;
+                ctx->half_bit_irq = ctx->max_irq;
+            }
+        }
+    }
+    printf("Interrupts: S SysTick, D DMA, U UART, T timer\n");
+    printf("Soft I2C half bit (%u us) worst error: undershoot", I2C_SCL_LOW_DELAY);
+    delaybench_print_err(ctx->half_bit_under);
+    printf(" ns, overshoot");
+    delaybench_print_err(ctx->half_bit_clean);
+    printf(" ns, with interrupts:");
+    delaybench_print_err(ctx->half_bit_irq);
+    printf(" ns\n");
+    TASK_END(task);
+}
+
+// delaybench [samples] [hist] - delay accuracy sweep
+int cl_delay_bench(void)
+{
+    DELAY_BENCH_CONTEXT * ctx = &bench_ctx;
+    if(sched_find(delay_bench_task)) {
+        printf("\"delaybench\" is already running\n");
+        return 1;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->samples = DELAYBENCH_DEFAULT_N;
+    ctx->half_bit_under = ctx->half_bit_clean = ctx->half_bit_irq = INT32_MIN;
+    for(int i=1;i<argc;i++) {
+        if(!strcmp(argv[i],"hist")) {
+            ctx->show_hist = true;
+        } else {
+            long n = strtol(argv[i], NULL, 0);
+            if(n <= 0) {
+                printf("Samples must be positive\n");
+                return 1;
+            }
+            ctx->samples = (uint32_t)n;
+        }
+    }
+    cl_start_task("delaybench", delay_bench_task, ctx);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * histogram.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Log-linear histogram - see histogram.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h> // memset()
+#include "histogram.h"
+
+#define HIST_SUB_COUNT  (1 << HIST_SUB_BITS)
+
+// Values below HIST_SUB_COUNT have a bucket each, then HIST_SUB_COUNT buckets per power of two
+static unsigned hist_bucket(uint32_t value)
+{
+    if(value < HIST_SUB_COUNT) return value;
+    unsigned msb = 31 - __builtin_clz(value);
+    unsigned bucket = ((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + ((value >> (msb - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1));
+    return bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1;
+}
+
+// Smallest value held by a bucket
+static uint32_t hist_bucket_low(unsigned bucket)
+{
+    if(bucket < HIST_SUB_COUNT) return bucket;
+    unsigned shift = (bucket >> HIST_SUB_BITS) - 1;
+    return (uint32_t)(HIST_SUB_COUNT + (bucket & (HIST_SUB_COUNT - 1))) << shift;
+}
+
+// Largest value held by a bucket
+static uint32_t hist_bucket_high(unsigned bucket)
+{
+    if(bucket == HIST_BUCKETS - 1) return UINT32_MAX;
+    return hist_bucket_low(bucket + 1) - 1;
+}
+
+void hist_clear(HISTOGRAM * hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT32_MAX;
+}
+
+void hist_add(HISTOGRAM * hist, uint32_t value)
+{
+    hist->buckets[hist_bucket(value)]++;
+    hist->count++;
+    hist->total += value;
+    if(value < hist->min) hist->min = value;
+    if(value > hist->max) hist->max = value;
+}
+
+// Upper bound of the bucket holding the percentile, limited to the largest value seen
+uint32_t hist_percentile(const HISTOGRAM * hist, unsigned percent)
+{
+    if(!hist->count) return 0;
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100); // 1 based
+    if(!rank) rank = 1;
+    uint32_t seen = 0;
+    for(unsigned i=0;i<HIST_BUCKETS;i++) {
+        seen += hist->buckets[i];
+        if(seen >= rank) {
+            uint32_t high = hist_bucket_high(i);
+            return high < hist->max ? high : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+uint32_t hist_mean(const HISTOGRAM * hist)
+{
+    return hist->count ? (uint32_t)(hist->total / hist->count) : 0;
+}
+
+// Display one line per power of two, from the smallest to the largest value seen
+void hist_print(const HISTOGRAM * hist, const char * units)
+{
+    if(!hist->count) {
+        printf("No samples\n");
+        return;
+    }
+    printf("min %lu, p50 %lu, p99 %lu, max %lu, mean %lu %s (%lu samples)\n", hist->min,
+            hist_percentile(hist, 50), hist_percentile(hist, 99), hist->max, hist_mean(hist), units, hist->count);
+    unsigned first = hist_bucket(hist->min) & ~(HIST_SUB_COUNT - 1);
+    unsigned last = hist_bucket(hist->max) | (HIST_SUB_COUNT - 1);
+    for(unsigned i=first;i<=last;i+=HIST_SUB_COUNT) {
+        uint32_t count = 0;
+        for(unsigned j=0;j<HIST_SUB_COUNT;j++) count += hist->buckets[i + j];
+        unsigned bar = (unsigned)((uint64_t)count * 40 / hist->count);
+        uint32_t high = hist_bucket_high(i + HIST_SUB_COUNT - 1);
+        if(high == UINT32_MAX)
+            printf("%8lu +          %s %8lu |", hist_bucket_low(i), units, count);
+        else
+            printf("%8lu - %-8lu %s %8lu |", hist_bucket_low(i), high, units, count);
+        for(unsigned j=0;j<bar;j++) printf("#");
+        printf("\n");
+    }
+}
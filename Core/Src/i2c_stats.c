@@ -0,0 +1,119 @@
+/*
+ * i2c_stats.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Per-device and per-bus I2C statistics - see i2c_stats.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "i2c_stats.h"
+#include "soft_i2c.h"
+#include "timebase.h"
+#include "command_line.h"
+
+#define I2C_STATS_FIELDS  (sizeof(I2C_STATS) / sizeof(uint32_t))
+
+static uint8_t slot_map[128];                  // address -> slot + 1, 0: no slot
+static uint8_t slot_addr[I2C_STATS_SLOTS];
+static I2C_STATS slots[I2C_STATS_SLOTS];
+static uint8_t slot_count;
+static I2C_STATS bus;
+static uint32_t unslotted;
+static uint64_t start_us;                      // timebase_us64() when cleared
+
+static void i2c_stats_sum(I2C_STATS * total, const I2C_STATS * tx)
+{
+    uint32_t * dst = (uint32_t *)total;
+    const uint32_t * src = (const uint32_t *)tx;
+    for(unsigned i=0;i<I2C_STATS_FIELDS;i++) dst[i] += src[i];
+}
+
+void i2c_stats_add(uint8_t addr, const I2C_STATS * tx, bool acked)
+{
+    addr &= 0x7F;
+    i2c_stats_sum(&bus, tx);
+    uint8_t slot = slot_map[addr];
+    if(!slot && acked) {
+        if(slot_count == I2C_STATS_SLOTS) {
+            unslotted++;
+            return;
+        }
+        slot_addr[slot_count] = addr;
+        slot = slot_map[addr] = ++slot_count;
+    }
+    if(slot) i2c_stats_sum(&slots[slot - 1], tx);
+}
+
+void i2c_stats_clear(void)
+{
+    kmutex_lock(&i2c_bus_mutex); // not in the middle of a transaction
+    memset(slot_map, 0, sizeof(slot_map));
+    memset(slots, 0, sizeof(slots));
+    memset(&bus, 0, sizeof(bus));
+    slot_count = 0;
+    unslotted = 0;
+    start_us = timebase_us64();
+    kmutex_unlock(&i2c_bus_mutex);
+}
+
+static void i2c_stats_print(const char * name, const I2C_STATS * s)
+{
+    printf("%-5s %8lu %9lu %9lu %6lu %6lu %4lu %4lu %10lu %10lu\n", name, s->transactions, s->bytes_written,
+            s->bytes_read, s->nak_addr, s->nak_data, s->timeouts, s->recoveries, s->stretch_us, s->busy_us);
+}
+
+static void i2c_stats_hex(const void * data, uint32_t len)
+{
+    const uint8_t * bytes = data;
+    while(len--) printf("%02X", *bytes++);
+}
+
+// One line, "I2CSTATS <hex>" - see i2c_stats.h
+static void i2c_stats_bin(uint32_t elapsed_us)
+{
+    I2C_STATS_HEADER header;
+    memcpy(header.magic, I2C_STATS_MAGIC, sizeof(header.magic));
+    header.version = I2C_STATS_VERSION;
+    header.slot_count = slot_count;
+    header.reserved = 0;
+    header.elapsed_us = elapsed_us;
+    header.unslotted = unslotted;
+    printf("I2CSTATS ");
+    i2c_stats_hex(&header, sizeof(header));
+    i2c_stats_hex(&bus, sizeof(bus));
+    for(uint8_t i=0;i<slot_count;i++) {
+        uint8_t addr[4] = {slot_addr[i], 0, 0, 0};
+        i2c_stats_hex(addr, sizeof(addr));
+        i2c_stats_hex(&slots[i], sizeof(slots[i]));
+    }
+    printf("\n");
+}
+
+// i2cstats [clear|bin] - display I2C statistics, per bus and per device
+int cl_i2c_stats(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"clear")) {
+        i2c_stats_clear();
+        return 0;
+    }
+    uint64_t elapsed = timebase_us64() - start_us;
+    if(argc > 1 && !strcmp(argv[1],"bin")) {
+        i2c_stats_bin((uint32_t)elapsed);
+        return 0;
+    }
+    printf("Bus busy %lu ms of %lu ms (%lu.%lu%%)\n", bus.busy_us / 1000, (uint32_t)(elapsed / 1000),
+            elapsed ? (uint32_t)(bus.busy_us * 100ULL / elapsed) : 0,
+            elapsed ? (uint32_t)(bus.busy_us * 1000ULL / elapsed % 10) : 0);
+    printf("addr  transact  wr bytes  rd bytes  nak a  nak d  tmo  rec stretch us    busy us\n");
+    i2c_stats_print("bus", &bus);
+    for(uint8_t i=0;i<slot_count;i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "0x%02X", slot_addr[i]);
+        i2c_stats_print(name, &slots[i]);
+    }
+    if(unslotted) printf("%lu transactions to other devices (no free slot)\n", unslotted);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * i2c_trace.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Soft I2C edge tracer - see i2c_trace.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "i2c_trace.h"
+#include "i2c_vcd.h"
+#include "clock.h"
+#include "command_line.h"
+
+#if I2C_TRACE_ENABLED
+uint32_t i2c_trace_events[I2C_TRACE_SIZE];
+uint16_t i2c_trace_head;
+uint8_t i2c_trace_lines = I2C_TRACE_SCL | I2C_TRACE_SDA; // idle bus
+volatile bool i2c_trace_paused;
+
+#define I2C_TRACE_CYCLE_MASK  (0xFFFFFFFFUL >> I2C_TRACE_FLAGS)
+
+// Describe an event, from the previous driven levels
+static const char * i2c_trace_event_name(uint8_t prev, uint8_t flags)
+{
+    if(flags & I2C_TRACE_SAMPLE) return "sample";
+    uint8_t changed = prev ^ flags;
+    if(changed & I2C_TRACE_SDA) {
+        if(flags & I2C_TRACE_SCL) return (flags & I2C_TRACE_SDA) ? "STOP" : "START";
+        return (flags & I2C_TRACE_SDA) ? "SDA rise" : "SDA fall";
+    }
+    return (flags & I2C_TRACE_SCL) ? "SCL rise" : "SCL fall";
+}
+
+static uint32_t i2c_trace_ns(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)cycles * 1000 / clock_cycles_per_us());
+}
+
+static void i2c_trace_vcd_write(void * arg, const char * text)
+{
+    fputs(text, (FILE *)arg);
+}
+
+// Stream the ring as VCD (i2c_vcd.h), or as raw events for Tools/i2c2vcd:
+//   # i2ctrace hz=<CPU clock> bits=<timestamp bits>
+//   <cycles> <flags>
+static void i2c_trace_export(bool vcd_format, uint16_t head, uint16_t count)
+{
+    I2C_VCD vcd;
+    uint64_t cycles64 = 0;
+    uint32_t last = 0;
+    if(vcd_format) i2c_vcd_begin(&vcd, i2c_trace_vcd_write, stdout, "NUCLEO-F103RB i2ctrace");
+    else printf("# i2ctrace hz=%lu bits=%u\n", SystemCoreClock, 32 - I2C_TRACE_FLAGS);
+    for(uint16_t i=head-count;i!=head;i++) {
+        uint32_t event = i2c_trace_events[i & (I2C_TRACE_SIZE - 1)];
+        uint32_t cycles = event >> I2C_TRACE_FLAGS;
+        uint8_t flags = event & ((1 << I2C_TRACE_FLAGS) - 1);
+        if(!vcd_format) {
+            printf("%lu %u\n", cycles, flags);
+            continue;
+        }
+        if(i != (uint16_t)(head - count)) cycles64 += (cycles - last) & I2C_TRACE_CYCLE_MASK;
+        last = cycles;
+        i2c_vcd_event(&vcd, cycles64 * 1000 / clock_cycles_per_us(), flags);
+    }
+    if(vcd_format) i2c_vcd_end(&vcd, cycles64 * 1000 / clock_cycles_per_us() + 1000);
+}
+
+// i2ctrace [clear|vcd|raw] - dump the latest SCL/SDA events, with the shortest SCL high and low times
+int cl_i2c_trace(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"clear")) {
+        i2c_trace_head = 0;
+        return 0;
+    }
+    i2c_trace_paused = true; // transactions continue, untraced
+    uint16_t head = i2c_trace_head;
+    uint16_t count = head < I2C_TRACE_SIZE ? head : I2C_TRACE_SIZE;
+    if(argc > 1 && (!strcmp(argv[1],"vcd") || !strcmp(argv[1],"raw"))) {
+        i2c_trace_export(!strcmp(argv[1],"vcd"), head, count);
+        i2c_trace_paused = false;
+        return 0;
+    }
+    uint32_t first = 0, last = 0, scl_edge = 0;
+    bool have_edge = false;
+    uint32_t min_high = UINT32_MAX, min_low = UINT32_MAX;
+    uint8_t prev = I2C_TRACE_SCL | I2C_TRACE_SDA;
+    printf("%u events\n      time ns   delta ns  SCL SDA\n", count);
+    for(uint16_t i=head-count;i!=head;i++) {
+        uint32_t event = i2c_trace_events[i & (I2C_TRACE_SIZE - 1)];
+        uint32_t cycles = event >> I2C_TRACE_FLAGS;
+        uint8_t flags = event & ((1 << I2C_TRACE_FLAGS) - 1);
+        if(i == (uint16_t)(head - count)) first = last = cycles;
+        // SCL high / low times, between SCL edges
+        if(!(flags & I2C_TRACE_SAMPLE) && ((prev ^ flags) & I2C_TRACE_SCL)) {
+            uint32_t width = (cycles - scl_edge) & I2C_TRACE_CYCLE_MASK;
+            if(have_edge) {
+                if(flags & I2C_TRACE_SCL) { if(width < min_low) min_low = width; }
+                else if(width < min_high) min_high = width;
+            }
+            scl_edge = cycles;
+            have_edge = true;
+        }
+        printf("%12lu %10lu   %c   %c  %s\n", i2c_trace_ns((cycles - first) & I2C_TRACE_CYCLE_MASK),
+                i2c_trace_ns((cycles - last) & I2C_TRACE_CYCLE_MASK),
+                flags & I2C_TRACE_SCL ? '1' : '0', flags & I2C_TRACE_SDA ? '1' : '0', i2c_trace_event_name(prev, flags));
+        if(!(flags & I2C_TRACE_SAMPLE)) prev = flags;
+        last = cycles;
+    }
+    if(min_high != UINT32_MAX && min_low != UINT32_MAX)
+        printf("Shortest SCL high %lu ns, low %lu ns\n", i2c_trace_ns(min_high), i2c_trace_ns(min_low));
+    i2c_trace_paused = false;
+    return 0;
+}
+#else
+int cl_i2c_trace(void)
+{
+    printf("I2C trace not compiled in, see I2C_TRACE_ENABLED (i2c_trace.h)\n");
+    return 1;
+}
+#endif
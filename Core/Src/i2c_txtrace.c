@@ -0,0 +1,125 @@
+/*
+ * i2c_txtrace.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  I2C transaction trace - see i2c_txtrace.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "i2c_txtrace.h"
+#include "timebase.h"
+#include "kernel.h"
+#include "sched.h"
+#include "command_line.h"
+
+static I2C_TX_RECORD records[I2C_TXTRACE_SIZE];
+static uint32_t record_head;          // free running record count
+static volatile bool paused;          // set while the ring is dumped
+static const char * callers[I2C_TXTRACE_CALLERS];
+static uint8_t caller_count;
+
+// Index of the caller's name - the cooperative task, or the kernel task, making the call
+static uint8_t i2c_txtrace_caller(void)
+{
+    const char * name = "main";
+    TASK * task = sched_current();
+    if(task) name = task->name;
+#if KERNEL_ENABLED
+    else if(kernel_running()) name = kernel_current->name;
+#endif
+    for(uint8_t i=0;i<caller_count;i++) {
+        if(!strcmp(callers[i], name)) return i;
+    }
+    if(caller_count == I2C_TXTRACE_CALLERS) return I2C_TXTRACE_CALLERS - 1; // table full, share the last
+    callers[caller_count] = name;
+    return caller_count++;
+}
+
+void i2c_txtrace_record(uint32_t start_us, uint32_t locked_us, uint8_t addr, uint8_t flags,
+                        uint8_t write_count, uint8_t read_count)
+{
+    if(paused) return;
+    I2C_TX_RECORD * rec = &records[record_head & (I2C_TXTRACE_SIZE - 1)];
+    rec->end_us = timebase_us32();
+    rec->start_us = start_us;
+    uint32_t wait = locked_us - start_us;
+    rec->wait_us = wait > 0xFFFF ? 0xFFFF : (uint16_t)wait;
+    rec->addr = addr;
+    rec->flags = flags;
+    rec->write_count = write_count;
+    rec->read_count = read_count;
+    rec->caller = i2c_txtrace_caller();
+    rec->reserved = 0;
+    record_head++;
+}
+
+// Hex encode a block of the binary image, 32 bytes per line
+static void i2c_txtrace_hex(const void * data, uint32_t len, uint32_t * column)
+{
+    const uint8_t * bytes = data;
+    while(len--) {
+        printf("%02X", *bytes++);
+        if(++*column == 32) {
+            printf("\n");
+            *column = 0;
+        }
+    }
+}
+
+static void i2c_txtrace_dump(uint32_t head, uint32_t count)
+{
+    I2C_TX_HEADER header;
+    uint32_t size = sizeof(header) + count * sizeof(I2C_TX_RECORD);
+    for(uint8_t i=0;i<caller_count;i++) size += 1 + strlen(callers[i]);
+    memcpy(header.magic, I2C_TX_MAGIC, sizeof(header.magic));
+    header.version = I2C_TX_VERSION;
+    header.record_size = sizeof(I2C_TX_RECORD);
+    header.caller_count = caller_count;
+    header.reserved = 0;
+    header.record_count = count;
+    header.dump_us = timebase_us32();
+    uint32_t column = 0;
+    printf("I2CTX BEGIN %lu\n", size);
+    i2c_txtrace_hex(&header, sizeof(header), &column);
+    for(uint8_t i=0;i<caller_count;i++) {
+        uint8_t len = (uint8_t)strlen(callers[i]);
+        i2c_txtrace_hex(&len, 1, &column);
+        i2c_txtrace_hex(callers[i], len, &column);
+    }
+    for(uint32_t i=head-count;i!=head;i++)
+        i2c_txtrace_hex(&records[i & (I2C_TXTRACE_SIZE - 1)], sizeof(I2C_TX_RECORD), &column);
+    if(column) printf("\n");
+    printf("I2CTX END\n");
+}
+
+// i2ctx [clear|dump] - list the latest I2C transactions, or dump them for Tools/i2ctx2json
+int cl_i2c_txtrace(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"clear")) {
+        record_head = 0;
+        return 0;
+    }
+    paused = true; // transactions continue, unrecorded
+    uint32_t head = record_head;
+    uint32_t count = head < I2C_TXTRACE_SIZE ? head : I2C_TXTRACE_SIZE;
+    if(argc > 1 && !strcmp(argv[1],"dump")) {
+        i2c_txtrace_dump(head, count);
+    } else {
+        printf("%lu transactions, latest %lu:\n", head, count);
+        printf("  start us   wait us  bus us  caller       addr  op     write  read  ack\n");
+        for(uint32_t i=head-count;i!=head;i++) {
+            const I2C_TX_RECORD * rec = &records[i & (I2C_TXTRACE_SIZE - 1)];
+            const char * op = rec->flags & I2C_TX_PROBE ? "probe" :
+                    (rec->flags & I2C_TX_WRITE) && (rec->flags & I2C_TX_READ) ? "wr" :
+                    rec->flags & I2C_TX_READ ? "read" : "write";
+            printf("%10lu %9u %7lu  %-12s 0x%02X  %-6s %5u %5u  %s\n", rec->start_us, rec->wait_us,
+                    rec->end_us - rec->start_us - rec->wait_us, callers[rec->caller], rec->addr, op,
+                    rec->write_count, rec->read_count, rec->flags & I2C_TX_NAK ? "NAK" : "ACK");
+        }
+    }
+    paused = false;
+    return 0;
+}
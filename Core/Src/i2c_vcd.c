@@ -0,0 +1,140 @@
+/*
+ * i2c_vcd.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Soft I2C trace to VCD converter - see i2c_vcd.h
+ */
+
+#include <string.h>
+#include "i2c_vcd.h"
+
+// Event flags, as recorded by i2c_trace.h
+#define VCD_SCL     0x01
+#define VCD_SDA     0x02
+#define VCD_SAMPLE  0x04
+
+// VCD identifier codes
+#define ID_SCL    "!"
+#define ID_SDA    "\""
+#define ID_START  "#"
+#define ID_STOP   "$"
+#define ID_ACK    "%"
+#define ID_DATA   "&"
+
+static void vcd_write_u64(I2C_VCD * vcd, const char * prefix, uint64_t value)
+{
+    // uint64_t formatting isn't in newlib nano, build the digits here
+    char text[24];
+    int i = sizeof(text) - 1;
+    text[i] = '\0';
+    do {
+        text[--i] = '0' + (char)(value % 10);
+        value /= 10;
+    } while(value);
+    vcd->write(vcd->arg, prefix);
+    vcd->write(vcd->arg, &text[i]);
+    vcd->write(vcd->arg, "\n");
+}
+
+static void vcd_bit(I2C_VCD * vcd, bool value, const char * id)
+{
+    vcd->write(vcd->arg, value ? "1" : "0");
+    vcd->write(vcd->arg, id);
+    vcd->write(vcd->arg, "\n");
+}
+
+// Move to a new time step, ending any start/stop pulses
+static void vcd_time(I2C_VCD * vcd, uint64_t time_ns)
+{
+    if(time_ns <= vcd->time_ns) return; // same step (or out of order - keep it monotonic)
+    vcd->time_ns = time_ns;
+    vcd_write_u64(vcd, "#", time_ns);
+    if(vcd->pulses & 1) vcd_bit(vcd, false, ID_START);
+    if(vcd->pulses & 2) vcd_bit(vcd, false, ID_STOP);
+    vcd->pulses = 0;
+}
+
+void i2c_vcd_begin(I2C_VCD * vcd, I2C_VCD_WRITE write, void * arg, const char * source)
+{
+    memset(vcd, 0, sizeof(*vcd));
+    vcd->write = write;
+    vcd->arg = arg;
+    vcd->driven = VCD_SCL | VCD_SDA; // idle bus
+    vcd->sda = VCD_SDA;              // compared with flags & VCD_SDA
+    write(arg, "$version ");
+    write(arg, source);
+    write(arg, " $end\n$timescale 1ns $end\n$scope module i2c $end\n"
+            "$var wire 1 " ID_SCL " scl $end\n"
+            "$var wire 1 " ID_SDA " sda $end\n"
+            "$var wire 1 " ID_START " start $end\n"
+            "$var wire 1 " ID_STOP " stop $end\n"
+            "$var wire 1 " ID_ACK " ack $end\n"
+            "$var wire 8 " ID_DATA " data $end\n"
+            "$upscope $end\n$enddefinitions $end\n");
+}
+
+void i2c_vcd_event(I2C_VCD * vcd, uint64_t time_ns, uint8_t flags)
+{
+    if(!vcd->started) {
+        // Initial values, at the time of the first event
+        vcd->started = true;
+        vcd->time_ns = time_ns;
+        vcd_write_u64(vcd, "#", time_ns);
+        vcd->write(vcd->arg, "$dumpvars\n1" ID_SCL "\n1" ID_SDA "\n0" ID_START "\n0" ID_STOP
+                "\nx" ID_ACK "\nbxxxxxxxx " ID_DATA "\n$end\n");
+    }
+    vcd_time(vcd, time_ns);
+    uint8_t sda = flags & VCD_SDA;
+    if(flags & VCD_SAMPLE) {
+        // Level read back - the slave may be driving SDA
+        if(sda != vcd->sda) vcd_bit(vcd, sda, ID_SDA);
+        vcd->sda = sda;
+        return;
+    }
+    uint8_t changed = vcd->driven ^ flags;
+    if((changed & VCD_SCL) && (flags & VCD_SCL)) vcd->clocked = true;
+    if((changed & VCD_SCL) && !(flags & VCD_SCL) && vcd->clocked) {
+        // SCL falling - latch the bit shown on SDA while SCL was high
+        bool bit = vcd->sda != 0;
+        if(vcd->bits < 8) {
+            vcd->byte = (uint8_t)(vcd->byte << 1) | bit;
+            if(++vcd->bits == 8) {
+                char text[10] = "b";
+                for(int i=0;i<8;i++) text[1 + i] = (vcd->byte & (0x80 >> i)) ? '1' : '0';
+                text[9] = '\0';
+                vcd->write(vcd->arg, text);
+                vcd->write(vcd->arg, " " ID_DATA "\n");
+            }
+        } else {
+            vcd_bit(vcd, !bit, ID_ACK); // SDA low is ACK
+            vcd->bits = 0;
+            vcd->byte = 0;
+        }
+    }
+    if((changed & VCD_SDA) && (flags & VCD_SCL) && (vcd->driven & VCD_SCL)) {
+        // SDA changed while SCL high - START (falling) or STOP (rising)
+        if(sda) {
+            vcd_bit(vcd, true, ID_STOP);
+            vcd->pulses |= 2;
+        } else {
+            vcd_bit(vcd, true, ID_START);
+            vcd->write(vcd->arg, "x" ID_ACK "\n");
+            vcd->pulses |= 1;
+        }
+        vcd->clocked = false;
+        vcd->bits = 0;
+        vcd->byte = 0;
+    }
+    if(changed & VCD_SCL) vcd_bit(vcd, flags & VCD_SCL, ID_SCL);
+    if(sda != vcd->sda) vcd_bit(vcd, sda, ID_SDA);
+    vcd->driven = flags & (VCD_SCL | VCD_SDA);
+    vcd->sda = sda;
+}
+
+// Final time step, so the last changes are visible
+void i2c_vcd_end(I2C_VCD * vcd, uint64_t time_ns)
+{
+    if(vcd->started) vcd_time(vcd, time_ns);
+}
@@ -0,0 +1,200 @@
+/*
+ * i2cbench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  I2C throughput and latency benchmark - see i2cbench.h
+ *
+ *  Throughput is measured from the start of the first transaction to the end of the last, so
+ *  transactions/s includes the time other tasks ran between transactions.  "Bus busy" is the
+ *  total time spent in transactions, as a percentage of that.
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include <string.h>
+#include <stddef.h> // offsetof()
+#include <stdint.h>
+#include "i2cbench.h"
+#include "soft_i2c.h"
+#include "histogram.h"
+#include "timebase.h"
+#include "clock.h"
+#include "version.h"
+#include "command_line.h"
+#include "sched.h"
+
+typedef enum {
+    I2CBENCH_PROBE,
+    I2CBENCH_WRITE,
+    I2CBENCH_READ,
+    I2CBENCH_WRITE_READ,
+} I2CBENCH_MODE;
+
+static const char * const mode_names[] = {"probe","write","read","wr"};
+
+typedef struct {
+    I2CBENCH_MODE mode;
+    uint8_t addr;
+    uint8_t len;           // data bytes, not used by probe
+    bool csv;              // add a machine readable line
+    uint32_t count;        // transactions to run, 0: run for duration_us
+    uint32_t duration_us;
+    uint32_t done;         // transactions completed
+    uint32_t errors;       // transactions not acknowledged - not included in the histogram
+    uint64_t start_us;
+    uint64_t elapsed_us;
+    uint64_t busy_us;
+    HISTOGRAM latency;
+    uint8_t data[I2CBENCH_MAX_LEN];
+} I2CBENCH_CONTEXT;
+
+static I2CBENCH_CONTEXT bench_ctx;
+
+// Data bytes moved by one successful transaction
+static uint32_t i2cbench_bytes(const I2CBENCH_CONTEXT * ctx)
+{
+    switch(ctx->mode) {
+    case I2CBENCH_PROBE:      return 0;
+    case I2CBENCH_WRITE_READ: return 1 + ctx->len; // register byte, then the read
+    default:                  return ctx->len;
+    }
+}
+
+// Run one transaction, returns false if the device didn't respond
+static bool i2cbench_transaction(I2CBENCH_CONTEXT * ctx)
+{
+    uint8_t reg = 0;
+    switch(ctx->mode) {
+    case I2CBENCH_PROBE:
+        return i2c_device_ready(ctx->addr);
+    case I2CBENCH_WRITE:
+        ctx->data[0] = I2CBENCH_WRITE_REG;
+        return i2c_write_read(ctx->addr, ctx->data, ctx->len, NULL, 0) == 0;
+    case I2CBENCH_READ:
+        return i2c_write_read(ctx->addr, NULL, 0, ctx->data, ctx->len) == 0;
+    case I2CBENCH_WRITE_READ:
+        return i2c_write_read(ctx->addr, &reg, sizeof(reg), ctx->data, ctx->len) == 0;
+    }
+    return false;
+}
+
+static void i2cbench_report(I2CBENCH_CONTEXT * ctx)
+{
+    uint32_t good = ctx->done - ctx->errors;
+    uint64_t elapsed = ctx->elapsed_us ? ctx->elapsed_us : 1;
+    uint32_t tps = (uint32_t)((uint64_t)good * 1000000 / elapsed);
+    uint32_t bps = (uint32_t)((uint64_t)good * i2cbench_bytes(ctx) * 1000000 / elapsed);
+    printf("%lu transactions, %lu errors in %lu ms\n", ctx->done, ctx->errors, (uint32_t)(ctx->elapsed_us / 1000));
+    printf("%lu transactions/s, %lu bytes/s, bus busy %lu%%\n", tps, bps, (uint32_t)(ctx->busy_us * 100 / elapsed));
+    printf("Latency: ");
+    hist_print(&ctx->latency, "us");
+    if(ctx->csv) {
+        // One line of key=value pairs, for comparing builds and clock profiles
+        printf("i2cbench fw_version=%u.%u.%u mhz=%u mode=%s addr=0x%02X len=%u n=%lu errors=%lu elapsed_us=%lu"
+                " tps=%lu bps=%lu min_us=%lu p50_us=%lu p99_us=%lu max_us=%lu mean_us=%lu\n",
+                (unsigned)fw_version.major, (unsigned)fw_version.minor, (unsigned)fw_version.build, clock_profile()->mhz,
+                mode_names[ctx->mode], ctx->addr, ctx->mode == I2CBENCH_PROBE ? 0 : ctx->len,
+                ctx->done, ctx->errors, (uint32_t)ctx->elapsed_us, tps, bps,
+                ctx->latency.count ? ctx->latency.min : 0, hist_percentile(&ctx->latency, 50),
+                hist_percentile(&ctx->latency, 99), ctx->latency.max, hist_mean(&ctx->latency));
+    }
+}
+
+static int i2cbench_task(TASK * task)
+{
+    I2CBENCH_CONTEXT * ctx = task->ctx;
+
+    TASK_BEGIN(task);
+    printf("I2C bench - %s, address 0x%02X", mode_names[ctx->mode], ctx->addr);
+    if(ctx->mode != I2CBENCH_PROBE) printf(", %u bytes", ctx->len);
+    if(ctx->count) printf(", %lu transactions\n", ctx->count);
+    else printf(", %lu ms\n", ctx->duration_us / 1000);
+    ctx->start_us = timebase_us64();
+    while(ctx->count ? ctx->done < ctx->count : timebase_us64() - ctx->start_us < ctx->duration_us) {
+        uint32_t start = timebase_us32();
+        bool ok = i2cbench_transaction(ctx);
+        uint32_t us = timebase_us32() - start;
+        ctx->busy_us += us;
+        ctx->done++;
+        if(ok) hist_add(&ctx->latency, us);
+        else ctx->errors++;
+        TASK_YIELD(task); // one transaction per call
+    }
+    ctx->elapsed_us = timebase_us64() - ctx->start_us;
+    i2cbench_report(ctx);
+    TASK_END(task);
+}
+
+// i2cbench <probe|write|read|wr> [addr] [len] [n|<n>ms] [csv] - probe takes no len
+int cl_i2c_bench(void)
+{
+    I2CBENCH_CONTEXT * ctx = &bench_ctx;
+    if(sched_find(i2cbench_task)) {
+        printf("\"i2cbench\" is already running\n");
+        return 1;
+    }
+    if(argc < 2) {
+        printf("Usage: i2cbench probe [addr] [n|<n>ms] [csv]\n");
+        printf("       i2cbench <write|read|wr> [addr] [len] [n|<n>ms] [csv]\n");
+        return 1;
+    }
+    memset(ctx, 0, offsetof(I2CBENCH_CONTEXT, latency));
+    hist_clear(&ctx->latency);
+    memset(ctx->data, 0, sizeof(ctx->data)); // write payload
+    int args = argc;
+    if(args > 2 && !strcmp(argv[args-1], "csv")) {
+        ctx->csv = true;
+        args--;
+    }
+    int mode;
+    for(mode=I2CBENCH_PROBE;mode<=I2CBENCH_WRITE_READ;mode++) {
+        if(!strcmp(argv[1],mode_names[mode])) break;
+    }
+    if(mode > I2CBENCH_WRITE_READ) {
+        printf("Unknown mode \"%s\"\n",argv[1]);
+        return 1;
+    }
+    ctx->mode = (I2CBENCH_MODE)mode;
+    int arg = 2;
+    long addr = args > arg ? strtol(argv[arg++], NULL, 0) : DS3231_ADDRESS;
+    long len = 1; // probe transfers no data, so takes no length
+    if(ctx->mode != I2CBENCH_PROBE && args > arg)
+        len = strtol(argv[arg++], NULL, 0);
+    ctx->count = I2CBENCH_DEFAULT_N;
+    if(args > arg) {
+        char * end;
+        long n = strtol(argv[arg], &end, 0);
+        if(n <= 0) {
+            printf("Count or duration must be positive\n");
+            return 1;
+        }
+        if(!strcmp(end, "ms")) {
+            if(n > I2CBENCH_MAX_MS) {
+                printf("Duration must be 1 - %lu ms\n", (uint32_t)I2CBENCH_MAX_MS);
+                return 1;
+            }
+            ctx->count = 0;
+            ctx->duration_us = (uint32_t)n * 1000;
+        } else {
+            ctx->count = (uint32_t)n;
+        }
+    }
+    if(addr < I2C_ADDRESS_MIN || addr > I2C_ADDRESS_MAX) {
+        printf("Address must be 0x%02X - 0x%02X\n",I2C_ADDRESS_MIN,I2C_ADDRESS_MAX);
+        return 1;
+    }
+    if(len < 1 || len > I2CBENCH_MAX_LEN) {
+        printf("Length must be 1 - %u\n",I2CBENCH_MAX_LEN);
+        return 1;
+    }
+    if(ctx->mode == I2CBENCH_WRITE && len > I2CBENCH_WRITE_MAX_LEN) {
+        printf("Write length must be 1 - %u (DS3231 alarm registers only)\n",I2CBENCH_WRITE_MAX_LEN);
+        return 1;
+    }
+    ctx->addr = (uint8_t)addr;
+    ctx->len = (uint8_t)len;
+    cl_start_task("i2cbench", i2cbench_task, ctx);
+    return 0;
+}
@@ -0,0 +1,325 @@
+/*
+ * kernel.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Minimal fixed priority preemptive kernel - see kernel.h
+ *
+ *  Scheduling rules:
+ *  - The highest (effective) priority READY task runs
+ *  - A task made READY by the tick, or by a mutex release, preempts a lower priority task
+ *  - When the time slice expires, the next READY task of the same priority runs (round robin)
+ *  - The idle task (priority 0) is always READY
+ */
+
+#include <stdio.h>  // printf()
+#include "kernel.h"
+#include "main.h"   // HAL_GetTick()
+#include "timebase.h"
+#include "power.h"
+
+KTASK * volatile kernel_current;
+KTASK * volatile kernel_next;
+
+static KTASK * task_list[KERNEL_MAX_TASKS];
+static uint8_t task_count;
+static volatile bool running;
+static uint32_t slice_start; // HAL_GetTick() value when the current time slice started
+
+#define IDLE_STACK_WORDS  64
+static uint32_t idle_stack[IDLE_STACK_WORDS];
+static KTASK idle_task;
+
+static void kernel_idle(void * arg)
+{
+    (void)arg;
+    while(1) {
+        power_idle(kernel_idle_ms()); // sleep until an interrupt, or stop until the next wake
+    }
+}
+
+void kernel_init(void)
+{
+    task_count = 0;
+    kernel_task_create(&idle_task, "idle", kernel_idle, NULL, idle_stack, IDLE_STACK_WORDS, KERNEL_PRIORITY_IDLE);
+}
+
+void kernel_task_create(KTASK * task, const char * name, void (*entry)(void *), void * arg,
+                        uint32_t * stack, uint32_t stack_words, uint8_t priority)
+{
+    if(task_count >= KERNEL_MAX_TASKS) {
+        printf("%s(): no room for \"%s\"\n",__func__,name);
+        return;
+    }
+    task->name = name;
+    task->entry = entry;
+    task->arg = arg;
+    task->stack = stack;
+    task->stack_words = stack_words;
+    task->base_priority = priority;
+    task->priority = priority;
+    task->state = KTASK_READY;
+    task->waiting_on = NULL;
+    task->switches = 0;
+    // Paint the stack so the high water mark can be found later
+    for(uint32_t i=0;i<stack_words;i++)
+        stack[i] = KERNEL_STACK_FILL;
+    port_init_stack(task);
+    task_list[task_count++] = task;
+}
+
+bool kernel_running(void)
+{
+    return running;
+}
+
+// Return the highest priority READY task.  The search starts after the current task,
+// so tasks of equal priority take turns.
+static KTASK * kernel_pick(void)
+{
+    int start = 0;
+    for(int i=0;i<task_count;i++) {
+        if(task_list[i] == kernel_current) start = i;
+    }
+    KTASK * best = NULL;
+    for(int n=1;n<=task_count;n++) {
+        KTASK * task = task_list[(start + n) % task_count];
+        if(task->state == KTASK_READY && (!best || task->priority > best->priority))
+            best = task;
+    }
+    return best;
+}
+
+// Select the task to run, requesting a PendSV context switch if it isn't the current task
+// Must be called with interrupts disabled.  rotate: time slice expired
+static void kernel_schedule(bool rotate)
+{
+    KTASK * current = kernel_current;
+    KTASK * best = kernel_pick();
+    // Without a time slice expiring, the current task keeps running unless a higher priority task is READY
+    if(!rotate && current->state == KTASK_READY && best->priority <= current->priority)
+        best = current;
+    if(best != current || rotate)
+        slice_start = HAL_GetTick();
+    if(best != kernel_next) {
+        kernel_next = best;
+        best->switches++;
+        port_request_switch();
+    }
+}
+
+void kernel_start(void)
+{
+    (void)port_enter_critical(); // port_start() enables interrupts once the first task's stack is in use
+    kernel_current = kernel_pick();
+    kernel_next = kernel_current;
+    kernel_current->switches++;
+    slice_start = HAL_GetTick();
+    running = true;
+    port_start(kernel_current);
+}
+
+// SysTick: wake delayed tasks, preempt for higher priority tasks, time slice equal priority tasks
+void kernel_tick(void)
+{
+    if(!running) return;
+    uint32_t now = HAL_GetTick();
+    for(int i=0;i<task_count;i++) {
+        KTASK * task = task_list[i];
+        if(task->state == KTASK_DELAYED && (int32_t)(now - task->wake_tick) >= 0) {
+            task->state = KTASK_READY;
+            task->wake_us = timebase_us32(); // time stamp for latency measurement
+        }
+    }
+    kernel_schedule(now - slice_start >= KERNEL_TIME_SLICE_MS);
+}
+
+// Give up the remainder of the time slice to other tasks of equal priority
+void kernel_yield(void)
+{
+    if(!running) return;
+    uint32_t state = port_enter_critical();
+    kernel_schedule(true);
+    port_exit_critical(state); // context switch occurs here
+}
+
+void kernel_delay(uint32_t ms)
+{
+    if(!running) {
+        HAL_Delay(ms);
+        return;
+    }
+    uint32_t state = port_enter_critical();
+    KTASK * current = kernel_current;
+    current->wake_tick = HAL_GetTick() + ms;
+    current->state = KTASK_DELAYED;
+    kernel_schedule(false);
+    port_exit_critical(state); // context switch occurs here
+}
+
+// Delay until period_ms after the previous wake time, for jitter free periodic tasks
+// If the task has fallen behind, the schedule is restarted from the current time
+void kernel_delay_until(uint32_t * last_wake, uint32_t period_ms)
+{
+    uint32_t now = HAL_GetTick();
+    *last_wake += period_ms;
+    int32_t remaining = (int32_t)(*last_wake - now);
+    if(remaining <= 0) {
+        *last_wake = now; // overrun
+        kernel_yield();
+        return;
+    }
+    kernel_delay((uint32_t)remaining);
+}
+
+// Return number of stack words that have never been used
+uint32_t kernel_stack_unused(const KTASK * task)
+{
+    uint32_t unused = 0;
+    while(unused < task->stack_words && task->stack[unused] == KERNEL_STACK_FILL)
+        unused++;
+    return unused;
+}
+
+// Milliseconds until the next delayed task wakes, KERNEL_WAIT_FOREVER when none are delayed
+uint32_t kernel_idle_ms(void)
+{
+    uint32_t idle_ms = KERNEL_WAIT_FOREVER;
+    uint32_t state = port_enter_critical();
+    uint32_t now = HAL_GetTick();
+    for(int i=0;i<task_count;i++) {
+        const KTASK * task = task_list[i];
+        if(task->state != KTASK_DELAYED) continue;
+        int32_t remaining = (int32_t)(task->wake_tick - now);
+        if(remaining <= 0) {
+            idle_ms = 0;
+            break;
+        }
+        if((uint32_t)remaining < idle_ms) idle_ms = (uint32_t)remaining;
+    }
+    port_exit_critical(state);
+    return idle_ms;
+}
+
+// A task function returned - the task is removed from scheduling
+void kernel_task_exit(void)
+{
+    uint32_t state = port_enter_critical();
+    kernel_current->state = KTASK_DEAD;
+    kernel_schedule(false);
+    port_exit_critical(state);
+    while(1) ; // not reached
+}
+
+void kmutex_lock(KMUTEX * mutex)
+{
+    if(!running) return;
+    uint32_t state = port_enter_critical();
+    KTASK * current = kernel_current;
+    if(!mutex->owner) {
+        mutex->owner = current;
+        mutex->count = 1;
+    } else if(mutex->owner == current) {
+        mutex->count++;
+    } else {
+        mutex->contentions++;
+        current->waiting_on = mutex;
+        current->state = KTASK_BLOCKED;
+        // Priority inheritance - the owner (and whatever it may be waiting on) runs at
+        // our priority until the mutex is released
+        KTASK * owner = mutex->owner;
+        while(owner && owner->priority < current->priority) {
+            owner->priority = current->priority;
+            owner = owner->waiting_on ? owner->waiting_on->owner : NULL;
+        }
+        kernel_schedule(false);
+    }
+    port_exit_critical(state); // when blocked, we resume here owning the mutex
+}
+
+void kmutex_unlock(KMUTEX * mutex)
+{
+    if(!running) return;
+    uint32_t state = port_enter_critical();
+    KTASK * current = kernel_current;
+    if(mutex->owner == current && --mutex->count == 0) {
+        current->priority = current->base_priority; // drop any inherited priority
+        // Hand the mutex to the highest priority waiter
+        KTASK * waiter = NULL;
+        for(int i=0;i<task_count;i++) {
+            KTASK * task = task_list[i];
+            if(task->state == KTASK_BLOCKED && task->waiting_on == mutex &&
+                    (!waiter || task->priority > waiter->priority))
+                waiter = task;
+        }
+        if(waiter) {
+            waiter->waiting_on = NULL;
+            waiter->state = KTASK_READY;
+            mutex->owner = waiter;
+            mutex->count = 1;
+        } else {
+            mutex->owner = NULL;
+        }
+        kernel_schedule(false);
+    }
+    port_exit_critical(state);
+}
+
+// Wait for an event to be signalled.  Returns false on timeout.
+// Only one task may wait on an event.  A signal sent while no task is waiting is remembered.
+bool kevent_wait(KEVENT * event, uint32_t timeout_ms)
+{
+    if(!running) return false;
+    uint32_t state = port_enter_critical();
+    KTASK * current = kernel_current;
+    if(!event->pending && timeout_ms) {
+        event->waiter = current;
+        if(timeout_ms == KERNEL_WAIT_FOREVER) {
+            current->state = KTASK_BLOCKED;
+        } else {
+            current->wake_tick = HAL_GetTick() + timeout_ms;
+            current->state = KTASK_DELAYED;
+        }
+        kernel_schedule(false);
+        port_exit_critical(state); // context switch occurs here
+        state = port_enter_critical();
+        event->waiter = NULL;
+    }
+    bool signalled = event->pending;
+    event->pending = false;
+    port_exit_critical(state);
+    return signalled;
+}
+
+// Signal an event, from a task or an interrupt handler
+void kevent_signal(KEVENT * event)
+{
+    uint32_t state = port_enter_critical();
+    event->pending = true;
+    KTASK * waiter = event->waiter;
+    if(running && waiter && waiter->state != KTASK_READY) {
+        waiter->state = KTASK_READY;
+        kernel_schedule(false);
+    }
+    port_exit_critical(state);
+}
+
+// Display kernel tasks, with stack high water mark
+int cl_ps(void)
+{
+    static const char * const state_names[] = {"ready","delay","block","dead"};
+    if(!running) {
+        printf("Kernel not running\n");
+        return 1;
+    }
+    printf("Task   Prio  State  Stack used/size  Switches\n");
+    for(int i=0;i<task_count;i++) {
+        const KTASK * task = task_list[i];
+        uint32_t size = task->stack_words * 4;
+        uint32_t used = size - kernel_stack_unused(task) * 4;
+        printf("%-6s %u/%u   %-5s  %5lu/%-5lu     %lu%s\n", task->name, task->base_priority, task->priority,
+                state_names[task->state], used, size, task->switches, task == kernel_current ? " *" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * kernel_port.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Cortex-M3 port of the minimal kernel - see kernel.h
+ *
+ *  Tasks run in thread mode using the process stack pointer (PSP).  Interrupts continue to use
+ *  the main stack pointer (MSP), so task stacks don't need room for interrupt nesting.
+ *
+ *  Task stack, as saved by PendSV_Handler (lowest address first):
+ *    r4 r5 r6 r7 r8 r9 r10 r11     <- saved by software (PendSV_Handler)
+ *    r0 r1 r2 r3 r12 lr pc xPSR    <- saved by hardware on exception entry
+ */
+
+#include "kernel.h"
+#include "main.h"   // CMSIS functions and defines
+
+#define XPSR_THUMB  0x01000000  // Thumb state bit must be set in the initial xPSR
+
+// Build an initial stack frame, as if the task had been switched out by PendSV_Handler
+void port_init_stack(KTASK * task)
+{
+    uint32_t * sp = task->stack + task->stack_words;
+    sp = (uint32_t *)((uint32_t)sp & ~7UL); // AAPCS: 8 byte stack alignment
+    *(--sp) = XPSR_THUMB;                   // xPSR
+    *(--sp) = (uint32_t)task->entry & ~1UL; // pc
+    *(--sp) = (uint32_t)kernel_task_exit;   // lr - task function returned
+    *(--sp) = 0;                            // r12
+    *(--sp) = 0;                            // r3
+    *(--sp) = 0;                            // r2
+    *(--sp) = 0;                            // r1
+    *(--sp) = (uint32_t)task->arg;          // r0 - task function argument
+    for(int i=0;i<8;i++)
+        *(--sp) = 0;                        // r11 - r4
+    task->sp = sp;
+}
+
+// Switch thread mode to the PSP, pop the initial frame built by port_init_stack(),
+// enable interrupts and branch to the task function.  The MSP is left for interrupts.
+__attribute__((naked)) static void port_start_first(void)
+{
+    __asm volatile(
+        "   ldr r0, =kernel_current \n"
+        "   ldr r0, [r0]            \n" // r0 = kernel_current
+        "   ldr r1, [r0]            \n" // r1 = kernel_current->sp
+        "   adds r1, #32            \n" // skip r4 - r11
+        "   msr psp, r1             \n"
+        "   movs r1, #2             \n" // CONTROL.SPSEL: thread mode uses PSP
+        "   msr control, r1         \n"
+        "   isb                     \n"
+        "   pop {r0-r3, r12, lr}    \n" // r0: task argument, lr: kernel_task_exit
+        "   pop {r1, r2}            \n" // r1: task function, r2: xPSR (discarded)
+        "   orr r1, r1, #1          \n" // branch in Thumb state
+        "   cpsie i                 \n"
+        "   bx r1                   \n"
+        "   .ltorg                  \n"
+    );
+}
+
+// Context switch: save r4-r11 on the current task's stack, switch to kernel_next's stack
+__attribute__((naked)) void PendSV_Handler(void)
+{
+    __asm volatile(
+        "   cpsid i                 \n"
+        "   mrs r0, psp             \n"
+        "   stmdb r0!, {r4-r11}     \n"
+        "   ldr r1, =kernel_current \n"
+        "   ldr r2, [r1]            \n"
+        "   str r0, [r2]            \n" // kernel_current->sp = psp
+        "   ldr r2, =kernel_next    \n"
+        "   ldr r2, [r2]            \n"
+        "   str r2, [r1]            \n" // kernel_current = kernel_next
+        "   ldr r0, [r2]            \n" // psp = kernel_next->sp
+        "   ldmia r0!, {r4-r11}     \n"
+        "   msr psp, r0             \n"
+        "   cpsie i                 \n"
+        "   bx lr                   \n" // exception return restores r0-r3, r12, lr, pc, xPSR
+        "   .ltorg                  \n"
+    );
+}
+
+// Start the first task (kernel_current) - called with interrupts disabled
+void port_start(KTASK * first)
+{
+    (void)first; // port_start_first() uses kernel_current
+    HAL_NVIC_SetPriority(PendSV_IRQn, 15, 0); // lowest priority - never preempts an interrupt handler
+    port_start_first();
+    while(1) ; // not reached
+}
+
+void port_request_switch(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk; // PendSV runs once interrupts are enabled
+}
+
+uint32_t port_enter_critical(void)
+{
+    uint32_t state = __get_PRIMASK();
+    __disable_irq();
+    return state;
+}
+
+void port_exit_critical(uint32_t state)
+{
+    __set_PRIMASK(state);
+}
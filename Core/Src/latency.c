@@ -0,0 +1,149 @@
+/*
+ * latency.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Main loop latency and command line responsiveness monitor - see latency.h
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include <string.h>
+#include "latency.h"
+#include "histogram.h"
+#include "timebase.h"
+#include "command_line.h"
+#include "main.h"   // HAL functions and defines, Error_Handler()
+
+extern UART_HandleTypeDef huart2; // main.c
+
+static HISTOGRAM loop_hist = {.min = UINT32_MAX}; // as hist_clear()
+static HISTOGRAM rx_hist = {.min = UINT32_MAX};
+static uint32_t loop_last_us;       // start of the previous pass
+static bool loop_started;           // loop_last_us is valid
+static const char * loop_worst_task; // slowest task in the pass before the longest interval
+static volatile bool rx_pending;    // an RX burst's arrival is recorded, waiting to be read
+static volatile uint16_t rx_pos;    // DMA position after the burst
+static volatile uint32_t rx_arrival_us;
+static volatile uint16_t rx_read_pos;  // position after the last character read
+static volatile uint32_t rx_read_us;   // when it was read
+static volatile bool rx_early;      // the burst was read before the idle line interrupt
+static volatile uint32_t rx_early_us; // its delay, added to the histogram by latency_loop()
+static uint32_t budget_us;          // 0: no budget
+static LATENCY_ACTION budget_action;
+static uint32_t loop_overruns;
+static uint32_t rx_overruns;
+static uint32_t log_last_ms;
+
+static void latency_check(const char * what, uint32_t us, const char * task, uint32_t * overruns)
+{
+    if(!budget_us || us <= budget_us) return;
+    (*overruns)++;
+    if(budget_action == LATENCY_ACTION_COUNT) return;
+    if(budget_action == LATENCY_ACTION_LOG && HAL_GetTick() - log_last_ms < LATENCY_LOG_MS) return;
+    log_last_ms = HAL_GetTick();
+    printf("latency: %s %lu us > budget %lu us%s%s\n", what, us, budget_us, task ? ", " : "", task ? task : "");
+    if(budget_action == LATENCY_ACTION_ASSERT) {
+        uart_tx_flush();
+        Error_Handler();
+    }
+}
+
+void latency_loop(bool slept, const char * slowest)
+{
+    uint32_t now = timebase_us32();
+    if(loop_started && !slept) {
+        uint32_t us = now - loop_last_us;
+        if(us > loop_hist.max) loop_worst_task = slowest;
+        hist_add(&loop_hist, us);
+        latency_check("loop", us, slowest, &loop_overruns);
+    }
+    if(rx_early) {
+        rx_early = false;
+        hist_add(&rx_hist, rx_early_us);
+        latency_check("RX", rx_early_us, NULL, &rx_overruns);
+    }
+    loop_last_us = timebase_us32(); // not counting any log message
+    loop_started = true;
+}
+
+void latency_rx_idle(uint16_t dma_pos)
+{
+    // The idle line is detected one character time (10 bits) after the last stop bit
+    uint32_t arrival_us = timebase_us32() - 10000000 / huart2.Init.BaudRate;
+    if(rx_read_pos == dma_pos) {
+        // Already read - a busy main loop polls the ring buffer before the line goes idle
+        int32_t us = (int32_t)(rx_read_us - arrival_us);
+        rx_early_us = us > 0 ? (uint32_t)us : 0;
+        rx_early = true;
+        return;
+    }
+    rx_arrival_us = arrival_us;
+    rx_pos = dma_pos;
+    rx_pending = true;
+}
+
+void latency_rx_read(uint16_t read_pos)
+{
+    rx_read_us = timebase_us32();
+    rx_read_pos = read_pos;
+    if(!rx_pending || read_pos != rx_pos) return;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq(); // another burst may be arriving
+    uint32_t us = timebase_us32() - rx_arrival_us;
+    bool match = rx_pending && read_pos == rx_pos;
+    rx_pending = false;
+    __set_PRIMASK(primask);
+    if(!match) return;
+    hist_add(&rx_hist, us);
+    latency_check("RX", us, NULL, &rx_overruns);
+}
+
+static void latency_clear(void)
+{
+    hist_clear(&loop_hist);
+    hist_clear(&rx_hist);
+    loop_worst_task = NULL;
+    loop_started = false;
+    loop_overruns = rx_overruns = 0;
+}
+
+// latency [clear|budget <us> [count|log|assert]] - main loop and console RX latency
+int cl_latency(void)
+{
+    static const char * const action_names[] = {"count","log","assert"};
+    if(argc > 1 && !strcmp(argv[1],"clear")) {
+        latency_clear();
+        return 0;
+    }
+    if(argc > 2 && !strcmp(argv[1],"budget")) {
+        int action = LATENCY_ACTION_COUNT;
+        if(argc > 3) {
+            for(action=LATENCY_ACTION_COUNT;action<=LATENCY_ACTION_ASSERT;action++) {
+                if(!strcmp(argv[3],action_names[action])) break;
+            }
+            if(action > LATENCY_ACTION_ASSERT) {
+                printf("Unknown action \"%s\"\n",argv[3]);
+                return 1;
+            }
+        }
+        budget_action = (LATENCY_ACTION)action;
+        budget_us = (uint32_t)strtol(argv[2], NULL, 0);
+        loop_overruns = rx_overruns = 0;
+        return 0;
+    }
+    if(argc > 1) {
+        printf("Unknown option \"%s\"\n",argv[1]);
+        return 1;
+    }
+    printf("Main loop interval:\n");
+    hist_print(&loop_hist, "us");
+    if(loop_worst_task) printf("Longest after task \"%s\"\n", loop_worst_task);
+    printf("\nConsole RX delay:\n");
+    hist_print(&rx_hist, "us");
+    if(budget_us)
+        printf("\nBudget %lu us (%s): loop over %lu times, RX over %lu times\n", budget_us,
+                action_names[budget_action], loop_overruns, rx_overruns);
+    return 0;
+}
@@ -23,6 +23,19 @@
 //#include <stdlib.h>
 #include <stdint.h> // uint8_t
 #include "command_line.h"
+#include "sched.h"
+#include "kernel.h"
+#include "acquire.h"
+#include "ringbuf.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "dwt.h"
+#include "prof.h"
+#include "power.h"
+#include "latency.h"
+#include "mem.h"
+#include "pool.h"
+#include "boot.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
@@ -45,10 +58,12 @@
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
+TIM_HandleTypeDef htim3;
 TIM_HandleTypeDef htim4;
 
 UART_HandleTypeDef huart2;
 DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -60,6 +75,7 @@ static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_TIM4_Init(void);
+static void MX_TIM3_Init(void);
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -69,47 +85,116 @@ static void MX_TIM4_Init(void);
 #define HAL_SMALL_WAIT  40
 
 // Define serial input and output functions using UART2
-// DMA Buffer for usart2 RX
-//#define USART2_RX_DMA_BUFFER_SIZE 1030 // any size will do, but we may want to choose X-Modem 1K receive size
-#define USART2_RX_DMA_BUFFER_SIZE 80
-uint8_t usart2_rx_dma_buffer[USART2_RX_DMA_BUFFER_SIZE];
-
-// Implement a get_byte(void) function that utilizes a circular DMA RX buffer that:
-// 1) Tests if data is available in the DMA RX buffer
-// 2) Pulls and returns the data
-// 3) Manages an index_out value for next removal of data
-// 4) As a non-blocking function, return EOF when no bytes are available, else returns data byte
-int __io_getchar(void)
+// Both directions use DMA, with lock-free SPSC ring buffers (ringbuf.h) between DMA and application
+// RX: DMA writes the ring buffer directly (circular mode), __io_getchar() is the consumer
+// TX: __io_putchar() is the producer, DMA sends contiguous spans directly from the ring buffer
+#define USART2_RX_DMA_BUFFER_SIZE 128 // power of two, see ringbuf.h
+#define USART2_TX_BUFFER_SIZE     256 // power of two
+static uint8_t usart2_rx_dma_buffer[USART2_RX_DMA_BUFFER_SIZE];
+static uint8_t usart2_tx_buffer[USART2_TX_BUFFER_SIZE];
+static RINGBUF uart_rx;
+static RINGBUF uart_tx;
+static volatile uint16_t uart_tx_dma_len; // bytes being sent by DMA, 0: DMA idle
+
+// Start DMA transfer of the next contiguous block of the TX ring buffer, if DMA is idle
+static void uart_tx_start(void)
 {
-#if 1
-	// The following supports STM32-F103RB for UART DMA Receive
-	static uint16_t index_out = 0;
-	uint16_t index_in = USART2_RX_DMA_BUFFER_SIZE - huart2.hdmarx->Instance->CNDTR;
-	if(index_in == index_out) return EOF;
-	// Else, we have a byte in buffer to return
-	uint8_t data = usart2_rx_dma_buffer[index_out];
-	// advance index
-	index_out++;
-	// wrap index when necessary
-	if(index_out >= USART2_RX_DMA_BUFFER_SIZE) index_out = 0;
-	return data;
-
-#else
-	// Brain dead polling
-	char ch;
-	if(HAL_OK == HAL_UART_Receive(&huart2, (uint8_t *)&ch, 1, 50))
-	    return ch;
-	else
-		return EOF;
-#endif
+    PROF_ENTER(UART_TX_START);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq(); // called from both thread and DMA complete interrupt
+    if(!uart_tx_dma_len) {
+        uint8_t * ptr;
+        uint16_t len = ringbuf_read_span(&uart_tx, &ptr);
+        if(len) {
+            uart_tx_dma_len = len;
+            HAL_DMA_Start_IT(&hdma_usart2_tx, (uint32_t)ptr, (uint32_t)&huart2.Instance->DR, len);
+        }
+    }
+    __set_PRIMASK(primask);
+    PROF_EXIT(UART_TX_START);
+}
+
+// DMA transfer complete - release the bytes sent, start the next block
+static void uart_tx_dma_complete(DMA_HandleTypeDef * hdma)
+{
+    (void)hdma;
+    ringbuf_read_commit(&uart_tx, uart_tx_dma_len);
+    uart_tx_dma_len = 0;
+    uart_tx_start();
+}
+
+static void uart_start(void)
+{
+    ringbuf_init(&uart_rx, usart2_rx_dma_buffer, USART2_RX_DMA_BUFFER_SIZE);
+    ringbuf_init(&uart_tx, usart2_tx_buffer, USART2_TX_BUFFER_SIZE);
+    HAL_UART_Receive_DMA(&huart2, usart2_rx_dma_buffer, USART2_RX_DMA_BUFFER_SIZE);
+    // HAL_UART_IRQHandler() aborts DMA reception on any receive error - leave error interrupts off
+    CLEAR_BIT(huart2.Instance->CR3, USART_CR3_EIE);
+    CLEAR_BIT(huart2.Instance->CR1, USART_CR1_PEIE);
+    // The idle line interrupt (after a character or burst of characters) wakes the command line
+    __HAL_UART_CLEAR_IDLEFLAG(&huart2);
+    __HAL_UART_ENABLE_IT(&huart2, UART_IT_IDLE);
+    hdma_usart2_tx.XferCpltCallback = uart_tx_dma_complete;
+    SET_BIT(huart2.Instance->CR3, USART_CR3_DMAT); // USART requests DMA when TX register is empty
+}
+
+// True while TX data is buffered or being sent
+bool uart_tx_busy(void)
+{
+    return ringbuf_count(&uart_tx) || uart_tx_dma_len || !(huart2.Instance->SR & USART_SR_TC);
+}
+
+// Wait for all buffered TX data to be sent (before reset, clock change, etc.)
+void uart_tx_flush(void)
+{
+    fflush(stdout); // stdio's line buffer first
+    while(ringbuf_count(&uart_tx) || uart_tx_dma_len) ;
+    while(!(huart2.Instance->SR & USART_SR_TC)) ; // last byte shifted out
+}
 
+// Non-blocking read: returns EOF when no bytes are available, else returns data byte
+int __io_getchar(void)
+{
+    // The DMA's position in the buffer is the ring buffer's head
+    ringbuf_dma_head(&uart_rx, USART2_RX_DMA_BUFFER_SIZE - huart2.hdmarx->Instance->CNDTR);
+    int data = ringbuf_get(&uart_rx);
+    if(data < 0) return EOF;
+    latency_rx_read(uart_rx.tail & (USART2_RX_DMA_BUFFER_SIZE - 1));
+    return data;
 }
 
+// Buffered write: waits for room in the TX ring buffer.  When called with interrupts disabled,
+// or from an interrupt handler, waiting could dead-lock, so the character is dropped instead.
 int __io_putchar(int ch)
 {
-    HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, HAL_SMALL_WAIT);
+    PROF_ENTER(PUTCHAR);
+    while(!ringbuf_free(&uart_tx)) {
+        if(__get_PRIMASK() || __get_IPSR()) {
+            uart_tx.overflows++;
+            return 1;
+        }
+    }
+    ringbuf_put(&uart_tx, (uint8_t)ch);
+    uart_tx_start();
+    PROF_EXIT(PUTCHAR);
     return 1;
 }
+
+#if KERNEL_ENABLED
+// The command line, and the cooperative tasks started by commands, run as the "cli" kernel task
+#define CLI_STACK_WORDS 384
+static uint32_t cli_stack[CLI_STACK_WORDS];
+static KTASK cli_ktask;
+
+static void cli_task(void * arg)
+{
+    (void)arg;
+    while(1) {
+        if(sched_run())
+            sched_idle(); // blocks until an interrupt makes work for a task
+    }
+}
+#endif
 /* USER CODE END 0 */
 
 /**
@@ -120,7 +205,9 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+  mem_paint(); // stack high water mark, see "mem"
+  dwt_init(); // CPU cycle counter
+  boot_start(); // boot time profile (boot.h)
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -129,14 +216,14 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  boot_mark(BOOT_STAGE_HAL_INIT);
   /* USER CODE END Init */
 
   /* Configure the system clock */
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  boot_mark(BOOT_STAGE_CLOCK);
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
@@ -144,18 +231,37 @@ int main(void)
   MX_DMA_Init();
   MX_USART2_UART_Init();
   MX_TIM4_Init();
+  MX_TIM3_Init();
   /* USER CODE BEGIN 2 */
+  boot_mark(BOOT_STAGE_MX_INIT);
   //setvbuf(stdout, NULL, _IONBF, 0);	// Disable stdio output buffering
   // Define DMA buffer for UART peripheral
-  HAL_UART_Receive_DMA(&huart2, usart2_rx_dma_buffer, USART2_RX_DMA_BUFFER_SIZE);
+  uart_start(); // UART RX and TX DMA with ring buffers
+  boot_mark(BOOT_STAGE_UART);
+  timebase_init(); // 64-bit microsecond time, TIM4 chained to TIM3
+  boot_mark(BOOT_STAGE_TIMEBASE);
+  prof_init(); // measure the profiling marker overhead (prof.h)
+  boot_mark(BOOT_STAGE_PROF);
+  pool_init(); // fixed block allocator (pool.h)
+  boot_mark(BOOT_STAGE_POOL);
   cl_setup(); // calls setvbuf()
+  boot_finish(); // greeting, I2C bus check and prompt - or a task for them (BOOT_FAST_START)
+  mem_boot_done(); // the heap shouldn't grow from here on
+#if KERNEL_ENABLED
+  kernel_init();
+  kernel_task_create(&cli_ktask, "cli", cli_task, NULL, cli_stack, CLI_STACK_WORDS, KERNEL_PRIORITY_CLI);
+  acq_init();
+  kernel_start(); // does not return
+#endif
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	cl_loop();	// check for serial character input for command line
+	// run the command line task and any command tasks (i2cscan, delaytest, ...)
+	if(sched_run())
+		sched_idle();	// all tasks idle - sleep until an interrupt (power.h)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -202,6 +308,52 @@ void SystemClock_Config(void)
   }
 }
 
+/**
+  * @brief TIM3 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM3_Init(void)
+{
+
+  /* USER CODE BEGIN TIM3_Init 0 */
+
+  /* USER CODE END TIM3_Init 0 */
+
+  TIM_SlaveConfigTypeDef sSlaveConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM3_Init 1 */
+  // TIM3 counts TIM4 update events (ITR3), upper 16 bits of the 32-bit timebase - see timebase.h
+  /* USER CODE END TIM3_Init 1 */
+  htim3.Instance = TIM3;
+  htim3.Init.Prescaler = 0;
+  htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim3.Init.Period = 65535;
+  htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sSlaveConfig.SlaveMode = TIM_SLAVEMODE_EXTERNAL1;
+  sSlaveConfig.InputTrigger = TIM_TS_ITR3;
+  if (HAL_TIM_SlaveConfigSynchro(&htim3, &sSlaveConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim3, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM3_Init 2 */
+
+  /* USER CODE END TIM3_Init 2 */
+
+}
+
 /**
   * @brief TIM4 Initialization Function
   * @param None
@@ -235,7 +387,7 @@ static void MX_TIM4_Init(void)
   {
     Error_Handler();
   }
-  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
   sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
   if (HAL_TIMEx_MasterConfigSynchronization(&htim4, &sMasterConfig) != HAL_OK)
   {
@@ -294,6 +446,9 @@ static void MX_DMA_Init(void)
   /* DMA1_Channel6_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+  /* DMA1_Channel7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
 
 }
 
@@ -349,6 +504,26 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+// Console RX DMA half / full buffer - a long burst of characters, wake the command line
+// before the idle line interrupt, so the ring buffer doesn't overflow
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+    if(huart == &huart2) sched_notify();
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if(huart == &huart2) sched_notify();
+}
+
+// Display UART ring buffer statistics
+int cl_uart(void)
+{
+    printf("Ring  Size  Count  High water  Overflows\n");
+    printf("RX    %4u   %4u        %4u  %9s\n", uart_rx.size, ringbuf_count(&uart_rx), uart_rx.high_water, "-");
+    printf("TX    %4u   %4u        %4u  %9lu\n", uart_tx.size, ringbuf_count(&uart_tx), uart_tx.high_water, uart_tx.overflows);
+    return 0;
+}
 
 /* USER CODE END 4 */
 
@@ -0,0 +1,75 @@
+/*
+ * mem.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  RAM usage - see mem.h
+ */
+
+#include <stdio.h>  // printf()
+#include <malloc.h> // mallinfo()
+#include "mem.h"
+#include "command_line.h"
+#include "main.h"   // __get_MSP()
+
+// Linker script symbols
+extern uint32_t _sdata, _edata, _sbss, _ebss, _snoinit, _enoinit, _end, _estack;
+extern uint32_t _Min_Heap_Size, _Min_Stack_Size; // values are the symbols' addresses
+
+static uint8_t * boot_heap_end;  // heap end after initialization
+
+void mem_boot_done(void)
+{
+    boot_heap_end = sysmem_heap_end();
+}
+
+// Fill the free RAM between the heap and the stack.  Called before anything is allocated.
+void mem_paint(void)
+{
+    uint32_t * p = (uint32_t *)(((uint32_t)sysmem_heap_end() + 3) & ~3UL);
+    uint32_t * sp = (uint32_t *)(__get_MSP() - MEM_PAINT_MARGIN);
+    while(p < sp) *p++ = MEM_STACK_FILL;
+}
+
+// Lowest stack address written since mem_paint(), found from the top of the heap up
+static uint32_t * mem_stack_low(void)
+{
+    uint32_t * p = (uint32_t *)(((uint32_t)sysmem_heap_end() + 3) & ~3UL);
+    uint32_t * sp = (uint32_t *)__get_MSP();
+    while(p < sp && *p == MEM_STACK_FILL) p++;
+    return p;
+}
+
+uint32_t mem_stack_peak(void)
+{
+    return (uint32_t)&_estack - (uint32_t)mem_stack_low();
+}
+
+// mem - RAM usage
+int cl_mem(void)
+{
+    uint32_t ram_start = (uint32_t)&_sdata;
+    uint32_t ram_size = (uint32_t)&_estack - ram_start;
+    uint32_t data = (uint32_t)&_edata - (uint32_t)&_sdata;
+    uint32_t bss = (uint32_t)&_ebss - (uint32_t)&_sbss;
+    uint32_t heap = (uint32_t)sysmem_heap_end() - (uint32_t)&_end;
+    uint32_t heap_peak = (uint32_t)sysmem_heap_peak() - (uint32_t)&_end;
+    uint32_t stack_peak = mem_stack_peak();
+    uint32_t stack_min = (uint32_t)&_Min_Stack_Size;
+    uint32_t free = (uint32_t)mem_stack_low() - (uint32_t)sysmem_heap_peak();
+    struct mallinfo mi = mallinfo();
+
+    printf("RAM      %6lu bytes at 0x%08lX\n", ram_size, ram_start);
+    printf(".data    %6lu\n", data);
+    printf(".bss     %6lu\n", bss);
+    printf(".noinit  %6lu\n", (uint32_t)&_enoinit - (uint32_t)&_snoinit);
+    printf("Heap     %6lu, peak %lu (_Min_Heap_Size %lu), malloc in use %u, %lu failed\n",
+            heap, heap_peak, (uint32_t)&_Min_Heap_Size, mi.uordblks, sysmem_sbrk_failures());
+    if(boot_heap_end)
+        printf("         grown %lu since start-up\n", (uint32_t)(sysmem_heap_peak() - boot_heap_end));
+    printf("Stack    %6lu peak, now %lu (_Min_Stack_Size %lu)%s\n", stack_peak,
+            (uint32_t)&_estack - __get_MSP(), stack_min, stack_peak > stack_min ? " - over!" : "");
+    printf("Free     %6lu never used (%lu%%)\n", free, free * 100 / ram_size);
+    return 0;
+}
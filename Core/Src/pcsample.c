@@ -0,0 +1,142 @@
+/*
+ * pcsample.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Statistical profiler - see pcsample.h
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include <string.h>
+#include "pcsample.h"
+#include "clock.h"
+#include "command_line.h"
+#include "main.h"   // HAL functions and defines for TIM2 and NVIC access
+
+#define PCSAMPLE_PROBES  8   // hash table slots tried before a sample is dropped
+
+typedef struct {
+    uint32_t addr;
+    uint32_t count;
+} PCSAMPLE_SLOT;
+
+static PCSAMPLE_SLOT pc_slots[PCSAMPLE_PC_SLOTS];
+static PCSAMPLE_SLOT lr_slots[PCSAMPLE_LR_SLOTS];
+static volatile uint32_t samples;
+static volatile uint32_t dropped;  // PC table full
+static uint32_t rate_hz;
+
+// Count an address, open addressing with a multiplicative hash
+static void pcsample_count(PCSAMPLE_SLOT * slots, uint32_t size, uint32_t addr)
+{
+    uint32_t index = ((addr >> 1) * 2654435761UL) >> 16;
+    for(int i=0;i<PCSAMPLE_PROBES;i++) {
+        PCSAMPLE_SLOT * slot = &slots[(index + i) & (size - 1)];
+        if(slot->addr == addr) {
+            slot->count++;
+            return;
+        }
+        if(!slot->count) {
+            slot->addr = addr;
+            slot->count = 1;
+            return;
+        }
+    }
+    if(slots == pc_slots) dropped++;
+}
+
+// Called by TIM2_IRQHandler() with the interrupted code's exception stack frame:
+// r0, r1, r2, r3, r12, lr, pc, xpsr
+void pcsample_isr(uint32_t * frame)
+{
+    TIM2->SR = ~TIM_SR_UIF;
+    samples++;
+    pcsample_count(pc_slots, PCSAMPLE_PC_SLOTS, frame[6]);
+    pcsample_count(lr_slots, PCSAMPLE_LR_SLOTS, frame[5] & ~1UL); // clear the Thumb bit
+}
+
+// Find the stack frame - bit 2 of EXC_RETURN (in lr) selects the process stack - and pass it on
+__attribute__((naked)) void TIM2_IRQHandler(void)
+{
+    __asm volatile(
+        "tst lr, #4      \n"
+        "ite eq          \n"
+        "mrseq r0, msp   \n"
+        "mrsne r0, psp   \n"
+        "b pcsample_isr  \n");
+}
+
+static void pcsample_start(uint32_t hz)
+{
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    TIM2->CR1 = 0;
+    TIM2->PSC = clock_apb1_timer_hz() / 1000000 - 1; // 1MHz count
+    TIM2->ARR = 1000000 / hz - 1;
+    TIM2->EGR = TIM_EGR_UG; // load the prescaler
+    TIM2->SR = 0;
+    TIM2->DIER = TIM_DIER_UIE;
+    HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+    TIM2->CR1 = TIM_CR1_CEN;
+    rate_hz = hz;
+}
+
+static void pcsample_stop(void)
+{
+    TIM2->CR1 = 0;
+    HAL_NVIC_DisableIRQ(TIM2_IRQn);
+}
+
+static void pcsample_clear(void)
+{
+    HAL_NVIC_DisableIRQ(TIM2_IRQn);
+    memset(pc_slots, 0, sizeof(pc_slots));
+    memset(lr_slots, 0, sizeof(lr_slots));
+    samples = dropped = 0;
+    if(TIM2->CR1 & TIM_CR1_CEN) HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+static void pcsample_dump(void)
+{
+    HAL_NVIC_DisableIRQ(TIM2_IRQn); // hold the counts still
+    printf("PCSAMPLE BEGIN rate=%lu samples=%lu dropped=%lu\n", rate_hz, samples, dropped);
+    for(int i=0;i<PCSAMPLE_PC_SLOTS;i++) {
+        if(pc_slots[i].count) printf("P %08lX %lu\n", pc_slots[i].addr, pc_slots[i].count);
+    }
+    for(int i=0;i<PCSAMPLE_LR_SLOTS;i++) {
+        if(lr_slots[i].count) printf("L %08lX %lu\n", lr_slots[i].addr, lr_slots[i].count);
+    }
+    printf("PCSAMPLE END\n");
+    if(TIM2->CR1 & TIM_CR1_CEN) HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+// pcsample [start [Hz]|stop|clear|dump] - PC sampling profiler
+int cl_pcsample(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"start")) {
+        uint32_t hz = argc > 2 ? (uint32_t)strtol(argv[2], NULL, 0) : PCSAMPLE_DEFAULT_HZ;
+        if(hz < 1 || hz > PCSAMPLE_MAX_HZ) {
+            printf("Rate must be 1 - %u Hz\n", PCSAMPLE_MAX_HZ);
+            return 1;
+        }
+        pcsample_clear();
+        pcsample_start(hz);
+    } else if(argc > 1 && !strcmp(argv[1],"stop")) {
+        pcsample_stop();
+    } else if(argc > 1 && !strcmp(argv[1],"clear")) {
+        pcsample_clear();
+    } else if(argc > 1 && !strcmp(argv[1],"dump")) {
+        pcsample_dump();
+        return 0;
+    } else if(argc > 1) {
+        printf("Unknown option \"%s\"\n", argv[1]);
+        return 1;
+    }
+    unsigned pcs = 0;
+    for(int i=0;i<PCSAMPLE_PC_SLOTS;i++) if(pc_slots[i].count) pcs++;
+    printf("Sampling %s at %lu Hz: %lu samples, %u PCs, %lu dropped\n",
+            (TIM2->CR1 & TIM_CR1_CEN) ? "running" : "stopped", rate_hz, samples, pcs, dropped);
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * pool.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Fixed block pool allocator - see pool.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "pool.h"
+#include "dwt.h"
+#include "command_line.h"
+#include "main.h"   // __disable_irq()
+
+typedef struct POOL_BLOCK {
+    struct POOL_BLOCK * next;
+} POOL_BLOCK;
+
+typedef struct {
+    uint8_t * start;        // first block
+    uint8_t * end;          // after the last block
+    uint16_t size;          // block size
+    uint16_t blocks;
+    POOL_BLOCK * free_list;
+    uint16_t free;
+    uint16_t min_free;      // low water mark
+    uint32_t free_map;      // bit per block, set while it's on the free list
+    uint32_t allocs;
+    uint32_t failures;      // no block of this class (or larger) free
+    uint32_t bad_frees;     // pointer not at the start of a block, or block already free
+} POOL;
+
+// One arena per class, word aligned
+#define POOL_ARENA_X(size, count) static uint32_t pool_arena_##size[(size) * (count) / 4]; \
+    _Static_assert((count) <= 32, "pool class of more than 32 blocks - see free_map");
+POOL_CLASSES(POOL_ARENA_X)
+
+#define POOL_INIT_X(size, count) \
+    {(uint8_t *)pool_arena_##size, (uint8_t *)pool_arena_##size + sizeof(pool_arena_##size), size, count},
+static POOL pools[POOL_CLASS_COUNT] = {
+    POOL_CLASSES(POOL_INIT_X)
+};
+
+void pool_init(void)
+{
+    for(int i=0;i<POOL_CLASS_COUNT;i++) {
+        POOL * pool = &pools[i];
+        pool->free_list = NULL;
+        for(uint8_t * block=pool->end - pool->size;block>=pool->start;block-=pool->size) {
+            ((POOL_BLOCK *)block)->next = pool->free_list;
+            pool->free_list = (POOL_BLOCK *)block;
+        }
+        pool->free = pool->min_free = pool->blocks;
+        pool->free_map = pool->blocks < 32 ? (1UL << pool->blocks) - 1 : UINT32_MAX;
+        pool->allocs = pool->failures = pool->bad_frees = 0;
+    }
+}
+
+void * pool_alloc(size_t size)
+{
+    POOL_BLOCK * block = NULL;
+    POOL * fit = NULL;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for(int i=0;i<POOL_CLASS_COUNT;i++) {
+        POOL * pool = &pools[i];
+        if(pool->size < size) continue;
+        if(!fit) fit = pool;
+        if(!pool->free_list) continue;
+        block = pool->free_list;
+        pool->free_list = block->next;
+        pool->free_map &= ~(1UL << ((uint8_t *)block - pool->start) / pool->size);
+        if(--pool->free < pool->min_free) pool->min_free = pool->free;
+        pool->allocs++;
+        break;
+    }
+    if(!block && fit) fit->failures++;
+    __set_PRIMASK(primask);
+    return block;
+}
+
+void pool_free(void * ptr)
+{
+    if(!ptr) return;
+    uint8_t * p = ptr;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for(int i=0;i<POOL_CLASS_COUNT;i++) {
+        POOL * pool = &pools[i];
+        if(p < pool->start || p >= pool->end) continue;
+        uint32_t offset = (uint32_t)(p - pool->start);
+        uint32_t bit = 1UL << offset / pool->size;
+        // Not the start of a block, or a double free (pushing the block again would hand it
+        // to two callers)
+        if(offset % pool->size || (pool->free_map & bit) || pool->free == pool->blocks) {
+            pool->bad_frees++;
+            break;
+        }
+        pool->free_map |= bit;
+        POOL_BLOCK * block = ptr;
+        block->next = pool->free_list;
+        pool->free_list = block;
+        pool->free++;
+        break;
+    }
+    __set_PRIMASK(primask);
+}
+
+// Average cycles for an allocate / free pair of each class
+static void pool_bench(void)
+{
+    #define POOL_BENCH_N 100
+    printf("Size  alloc+free cycles\n");
+    for(int i=0;i<POOL_CLASS_COUNT;i++) {
+        uint32_t start = dwt_cycles();
+        for(int n=0;n<POOL_BENCH_N;n++) pool_free(pool_alloc(pools[i].size));
+        printf("%4u  %lu\n", pools[i].size, (dwt_cycles() - start) / POOL_BENCH_N);
+    }
+}
+
+// pool [bench] - block pool statistics
+int cl_pool(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"bench")) {
+        pool_bench();
+        return 0;
+    }
+    if(argc > 1) {
+        printf("Unknown option \"%s\"\n",argv[1]);
+        return 1;
+    }
+    printf("Size  Blocks  Free  Min free    Allocs  Failures  Bad frees\n");
+    for(int i=0;i<POOL_CLASS_COUNT;i++) {
+        const POOL * pool = &pools[i];
+        printf("%4u  %6u  %4u  %8u  %8lu  %8lu  %9lu\n", pool->size, pool->blocks, pool->free, pool->min_free,
+                pool->allocs, pool->failures, pool->bad_frees);
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * power.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Idle power management - see power.h
+ *
+ *  The HAL RTC driver isn't part of this project, so the RTC is set up at the register level.
+ *  It only provides the stop mode wake-up alarm: the counter runs at POWER_RTC_HZ from the LSE.
+ *  The RTC (and LSE) are started the first time stop mode is selected, as the LSE can take
+ *  a second or two to start.
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "power.h"
+#include "sched.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "clock.h"
+#include "command_line.h"
+#include "main.h"   // HAL functions and defines for RTC, EXTI and PWR access
+
+#define LSE_STARTUP_MS  3000 // LSE start-up time, worst case is about 2 seconds
+
+static POWER_MODE power_mode = POWER_MODE_SLEEP;
+static bool rtc_ready;
+
+// Statistics
+static uint32_t stat_start_us;  // timebase_us32() when statistics were cleared
+static uint32_t stat_sleeps;
+static uint64_t stat_sleep_us;  // time spent in WFI
+static uint32_t stat_stops;
+static uint32_t stat_stop_ms;   // time spent in stop mode
+static uint32_t stat_wakes;     // wake latency measurements
+static uint32_t stat_wake_last; // us
+static uint32_t stat_wake_max;
+static uint64_t stat_wake_total;
+
+static void rtc_wait_write(void)
+{
+    while(!(RTC->CRL & RTC_CRL_RTOFF)) ; // previous write to RTC registers complete
+}
+
+static uint32_t rtc_counter(void)
+{
+    uint32_t high, low;
+    do {
+        high = RTC->CNTH;
+        low = RTC->CNTL;
+    } while(high != RTC->CNTH);
+    return (high << 16) | low;
+}
+
+static void rtc_set_alarm(uint32_t alarm)
+{
+    rtc_wait_write();
+    RTC->CRL |= RTC_CRL_CNF; // enter configuration mode
+    RTC->ALRH = alarm >> 16;
+    RTC->ALRL = alarm & 0xFFFF;
+    RTC->CRL &= ~RTC_CRL_CNF;
+    rtc_wait_write();
+}
+
+// Start the LSE and RTC, returns false if the LSE doesn't start (no 32.768kHz crystal fitted)
+static bool rtc_init(void)
+{
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess(); // RTC and RCC_BDCR are in the backup domain
+    if(!(RCC->BDCR & RCC_BDCR_RTCEN)) {
+        RCC->BDCR |= RCC_BDCR_LSEON;
+        uint32_t start = HAL_GetTick();
+        while(!(RCC->BDCR & RCC_BDCR_LSERDY)) {
+            if(HAL_GetTick() - start > LSE_STARTUP_MS) {
+                RCC->BDCR &= ~RCC_BDCR_LSEON;
+                return false;
+            }
+        }
+        RCC->BDCR |= RCC_BDCR_RTCSEL_LSE | RCC_BDCR_RTCEN;
+    }
+    // Wait for the RTC registers to synchronize with the APB1 clock
+    RTC->CRL &= ~RTC_CRL_RSF;
+    while(!(RTC->CRL & RTC_CRL_RSF)) ;
+    rtc_wait_write();
+    RTC->CRL |= RTC_CRL_CNF;
+    RTC->PRLH = 0;
+    RTC->PRLL = 32768 / POWER_RTC_HZ - 1;
+    RTC->CRL &= ~RTC_CRL_CNF;
+    rtc_wait_write();
+    // Alarm interrupt through EXTI line 17, wakes the processor from stop mode
+    RTC->CRH |= RTC_CRH_ALRIE;
+    EXTI->RTSR |= EXTI_RTSR_TR17;
+    EXTI->IMR |= EXTI_IMR_MR17;
+    HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+    // The console RX pin (PA3) is EXTI line 3, only unmasked while stopped
+    EXTI->FTSR |= EXTI_FTSR_TR3;
+    HAL_NVIC_SetPriority(EXTI3_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+    return true;
+}
+
+// RTC alarm - the wake-up itself is all that's needed
+void RTC_Alarm_IRQHandler(void)
+{
+    rtc_wait_write();
+    RTC->CRL &= ~RTC_CRL_ALRF;
+    EXTI->PR = EXTI_PR_PR17;
+}
+
+// Console RX start bit while stopped
+void EXTI3_IRQHandler(void)
+{
+    EXTI->IMR &= ~EXTI_IMR_MR3;
+    EXTI->PR = EXTI_PR_PR3;
+}
+
+// Stop until the RTC alarm, the button or a console character.  Called with interrupts disabled.
+static void power_stop(uint32_t idle_ms)
+{
+    uint32_t start = rtc_counter();
+    uint64_t ticks = (uint64_t)idle_ms * POWER_RTC_HZ / 1000;
+    if(ticks > 0x7FFFFFFF) ticks = 0x7FFFFFFF;
+    rtc_set_alarm(start + (uint32_t)ticks);
+    EXTI->PR = EXTI_PR_PR3;
+    EXTI->IMR |= EXTI_IMR_MR3;
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+    // Running from the HSI (8MHz) - restore the system clock before anything else
+    clock_restore();
+    EXTI->IMR &= ~EXTI_IMR_MR3;
+    // Account for the time stopped.  SysTick and TIM3/TIM4 didn't count.
+    // The timebase takes the raw interval, the remainder only carries uwTick's sub-ms part over.
+    static uint32_t remainder_us;
+    uint32_t stopped_us = (uint32_t)((uint64_t)(rtc_counter() - start) * 1000000 / POWER_RTC_HZ);
+    timebase_advance(stopped_us);
+    uint32_t tick_us = stopped_us + remainder_us;
+    uwTick += tick_us / 1000;
+    remainder_us = tick_us % 1000;
+    stat_stops++;
+    stat_stop_ms += tick_us / 1000;
+}
+
+void power_sleep(uint32_t idle_ms)
+{
+    if(power_mode == POWER_MODE_RUN) return;
+    if(power_mode == POWER_MODE_STOP && rtc_ready && idle_ms >= POWER_STOP_MIN_MS &&
+            !swtimer_pending() && !uart_tx_busy()) {
+        power_stop(idle_ms);
+        return;
+    }
+    uint32_t start = timebase_us32();
+    __WFI(); // wakes for a pending interrupt, which runs once interrupts are enabled again
+    stat_sleep_us += timebase_us32() - start;
+    stat_sleeps++;
+}
+
+void power_idle(uint32_t idle_ms)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    power_sleep(idle_ms);
+    __set_PRIMASK(primask);
+}
+
+void power_wake_latency(uint32_t us)
+{
+    stat_wake_last = us;
+    if(us > stat_wake_max) stat_wake_max = us;
+    stat_wake_total += us;
+    stat_wakes++;
+}
+
+static void power_clear_stats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stat_start_us = timebase_us32();
+    stat_sleeps = stat_sleep_us = 0;
+    stat_stops = stat_stop_ms = 0;
+    stat_wakes = stat_wake_last = stat_wake_max = 0;
+    stat_wake_total = 0;
+    __set_PRIMASK(primask);
+}
+
+// power [run|sleep|stop|clear] - select idle mode, display sleep time and wake latency
+int cl_power(void)
+{
+    static const char * const mode_names[] = {"run","sleep","stop"};
+    if(argc > 1) {
+        int mode;
+        for(mode=POWER_MODE_RUN;mode<=POWER_MODE_STOP;mode++) {
+            if(!strcmp(argv[1],mode_names[mode])) break;
+        }
+        if(mode == POWER_MODE_STOP && !rtc_ready) {
+            printf("Starting LSE and RTC...\n");
+            rtc_ready = rtc_init();
+            if(!rtc_ready) {
+                printf("LSE failed to start, stop mode not available\n");
+                return 1;
+            }
+        }
+        if(mode <= POWER_MODE_STOP)
+            power_mode = (POWER_MODE)mode;
+        else if(strcmp(argv[1],"clear")) {
+            printf("Unknown mode \"%s\"\n",argv[1]);
+            return 1;
+        }
+        power_clear_stats();
+    }
+    uint32_t elapsed_us = timebase_us32() - stat_start_us;
+    printf("Mode: %s\n", mode_names[power_mode]);
+    printf("Sleeps: %lu, asleep %lu ms of %lu ms (%lu%%)\n", stat_sleeps, (uint32_t)(stat_sleep_us / 1000), elapsed_us / 1000,
+            elapsed_us ? (uint32_t)(stat_sleep_us * 100 / elapsed_us) : 0);
+    printf("Stops: %lu, stopped %lu ms\n", stat_stops, stat_stop_ms);
+    printf("Wake latency: last %lu us, max %lu us, avg %lu us (%lu wakes)\n", stat_wake_last, stat_wake_max,
+            stat_wakes ? (uint32_t)(stat_wake_total / stat_wakes) : 0, stat_wakes);
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * prof.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Function level cycle profiler - see prof.h
+ */
+
+#include <stdio.h>  // printf()
+#include <string.h>
+#include "prof.h"
+#include "clock.h"
+#include "command_line.h"
+
+#if PROF_ENABLED
+#define PROF_SITE_NAME(id, name)  name,
+static const char * const site_names[PROF_SITE_COUNT] = {
+    PROF_SITES(PROF_SITE_NAME)
+};
+#undef PROF_SITE_NAME
+
+PROF_STATS prof_stats[PROF_SITE_COUNT];
+uint32_t prof_overhead;
+
+static void prof_clear(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(prof_stats, 0, sizeof(prof_stats));
+    for(int i=0;i<PROF_SITE_COUNT;i++) prof_stats[i].min = UINT32_MAX;
+    __set_PRIMASK(primask);
+}
+
+// Measure the markers themselves - the least of a few empty enter/exit pairs, interrupts disabled
+void prof_init(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    prof_overhead = 0;
+    uint32_t least = UINT32_MAX;
+    for(int i=0;i<8;i++) {
+        PROF_ENTER(CL_COMMAND);
+        PROF_EXIT(CL_COMMAND);
+        uint32_t cycles = prof_stats[PROF_CL_COMMAND].max;
+        if(cycles < least) least = cycles;
+        prof_stats[PROF_CL_COMMAND].max = 0;
+    }
+    prof_overhead = least;
+    __set_PRIMASK(primask);
+    prof_clear();
+}
+
+// prof [clear] - display cycles per profiled site, or reset them
+int cl_prof(void)
+{
+    if(argc > 1 && !strcmp(argv[1],"clear")) {
+        prof_clear();
+        return 0;
+    }
+    uint32_t mhz = clock_cycles_per_us();
+    printf("%lu cycles marker overhead removed, %lu MHz\n", prof_overhead, mhz);
+    printf("Site                  Calls   Total us     Avg cyc   Min cyc   Max cyc\n");
+    for(int i=0;i<PROF_SITE_COUNT;i++) {
+        PROF_STATS s = prof_stats[i]; // copy, it may be updating
+        if(!s.calls) continue;
+        printf("%-18s %8lu %10lu %11lu %9lu %9lu\n", site_names[i], s.calls, (uint32_t)(s.total / mhz),
+                (uint32_t)(s.total / s.calls), s.min, s.max);
+    }
+    return 0;
+}
+#else
+int cl_prof(void)
+{
+    printf("Profiling not compiled in, see PROF_ENABLED (prof.h)\n");
+    return 1;
+}
+#endif
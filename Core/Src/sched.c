@@ -0,0 +1,249 @@
+/*
+ * sched.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Cooperative (run to yield) task scheduler - see sched.h
+ *
+ *  sched_run() is called from the main loop.  Each pass calls every active task once,
+ *  in slot order.  The command line is itself a task (slot 0), so keyboard input, echo and
+ *  Ctrl-C processing continue while long running commands (i2cscan, delaytest, ...) execute.
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include <string.h>
+#include "sched.h"
+#include "command_line.h"
+#include "main.h"   // HAL functions and defines for timer access
+#include "timebase.h"
+#include "kernel.h"
+#include "power.h"
+#include "latency.h"
+
+static TASK tasks[SCHED_MAX_TASKS];
+static uint8_t next_id = 1; // job number assigned to next task started
+static volatile bool sched_pending;     // an interrupt may have made work for a task
+static volatile uint32_t sched_notify_us; // timebase_us32() of the first sched_notify() since the last pass
+static bool sched_waited;               // sched_idle() slept, measure the wake latency
+static TASK * sched_running;            // task being called by sched_run()
+static const char * sched_slowest;      // task taking the most time in the last pass
+#if KERNEL_ENABLED
+static KEVENT sched_event;              // the "cli" kernel task blocks here when idle
+static KTASK * sched_runner;            // kernel task calling sched_run(), NULL before kernel_start()
+#endif
+
+// Start a task, returning pointer to the task structure, or NULL if no slot is available
+TASK * sched_start(const char * name, TASK_FUNC function, void * ctx, bool foreground)
+{
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        TASK * task = &tasks[i];
+        if(task->flags & TASK_FLAG_ACTIVE) continue;
+        memset(task,0,sizeof(TASK));
+        task->name = name;
+        task->function = function;
+        task->ctx = ctx;
+        task->id = next_id++;
+        if(!next_id) next_id = 1; // job number 0 is not used
+        task->start_tick = HAL_GetTick();
+        task->flags = TASK_FLAG_ACTIVE | (foreground ? TASK_FLAG_FOREGROUND : 0);
+        // A task started by a quiet task (a "repeat -q" command) is quiet too
+        if(sched_running && (sched_running->flags & TASK_FLAG_QUIET))
+            task->flags |= TASK_FLAG_QUIET;
+        return task;
+    }
+    printf("No free task slot for \"%s\"\n",name);
+    return NULL;
+}
+
+// Request a task be cancelled.  The task is released at the next sched_run() pass,
+// so it always stops at a yield point (never in the middle of an I2C transaction)
+void sched_cancel(TASK * task)
+{
+    if(task && (task->flags & TASK_FLAG_ACTIVE))
+        task->flags |= TASK_FLAG_CANCEL;
+}
+
+// Cancel every foreground task - a command's task, and the "repeat" running it (Ctrl-C)
+void sched_cancel_foreground(void)
+{
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        if(tasks[i].flags & TASK_FLAG_FOREGROUND)
+            sched_cancel(&tasks[i]);
+    }
+}
+
+// Software timer callback - wake the sleeping task
+static void sched_wake(void * arg)
+{
+    ((TASK *)arg)->sleeping = 0;
+    sched_notify();
+}
+
+// Put a task to sleep for a number of microseconds - use TASK_SLEEP() from the task function
+void sched_sleep(TASK * task, uint32_t us)
+{
+    task->sleeping = 1;
+    swtimer_start(&task->timer, us, 0, sched_wake, task);
+}
+
+// Release a task's slot
+static void sched_release(TASK * task)
+{
+    swtimer_cancel(&task->timer);
+    task->flags = 0;
+}
+
+// Return the foreground task, or NULL if the command line isn't waiting on a task
+TASK * sched_foreground(void)
+{
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        if((tasks[i].flags & (TASK_FLAG_ACTIVE|TASK_FLAG_FOREGROUND)) == (TASK_FLAG_ACTIVE|TASK_FLAG_FOREGROUND))
+            return &tasks[i];
+    }
+    return NULL;
+}
+
+// Return an active task running the given function, or NULL if none
+TASK * sched_find(TASK_FUNC function)
+{
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        if((tasks[i].flags & TASK_FLAG_ACTIVE) && tasks[i].function == function)
+            return &tasks[i];
+    }
+    return NULL;
+}
+
+// Interrupt handlers call this when they may have made work for a task (character received,
+// timer expired, ...), to end sched_idle()
+void sched_notify(void)
+{
+    if(!sched_pending) {
+        sched_notify_us = timebase_us32();
+        sched_pending = true;
+    }
+#if KERNEL_ENABLED
+    kevent_signal(&sched_event);
+#endif
+}
+
+// Wait for sched_notify() - call when sched_run() returns true (all tasks idle)
+void sched_idle(void)
+{
+#if KERNEL_ENABLED
+    if(kernel_running()) {
+        // Block the "cli" kernel task.  When no task is ready, the kernel's idle task sleeps.
+        sched_waited = kevent_wait(&sched_event, KERNEL_WAIT_FOREVER);
+        return;
+    }
+#endif
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq(); // a notify between the check and WFI still wakes the WFI
+    if(!sched_pending) {
+        power_sleep(POWER_IDLE_FOREVER);
+        sched_waited = true;
+    }
+    __set_PRIMASK(primask);
+}
+
+// Call each active task once.  Returns true when every task is idle (TASK_RC_IDLE) or sleeping.
+bool sched_run(void)
+{
+    latency_loop(sched_waited, sched_slowest);
+    sched_slowest = NULL;
+    uint32_t slowest_us = 0;
+    if(sched_waited) {
+        sched_waited = false;
+        if(sched_pending) power_wake_latency(timebase_us32() - sched_notify_us);
+    }
+    sched_pending = false;
+#if KERNEL_ENABLED
+    sched_runner = kernel_running() ? kernel_current : NULL;
+#endif
+    bool idle = true;
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        TASK * task = &tasks[i];
+        if(!(task->flags & TASK_FLAG_ACTIVE)) continue;
+        if(task->flags & TASK_FLAG_CANCEL) {
+            sched_release(task);
+            idle = false;
+            continue;
+        }
+        if(task->sleeping) continue;
+        uint32_t start_us = timebase_us32();
+        bool quiet = task->flags & TASK_FLAG_QUIET;
+        if(quiet) fflush(stdout); // other tasks' partial lines still go out
+        sched_running = task;
+        int rc = (*task->function)(task);
+        if(quiet) fflush(stdout); // discard this task's partial line
+        sched_running = NULL;
+        uint32_t elapsed = timebase_us32() - start_us;
+        task->runs++;
+        task->run_us += elapsed;
+        if(elapsed > task->max_us) task->max_us = elapsed;
+        if(elapsed >= slowest_us) {
+            slowest_us = elapsed;
+            sched_slowest = task->name;
+        }
+        if(rc == TASK_RC_DONE)
+            sched_release(task);
+        if(rc != TASK_RC_IDLE)
+            idle = false;
+    }
+    fflush(stdout); // partial lines (prompt, echo, progress) - stdout is line buffered
+    return idle;
+}
+
+// The task sched_run() is calling, or NULL.  From another kernel task (one that preempted the
+// task calling sched_run()), NULL.
+TASK * sched_current(void)
+{
+#if KERNEL_ENABLED
+    if(kernel_running() && kernel_current != sched_runner) return NULL;
+#endif
+    return sched_running;
+}
+
+// True if console output is to be discarded - the running task is quiet
+bool sched_quiet(void)
+{
+    TASK * task = sched_current();
+    return task && (task->flags & TASK_FLAG_QUIET);
+}
+
+// Display active tasks with their run time accounting
+int cl_jobs(void)
+{
+    printf("Job Name        Mode  Calls       Run ms   Max us  CPU%%\n");
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        TASK * task = &tasks[i];
+        if(!(task->flags & TASK_FLAG_ACTIVE)) continue;
+        uint32_t alive_ms = HAL_GetTick() - task->start_tick;
+        unsigned cpu = alive_ms ? (unsigned)((task->run_us / 10) / alive_ms) : 0; // percent
+        printf("%3u %-11s %-4s %7lu %10lu %8lu %4u\n", task->id, task->name,
+                task->sleeping ? "zz" : (task->flags & TASK_FLAG_FOREGROUND) ? "fg" : "bg",
+                task->runs, task->run_us / 1000, task->max_us, cpu);
+    }
+    return 0;
+}
+
+// Cancel a task, using the job number displayed by "jobs"
+int cl_kill(void)
+{
+    unsigned id = (unsigned) strtol(argv[1], NULL, 0);
+    for(int i=0;i<SCHED_MAX_TASKS;i++) {
+        TASK * task = &tasks[i];
+        if((task->flags & TASK_FLAG_ACTIVE) && task->id == id) {
+            if(i == 0) {
+                printf("Can't kill \"%s\"\n",task->name);
+                return 1;
+            }
+            sched_cancel(task);
+            printf("[%u] %s cancelled\n",task->id,task->name);
+            return 0;
+        }
+    }
+    printf("Job %u not found\n",id);
+    return 1;
+}
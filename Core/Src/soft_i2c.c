@@ -26,7 +26,33 @@
 #include <stdbool.h>
 #include "soft_i2c.h"
 #include "main.h"   // HAL functions and defines for timer and GPIO access
+#include "command_line.h" // cl_start_task()
+#include "sched.h"
+#include "timebase.h"
+#include "i2c_trace.h"
+#include "i2c_txtrace.h"
+#include "i2c_stats.h"
+#include "prof.h"
 #include <stdio.h> // printf()
+#include <string.h> // memset()
+
+KMUTEX i2c_bus_mutex; // priority inheritance mutex, see kernel.h
+
+// UM10204 Table 10 minimums, see soft_i2c.h
+static const I2C_TIMING timings[I2C_SPEEDS] = {
+	//  name        max KHz LOW                HIGH                START            STOP            RESTART            BUF
+	{"standard",    100,    I2C_SCL_LOW_DELAY, I2C_SCL_HIGH_DELAY, I2C_START_DELAY, I2C_STOP_DELAY, I2C_RESTART_DELAY, I2C_BUF_DELAY},
+	{"fast",        400,    3,                 2,                  2,               2,              1,                 2},
+};
+
+static I2C_SPEED speed = I2C_SPEED_STANDARD;
+static const I2C_TIMING * timing = &timings[I2C_SPEED_STANDARD]; // current speed, guarded by i2c_bus_mutex
+static uint16_t bus_free_us; // timebase_cnt16() at the last STOP, see soft_i2c_start()
+static bool bus_busy;        // between a START and its STOP: the next START is a repeated START
+
+// Current transaction - guarded by i2c_bus_mutex
+static I2C_STATS tx_stats;  // counts, added to the statistics (i2c_stats.h) at the end
+static bool scl_timeout;    // SCL held low too long, the transaction is abandoned
 
 // Delay a quantity of microseconds
 // This can be as simple as a for-loop, counting to some number that creates 1us,
@@ -34,9 +60,10 @@
 // To manage counter/timer roll-over, a delta-time is always used
 void i2c_delay_us(uint16_t delay_us)
 {
-    volatile TIM_TypeDef *TIMx = TIM4; // Establish pointer to timer 4 registers
-	uint16_t start_us = TIMx->CNT; // read us hardware timer
-	while((TIMx->CNT - start_us) < delay_us); // spin while delta time is less than requested time
+	PROF_ENTER(I2C_DELAY);
+	uint16_t start_us = timebase_cnt16(); // read us hardware timer
+	while((uint16_t)(timebase_cnt16() - start_us) < delay_us); // spin while delta time is less than requested time
+	PROF_EXIT(I2C_DELAY);
 }
 
 void soft_i2c_init(void)
@@ -58,7 +85,10 @@ void soft_i2c_init(void)
 //   true  (1): pin floats, pulled high by pull-up resistor
 void soft_i2c_scl_write(bool pinstate)
 {
+	PROF_ENTER(GPIO_WRITE);
 	HAL_GPIO_WritePin(Soft_SCL_GPIO_Port, Soft_SCL_Pin, (GPIO_PinState) pinstate);
+	PROF_EXIT(GPIO_WRITE);
+	i2c_trace_line(I2C_TRACE_SCL, pinstate);
 }
 
 // Implement a function to write boolean value to SDA pin such that when
@@ -66,7 +96,10 @@ void soft_i2c_scl_write(bool pinstate)
 //   true  (1): pin floats, pulled high by pull-up resistor
 void soft_i2c_sda_write(bool pinstate)
 {
+	PROF_ENTER(GPIO_WRITE);
 	HAL_GPIO_WritePin(Soft_SDA_GPIO_Port, Soft_SDA_Pin, (GPIO_PinState) pinstate);
+	PROF_EXIT(GPIO_WRITE);
+	i2c_trace_line(I2C_TRACE_SDA, pinstate);
 }
 
 // Implement a function to return state of SCL pin: false (0) low, true (1) high
@@ -78,7 +111,77 @@ bool soft_i2c_scl_read(void)
 // Implement a function to return state of SDA pin: false (0) low, true (1) high
 bool soft_i2c_sda_read(void)
 {
-	return (bool) HAL_GPIO_ReadPin(Soft_SDA_GPIO_Port,Soft_SDA_Pin);
+	bool sda = (bool) HAL_GPIO_ReadPin(Soft_SDA_GPIO_Port,Soft_SDA_Pin);
+	i2c_trace_sample(sda);
+	return sda;
+}
+
+// Release SCL, and wait while a slave holds it low (clock stretching), up to I2C_STRETCH_TIMEOUT_US.
+// The wait also covers the rise time of the line.  After a timeout, nothing more waits.
+static void soft_i2c_scl_release(void)
+{
+	soft_i2c_scl_write(true);
+	if(scl_timeout || soft_i2c_scl_read()) return;
+	uint32_t start = timebase_us32();
+	while(!soft_i2c_scl_read()) {
+		if(timebase_us32() - start >= I2C_STRETCH_TIMEOUT_US) {
+			scl_timeout = true;
+			break;
+		}
+	}
+	tx_stats.stretch_us += timebase_us32() - start;
+}
+
+// Free a bus a slave is holding: clock SCL until the slave releases SDA (up to 9 clocks), then STOP
+static void soft_i2c_recover(void)
+{
+	soft_i2c_sda_write(true);
+	for(unsigned i=0;i<9 && !soft_i2c_sda_read();i++) {
+		soft_i2c_scl_write(false);
+		i2c_delay_us(timing->low_us);
+		soft_i2c_scl_write(true);
+		i2c_delay_us(timing->high_us);
+	}
+	soft_i2c_scl_write(false);
+	i2c_delay_us(timing->low_us);
+	soft_i2c_stop();
+}
+
+// Check the bus is idle (SCL and SDA high).  A slave left holding SDA low, by a reset part way
+// through a read, is clocked free.  Returns false if the bus is still held.
+bool soft_i2c_bus_check(void)
+{
+	kmutex_lock(&i2c_bus_mutex);
+	if(!soft_i2c_scl_read() || !soft_i2c_sda_read()) {
+		memset(&tx_stats, 0, sizeof(tx_stats));
+		soft_i2c_recover();
+		tx_stats.recoveries = 1;
+		i2c_stats_add(0, &tx_stats, false); // counted for the bus only
+	}
+	bool idle = soft_i2c_scl_read() && soft_i2c_sda_read();
+	kmutex_unlock(&i2c_bus_mutex);
+	return idle;
+}
+
+// Select the bus speed, between transactions
+bool soft_i2c_set_speed(I2C_SPEED new_speed)
+{
+	if(new_speed >= I2C_SPEEDS) return false;
+	kmutex_lock(&i2c_bus_mutex);
+	speed = new_speed;
+	timing = &timings[new_speed];
+	kmutex_unlock(&i2c_bus_mutex);
+	return true;
+}
+
+I2C_SPEED soft_i2c_speed(void)
+{
+	return speed;
+}
+
+const I2C_TIMING * soft_i2c_timing(I2C_SPEED which)
+{
+	return which < I2C_SPEEDS ? &timings[which] : NULL;
 }
 
 // With SCL and SDA both high, lower SDA, delay, lower SCL
@@ -89,10 +192,24 @@ bool soft_i2c_sda_read(void)
 *       |
 *  SDA  |__________
 */
+// A repeated START (called with SCL low, part way through a transaction) first releases SDA, then
+// SCL, and waits tSU;STA.
 void soft_i2c_start(void)
 {
+	if(bus_busy) {
+		soft_i2c_sda_write(true);
+		i2c_delay_us(timing->low_us);
+		soft_i2c_scl_release();
+		i2c_delay_us(timing->restart_us);
+	} else {
+		// Bus free time: more than buf_us since the last STOP released SDA, so its rise completes and
+		// the STOP is seen.  Only a START soon after a STOP waits (or, after each 65.5ms wrap of the
+		// count, one that lands in the window).
+		while((uint16_t)(timebase_cnt16() - bus_free_us) <= timing->buf_us) ;
+	}
+	bus_busy = true;
 	soft_i2c_sda_write(false);
-	i2c_delay_us(I2C_START_DELAY);
+	i2c_delay_us(timing->start_us);
 	soft_i2c_scl_write(false);
 }
 
@@ -107,10 +224,12 @@ void soft_i2c_start(void)
 void soft_i2c_stop(void)
 {
 	soft_i2c_sda_write(false); // With SCL low, force SDA low
-	i2c_delay_us(I2C_SCL_LOW_DELAY);
-	soft_i2c_scl_write(true);
-	i2c_delay_us(I2C_STOP_DELAY);
+	i2c_delay_us(timing->low_us);
+	soft_i2c_scl_release();
+	i2c_delay_us(timing->stop_us);
 	soft_i2c_sda_write(true);
+	bus_free_us = timebase_cnt16();
+	bus_busy = false;
 }
 
 // With SCL low and SDA unknown, write 8 bit value, cycle SCL again, read ACK, return ACK value
@@ -124,6 +243,7 @@ void soft_i2c_stop(void)
 */
 bool soft_i2c_write8(uint8_t data_byte)
 {
+	PROF_ENTER(I2C_WRITE8);
 	// Write 8 data bits (data or address byte)
 	// Configure SDA for current bit being transmitted
 	for(unsigned i=0;i<8;i++) {
@@ -132,19 +252,20 @@ bool soft_i2c_write8(uint8_t data_byte)
 		else
 			soft_i2c_sda_write(false);
 		data_byte<<=1; // left shift for next pass
-		i2c_delay_us(I2C_SCL_LOW_DELAY);
-		soft_i2c_scl_write(true); // SCL high, delay, low
-		i2c_delay_us(I2C_SCL_HIGH_DELAY);
+		i2c_delay_us(timing->low_us);
+		soft_i2c_scl_release(); // SCL high, delay, low
+		i2c_delay_us(timing->high_us);
 		soft_i2c_scl_write(false);
 	}
 	// Data byte has been sent, read in slave's ACK response
 	soft_i2c_sda_write(true); // Allow SDA to float
-	i2c_delay_us(I2C_SCL_LOW_DELAY);
-	soft_i2c_scl_write(true);
+	i2c_delay_us(timing->low_us);
+	soft_i2c_scl_release();
 	bool ack = soft_i2c_sda_read();
-	i2c_delay_us(I2C_SCL_HIGH_DELAY);
+	i2c_delay_us(timing->high_us);
 	soft_i2c_scl_write(false);
-	return ack;
+	PROF_EXIT(I2C_WRITE8);
+	return ack || scl_timeout; // treat a timeout as NAK, ending the transfer
 }
 
 // With SCL low and SDA unknown, read 8 bit value, cycle SCL again, write ACK, return byte value read
@@ -152,50 +273,104 @@ bool soft_i2c_write8(uint8_t data_byte)
 // Send Most Significant Bit (MSB) first
 uint8_t soft_i2c_read8(bool ack)
 {
+	PROF_ENTER(I2C_READ8);
 	uint8_t data_byte = 0;
 	soft_i2c_sda_write(true); // allow SDA to float
 	// Read 8 data bits
 	// After raising SCL, read SDA for current bit being received
 	for(unsigned i=0;i<8;i++) {
-		i2c_delay_us(I2C_SCL_LOW_DELAY);
-		soft_i2c_scl_write(true); // SCL high
+		i2c_delay_us(timing->low_us);
+		soft_i2c_scl_release(); // SCL high
 		data_byte<<=1; // left shift for this pass
 		if(soft_i2c_sda_read())
 			data_byte |= 1; // set LSB
 		// Don't need to add in 0's. We started with zero'ed data byte
-		i2c_delay_us(I2C_SCL_HIGH_DELAY);
+		i2c_delay_us(timing->high_us);
 		soft_i2c_scl_write(false);
 	}
 	// Data byte has been sent, send slave desired ACK
 	soft_i2c_sda_write(ack); // Configure SDA for ACK bit
-	i2c_delay_us(I2C_SCL_LOW_DELAY);
-	soft_i2c_scl_write(true);
-	i2c_delay_us(I2C_SCL_HIGH_DELAY);
+	i2c_delay_us(timing->low_us);
+	soft_i2c_scl_release();
+	i2c_delay_us(timing->high_us);
 	soft_i2c_scl_write(false);
+	PROF_EXIT(I2C_READ8);
 	return data_byte;
 }
 
+// Start of a transaction, bus mutex held
+static void i2c_transaction_begin(void)
+{
+	memset(&tx_stats, 0, sizeof(tx_stats));
+	scl_timeout = false;
+}
+
+// End of a transaction, bus mutex held: recover from a timeout, count and trace the transaction.
+// Returns rc, or -2 after a timeout.
+static int i2c_transaction_end(int rc, uint8_t i2c_address, uint8_t flags, uint32_t start_us, uint32_t locked_us,
+		uint8_t write_count, uint8_t read_count)
+{
+	if(scl_timeout) {
+		tx_stats.timeouts = 1;
+		soft_i2c_recover();
+		tx_stats.recoveries = 1;
+		flags |= I2C_TX_TIMEOUT;
+		rc = -2;
+	}
+	if(rc) flags |= I2C_TX_NAK;
+	tx_stats.transactions = 1;
+	tx_stats.busy_us = timebase_us32() - locked_us;
+	i2c_stats_add(i2c_address, &tx_stats, !tx_stats.nak_addr && !scl_timeout);
+	i2c_txtrace_record(start_us, locked_us, i2c_address, flags, write_count, read_count);
+	return rc;
+}
+
 // Test for a device by writing a device address and see if the address is acknowledged
 // Returns true (1) if device is present
 bool i2c_device_ready(uint8_t i2c_address)
 {
+	uint32_t start_us = timebase_us32();
+	kmutex_lock(&i2c_bus_mutex);
+	uint32_t locked_us = timebase_us32();
+	i2c_transaction_begin();
 	soft_i2c_start();
 	bool rc = soft_i2c_write8(i2c_address << 1);
+	if(rc) tx_stats.nak_addr = 1;
 	soft_i2c_stop();
-	return !rc;
+	int result = i2c_transaction_end(rc ? -1 : 0, i2c_address, I2C_TX_PROBE, start_us, locked_us, 0, 0);
+	kmutex_unlock(&i2c_bus_mutex);
+	return !result;
 }
 
 // Implement a "generic I2C API" for writing to and then reading from an I2C device (in that order)
 // Initially, have both sections do their own START/STOP
+// Returns 0 on success, -1 if the address (or a data byte, other than the last) wasn't acknowledged,
+// -2 if a slave held SCL low for longer than I2C_STRETCH_TIMEOUT_US (the bus is then recovered)
 int i2c_write_read(uint8_t i2c_address, uint8_t * write_data, uint8_t write_count, uint8_t * read_data, uint8_t read_count)
 {
+	int rc = 0;
+	uint32_t start_us = timebase_us32();
+	kmutex_lock(&i2c_bus_mutex);
+	uint32_t locked_us = timebase_us32();
+	i2c_transaction_begin();
+	uint8_t flags = (write_data && write_count ? I2C_TX_WRITE : 0) | (read_data && read_count ? I2C_TX_READ : 0);
+	uint8_t write_total = write_data ? write_count : 0;
+	uint8_t read_total = read_data ? read_count : 0;
 	// If write_data and write_count are non-null, perform write(s) first
 	if(write_data && write_count) {
 		soft_i2c_start();
 		// Send address with the R/W bit set to 0, which signifies a write
-		soft_i2c_write8(i2c_address << 1);
-		while(write_count) {
-			soft_i2c_write8(*write_data);
+		if(soft_i2c_write8(i2c_address << 1)) {
+			tx_stats.nak_addr++;
+			rc = -1; // NAK
+		}
+		while(write_count && !rc) {
+			bool nak = soft_i2c_write8(*write_data);
+			tx_stats.bytes_written++;
+			if(nak && (write_count > 1 || scl_timeout)) {
+				tx_stats.nak_data++;
+				rc = -1; // a NAK is allowed for the last byte
+			}
 			write_data++;
 			write_count--;
 		} // while
@@ -203,42 +378,65 @@ int i2c_write_read(uint8_t i2c_address, uint8_t * write_data, uint8_t write_coun
 	}// write
 
 	// If read_data and read_count are non-null, perform read(s)
-	if(read_data && read_count) {
+	if(read_data && read_count && !rc) {
 		soft_i2c_start();
 		// Send address with the R/W bit set to 1, which signifies a read
-		soft_i2c_write8((i2c_address << 1) | 1);
-		while(read_count) {
+		if(soft_i2c_write8((i2c_address << 1) | 1)) {
+			tx_stats.nak_addr++;
+			rc = -1; // NAK, nobody to read from
+		}
+		while(read_count && !rc && !scl_timeout) {
 			*read_data = soft_i2c_read8(read_count==1?true:false); // for last read, send NAK
+			tx_stats.bytes_read++;
 			read_data++;
 			read_count--;
 		} // while
 		soft_i2c_stop();
 	}// read
-	return 0;
+	rc = i2c_transaction_end(rc, i2c_address, flags, start_us, locked_us, write_total, read_total);
+	kmutex_unlock(&i2c_bus_mutex);
+	return rc;
 }
 
 // Perform an I2C bus scan similar to Linux's i2cdetect, or Arduino's i2c_scanner sketch
-int cl_i2c_scan(void)
+// The scan runs as a task, yielding after each address probed, so the command line stays responsive
+typedef struct {
+    uint16_t addr; // address being probed
+} I2C_SCAN_CONTEXT;
+
+static I2C_SCAN_CONTEXT scan_ctx;
+
+static int i2c_scan_task(TASK * task)
 {
+    I2C_SCAN_CONTEXT * ctx = task->ctx;
+
+    TASK_BEGIN(task);
     printf("I2C Scan - scanning I2C addresses 0x%02X - 0x%02X\n",I2C_ADDRESS_MIN,I2C_ADDRESS_MAX);
     // Display Hex Header
     printf("    "); for(int i=0;i<=0x0F;i++) printf(" %0X ",i);
     // Walk through address range 0x00 - 0x77, but only test 0x03 - 0x77
-    for(uint16_t addr=0;addr<=I2C_ADDRESS_MAX;addr++) {
+    for(ctx->addr=0;ctx->addr<=I2C_ADDRESS_MAX;ctx->addr++) {
     	// If address defines the beginning of a row, start a new row and display row text
-    	if(!(addr%16)) printf("\n%02X: ",addr);
+    	if(!(ctx->addr%16)) printf("\n%02X: ",ctx->addr);
 		// Check I2C addresses in the range 0x03-0x7F
-		if(addr < I2C_ADDRESS_MIN || addr > I2C_ADDRESS_MAX) {
+		if(ctx->addr < I2C_ADDRESS_MIN || ctx->addr > I2C_ADDRESS_MAX) {
 			printf("   "); // out of range
 			continue;
 		}
-		// Perform I2C device detection - returns HAL_OK if device found
-		if(i2c_device_ready(addr))
-			printf("%02X ",addr);
+		// Perform I2C device detection - returns true if device found
+		if(i2c_device_ready(ctx->addr))
+			printf("%02X ",ctx->addr);
 		else
 			printf("-- ");
+		TASK_YIELD(task); // one probe per call
     } // for-loop
     printf("\n");
+    TASK_END(task);
+}
+
+int cl_i2c_scan(void)
+{
+    cl_start_task("i2cscan", i2c_scan_task, &scan_ctx);
     return 0;
 } // cl_i2c_scanner
 
@@ -257,3 +455,26 @@ int cl_i2c_read(void)
 	i2c_write_read(DS3231_ADDRESS, NULL, 0, &data, sizeof(data));
     return 0;
 }
+
+// List the bus speeds, or select one
+int cl_i2c_speed(void)
+{
+	if(argc > 1) {
+		int i;
+		for(i=0;i<I2C_SPEEDS;i++) {
+			if(!strcmp(argv[1], timings[i].name)) break;
+		}
+		if(i == I2C_SPEEDS) {
+			printf("No %s speed\n", argv[1]);
+			return 1;
+		}
+		soft_i2c_set_speed((I2C_SPEED)i);
+	}
+	printf("  Speed     Max KHz  tLOW  tHIGH  tHD;STA  tSU;STO  tSU;STA  tBUF (us)\n");
+	for(int i=0;i<I2C_SPEEDS;i++) {
+		const I2C_TIMING * t = &timings[i];
+		printf("%c %-9s %7u  %4u  %5u  %7u  %7u  %7u  %4u\n", i == (int)speed ? '*' : ' ', t->name, t->max_khz,
+				t->low_us, t->high_us, t->start_us, t->stop_us, t->restart_us, t->buf_us);
+	}
+	return 0;
+}
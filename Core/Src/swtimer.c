@@ -0,0 +1,250 @@
+/*
+ * swtimer.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Software timers - hierarchical timer wheel multiplexed on TIM4, see swtimer.h
+ *
+ *  Level 0 slot n holds timers expiring in granule n (mod 32).  When the wheel reaches a slot,
+ *  its timers move to the "due" list, and CC2 is set for the earliest of them.  Higher levels
+ *  hold timers further in the future.  Each time a lower level wraps, the next slot of the level
+ *  above is "cascaded" - its timers are re-inserted, landing in lower levels.
+ */
+
+#include <stdio.h>  // printf()
+#include <stdlib.h> // strtol()
+#include "swtimer.h"
+#include "command_line.h"
+#include "main.h"   // HAL functions and defines for timer access
+#include "timebase.h"
+
+extern TIM_HandleTypeDef htim4; // main.c
+
+#define LEVEL_SPAN(level)  (1UL << (SWTIMER_SLOT_BITS * (level)))  // granules per slot
+#define WHEEL_SPAN         LEVEL_SPAN(SWTIMER_LEVELS)              // granules covered by the wheel
+
+static SWTIMER * wheel[SWTIMER_LEVELS][SWTIMER_SLOTS];
+static SWTIMER * due;           // timers expiring in the current granule (or late)
+static uint32_t due_armed;      // CC2 is set for this expiry time, when due_active
+static bool due_active;
+static uint32_t wheel_jiffies;  // granule the wheel has been advanced to
+static uint16_t pending;        // active timers
+
+// Statistics
+static uint32_t stat_fired;
+static uint32_t stat_ticks;     // granules processed
+static uint32_t stat_late_max;  // us, callback later than expiry time
+static uint32_t stat_late_last;
+
+static void list_add(SWTIMER ** list, SWTIMER * timer)
+{
+    timer->list = list;
+    timer->prev = NULL;
+    timer->next = *list;
+    if(*list) (*list)->prev = timer;
+    *list = timer;
+}
+
+static void list_remove(SWTIMER * timer)
+{
+    if(timer->prev)
+        timer->prev->next = timer->next;
+    else
+        *timer->list = timer->next;
+    if(timer->next) timer->next->prev = timer->prev;
+    timer->list = NULL;
+}
+
+// Set compare register to the time given.  If the time has already passed, generate the
+// compare event by software, rather than waiting for the counter to wrap.
+static void arm_compare(volatile uint32_t * ccr, uint32_t event, uint32_t time)
+{
+    *ccr = (uint16_t)time;
+    if((int32_t)(timebase_us32() - time) >= 0)
+        TIM4->EGR = event;
+}
+
+static void due_add(SWTIMER * timer)
+{
+    list_add(&due, timer);
+    if(!due_active || (int32_t)(timer->expires - due_armed) < 0) {
+        due_active = true;
+        due_armed = timer->expires;
+        arm_compare(&TIM4->CCR2, TIM_EGR_CC2G, timer->expires);
+    }
+}
+
+static void wheel_insert(SWTIMER * timer)
+{
+    uint32_t expires_j = timer->expires >> SWTIMER_GRANULE_SHIFT;
+    int32_t delta = (int32_t)(expires_j - wheel_jiffies);
+    if(delta <= 0) {
+        due_add(timer); // expires in the current granule
+        return;
+    }
+    if((uint32_t)delta >= WHEEL_SPAN) {
+        // Beyond the wheel - park in the last slot, re-inserted when cascaded
+        delta = WHEEL_SPAN - 1;
+        expires_j = wheel_jiffies + delta;
+    }
+    int level = 0;
+    while(level < SWTIMER_LEVELS - 1 && (uint32_t)delta >= LEVEL_SPAN(level + 1))
+        level++;
+    list_add(&wheel[level][(expires_j >> (SWTIMER_SLOT_BITS * level)) & (SWTIMER_SLOTS - 1)], timer);
+}
+
+// Fire expired timers on the due list, then set CC2 for the earliest remaining
+static void process_due(void)
+{
+    due_active = false;
+    uint32_t now = timebase_us32();
+    SWTIMER * timer = due;
+    while(timer) {
+        if((int32_t)(now - timer->expires) < 0) {
+            timer = timer->next;
+            continue;
+        }
+        list_remove(timer);
+        uint32_t late = now - timer->expires;
+        stat_late_last = late;
+        if(late > stat_late_max) stat_late_max = late;
+        stat_fired++;
+        if(timer->period) {
+            timer->expires += timer->period;
+            if((int32_t)(now - timer->expires) >= 0)
+                timer->expires = now + timer->period; // fell behind, skip missed periods
+            wheel_insert(timer);
+        } else {
+            pending--;
+        }
+        (*timer->callback)(timer->arg);
+        timer = due; // callback may have changed the list, start over
+        now = timebase_us32();
+    }
+    // Set CC2 for the earliest remaining due timer
+    for(timer = due; timer; timer = timer->next) {
+        if(!due_active || (int32_t)(timer->expires - due_armed) < 0) {
+            due_active = true;
+            due_armed = timer->expires;
+        }
+    }
+    if(due_active)
+        arm_compare(&TIM4->CCR2, TIM_EGR_CC2G, due_armed);
+}
+
+// Advance the wheel to the current granule
+static void wheel_tick(void)
+{
+    uint32_t now_j;
+    while((int32_t)((now_j = timebase_us32() >> SWTIMER_GRANULE_SHIFT) - wheel_jiffies) > 0) {
+        while(wheel_jiffies != now_j) {
+            wheel_jiffies++;
+            stat_ticks++;
+            // Cascade higher levels at their boundaries, highest level first
+            int top = 0;
+            while(top < SWTIMER_LEVELS - 1 && !(wheel_jiffies & (LEVEL_SPAN(top + 1) - 1)))
+                top++;
+            for(int level = top; level > 0; level--) {
+                SWTIMER ** slot = &wheel[level][(wheel_jiffies >> (SWTIMER_SLOT_BITS * level)) & (SWTIMER_SLOTS - 1)];
+                while(*slot) {
+                    SWTIMER * timer = *slot;
+                    list_remove(timer);
+                    wheel_insert(timer);
+                }
+            }
+            // Timers in this level 0 slot expire during this granule
+            SWTIMER ** slot = &wheel[0][wheel_jiffies & (SWTIMER_SLOTS - 1)];
+            while(*slot) {
+                SWTIMER * timer = *slot;
+                list_remove(timer);
+                due_add(timer);
+            }
+        }
+    }
+    if(pending)
+        arm_compare(&TIM4->CCR1, TIM_EGR_CC1G, (wheel_jiffies + 1) << SWTIMER_GRANULE_SHIFT);
+    else
+        __HAL_TIM_DISABLE_IT(&htim4, TIM_IT_CC1 | TIM_IT_CC2); // nothing pending, stop the granule interrupt
+}
+
+void swtimer_start(SWTIMER * timer, uint32_t delay_us, uint32_t period_us, SWTIMER_CALLBACK callback, void * arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(timer->list) {
+        list_remove(timer); // restart
+        pending--;
+    }
+    uint32_t now = timebase_us32();
+    if(!pending) {
+        // Wheel was idle - bring it up to date, start the granule interrupt
+        wheel_jiffies = now >> SWTIMER_GRANULE_SHIFT;
+        __HAL_TIM_CLEAR_FLAG(&htim4, TIM_FLAG_CC1 | TIM_FLAG_CC2);
+        __HAL_TIM_ENABLE_IT(&htim4, TIM_IT_CC1 | TIM_IT_CC2);
+        arm_compare(&TIM4->CCR1, TIM_EGR_CC1G, (wheel_jiffies + 1) << SWTIMER_GRANULE_SHIFT);
+    }
+    timer->expires = now + delay_us;
+    timer->period = period_us;
+    timer->callback = callback;
+    timer->arg = arg;
+    pending++;
+    wheel_insert(timer);
+    __set_PRIMASK(primask);
+}
+
+void swtimer_cancel(SWTIMER * timer)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(timer->list) {
+        list_remove(timer); // if CC2 was set for this timer, process_due() simply finds nothing expired
+        pending--;
+    }
+    __set_PRIMASK(primask);
+}
+
+// Return true if any timer is active
+bool swtimer_pending(void)
+{
+    return pending != 0;
+}
+
+bool swtimer_active(const SWTIMER * timer)
+{
+    return timer->list != NULL;
+}
+
+// TIM4 compare interrupt callback, from HAL_TIM_IRQHandler()
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if(htim->Instance != TIM4) return;
+    if(htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1)
+        wheel_tick();
+    else if(htim->Channel == HAL_TIM_ACTIVE_CHANNEL_2)
+        process_due();
+}
+
+// Test timer callback - nothing to do, lateness is recorded by process_due()
+static void swtimer_test_callback(void * arg)
+{
+    (void)arg;
+}
+
+// timers [delay us] [period us] - display timer statistics, optionally start (or stop) a test timer
+int cl_timers(void)
+{
+    static SWTIMER test_timer;
+    if(argc > 1) {
+        uint32_t delay = (uint32_t) strtol(argv[1], NULL, 0);
+        uint32_t period = argc > 2 ? (uint32_t) strtol(argv[2], NULL, 0) : 0;
+        stat_late_max = 0;
+        if(delay)
+            swtimer_start(&test_timer, delay, period, swtimer_test_callback, NULL);
+        else
+            swtimer_cancel(&test_timer);
+    }
+    printf("Time: %lu us, pending: %u, granules: %lu\n", timebase_us32(), pending, stat_ticks);
+    printf("Fired: %lu, late: %lu us, max %lu us\n", stat_fired, stat_late_last, stat_late_max);
+    return 0;
+}
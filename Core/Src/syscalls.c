@@ -29,6 +29,8 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include "prof.h"
+#include "sched.h" // sched_quiet()
 
 
 /* Variables */
@@ -82,10 +84,13 @@ __attribute__((weak)) int _write(int file, char *ptr, int len)
   (void)file;
   int DataIdx;
 
+  if (sched_quiet()) return len; // output discarded, see "repeat -q"
+  PROF_ENTER(STDIO_WRITE);
   for (DataIdx = 0; DataIdx < len; DataIdx++)
   {
     __io_putchar(*ptr++);
   }
+  PROF_EXIT(STDIO_WRITE);
   return len;
 }
 
@@ -29,6 +29,12 @@
  */
 static uint8_t *__sbrk_heap_end = NULL;
 
+/**
+ * Heap usage statistics, see mem.h
+ */
+static uint8_t *__sbrk_heap_peak = NULL;
+static uint32_t __sbrk_failures = 0;
+
 /**
  * @brief _sbrk() allocates memory to the newlib heap and is used by malloc
  *        and others from the C library
@@ -68,12 +74,43 @@ void *_sbrk(ptrdiff_t incr)
   /* Protect heap from growing into the reserved MSP stack */
   if (__sbrk_heap_end + incr > max_heap)
   {
+    __sbrk_failures++;
     errno = ENOMEM;
     return (void *)-1;
   }
 
   prev_heap_end = __sbrk_heap_end;
   __sbrk_heap_end += incr;
+  if (__sbrk_heap_end > __sbrk_heap_peak)
+  {
+    __sbrk_heap_peak = __sbrk_heap_end;
+  }
 
   return (void *)prev_heap_end;
 }
+
+/**
+ * @brief Current end of the heap, '_end' before the first allocation
+ */
+uint8_t *sysmem_heap_end(void)
+{
+  extern uint8_t _end; /* Symbol defined in the linker script */
+  return __sbrk_heap_end ? __sbrk_heap_end : &_end;
+}
+
+/**
+ * @brief Highest end of the heap since start-up
+ */
+uint8_t *sysmem_heap_peak(void)
+{
+  extern uint8_t _end; /* Symbol defined in the linker script */
+  return __sbrk_heap_peak ? __sbrk_heap_peak : &_end;
+}
+
+/**
+ * @brief Number of _sbrk() calls refused (heap would grow into the MSP stack)
+ */
+uint32_t sysmem_sbrk_failures(void)
+{
+  return __sbrk_failures;
+}
@@ -0,0 +1,133 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Monotonic microsecond timebase - see timebase.h
+ *
+ *  TIM3 increments a few timer clocks after TIM4 wraps (trigger resynchronization).  The TIM4
+ *  count remains 0 for a full microsecond (72 timer clocks), and the TIM3 re-read that follows the
+ *  TIM4 read in timebase_us32() takes longer than the resynchronization, so the 32-bit read can
+ *  never see TIM4's wrap without TIM3's increment.
+ *
+ *  The SysTick variant (TIMEBASE_SYSTICK) reads the HAL tick and SysTick's count down, re-reading if
+ *  the tick changed.  A wrap the tick doesn't include yet (interrupts disabled) shows as the SysTick
+ *  exception pending in ICSR, with the count just reloaded - in its upper half.
+ */
+
+#include "timebase.h"
+#include "main.h"   // HAL functions and defines for timer access
+
+volatile uint32_t timebase_overflows;
+
+#if TIMEBASE_SYSTICK
+
+uint64_t timebase_systick_us(void)
+{
+    uint32_t tick, ms, val;
+    do {
+        tick = uwTick;
+        val = SysTick->VAL;
+        ms = tick;
+        if((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && val > SysTick->LOAD / 2) ms++;
+    } while(tick != uwTick);
+    uint32_t load = SysTick->LOAD + 1;
+    return (uint64_t)ms * 1000 + (uint64_t)(load - 1 - val) * 1000 / load;
+}
+
+// HAL_Init() started SysTick
+void timebase_init(void)
+{
+    timebase_overflows = 0;
+}
+
+// To the millisecond
+void timebase_advance(uint32_t us)
+{
+    uwTick += us / 1000;
+}
+
+// HAL_RCC_ClockConfig() reloads SysTick for the new clock
+void timebase_set_clock(uint32_t timer_hz)
+{
+    (void)timer_hz;
+}
+
+void timebase_overflow_irq(void)
+{
+}
+
+#else
+
+extern TIM_HandleTypeDef htim3; // main.c
+extern TIM_HandleTypeDef htim4;
+
+// Start the chained timers from zero.  TIM4 (master) and TIM3 (slave) are configured by
+// MX_TIM4_Init() and MX_TIM3_Init().
+void timebase_init(void)
+{
+    __HAL_TIM_DISABLE(&htim4);
+    __HAL_TIM_SET_COUNTER(&htim4, 0);
+    __HAL_TIM_SET_COUNTER(&htim3, 0);
+    timebase_overflows = 0;
+    __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_UPDATE); // count 32-bit wraps
+    __HAL_TIM_ENABLE(&htim3); // counts TIM4 update events
+    __HAL_TIM_ENABLE(&htim4);
+}
+
+// Load the 64-bit time into the stopped timers, then restart them.  Compare events that may have
+// been skipped while the timers were stopped are generated, so software timers aren't delayed.
+static void timebase_load(uint64_t now)
+{
+    __HAL_TIM_SET_COUNTER(&htim4, (uint16_t)now);
+    __HAL_TIM_SET_COUNTER(&htim3, (uint16_t)(now >> 16));
+    timebase_overflows = (uint32_t)(now >> 32);
+    __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE(&htim3);
+    __HAL_TIM_ENABLE(&htim4);
+    htim4.Instance->EGR = TIM_EGR_CC1G | TIM_EGR_CC2G;
+}
+
+// Move the time forward - the timers don't count in stop mode (power.c)
+void timebase_advance(uint32_t us)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    __HAL_TIM_DISABLE(&htim4);
+    timebase_load(timebase_us64() + us);
+    __set_PRIMASK(primask);
+}
+
+// The TIM4 clock changed (clock.c) - set the prescaler for 1us counts, keeping the time.
+// The update event that loads the new prescaler would also clock TIM3, so TIM3 is stopped.
+void timebase_set_clock(uint32_t timer_hz)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    __HAL_TIM_DISABLE(&htim4);
+    uint64_t now = timebase_us64();
+    __HAL_TIM_DISABLE(&htim3);
+    __HAL_TIM_SET_PRESCALER(&htim4, timer_hz / 1000000 - 1);
+    htim4.Instance->EGR = TIM_EGR_UG; // load the prescaler now
+    __HAL_TIM_CLEAR_FLAG(&htim4, TIM_FLAG_UPDATE);
+    htim4.Init.Prescaler = timer_hz / 1000000 - 1;
+    timebase_load(now);
+    __set_PRIMASK(primask);
+}
+
+// TIM3 interrupt - the 32-bit count wrapped.  The flag is cleared and the wrap counted together,
+// so timebase_us64() never sees one without the other, even from a higher priority interrupt.
+void timebase_overflow_irq(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(__HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE)) {
+        __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE);
+        timebase_overflows++;
+    }
+    __set_PRIMASK(primask);
+}
+
+#endif /* TIMEBASE_SYSTICK */
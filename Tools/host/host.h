@@ -0,0 +1,37 @@
+/*
+ * host.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Host (Linux) build of the firmware - what the host programs call
+ *
+ *  The HAL shim itself (GPIO, timers, time) is declared in this directory's stm32f1xx_hal.h.
+ */
+
+#ifndef HOST_HOST_H_
+#define HOST_HOST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// host_console.c
+bool host_console_open(bool pty, char * argv[]); // stdin/stdout or a pseudo terminal
+bool host_console_done(void);  // input ended, and the foreground task completed
+
+// host_kernel_port.c - virtual time only
+void host_kernel_systick(void);          // SysTick: 1ms passes, kernel_tick(), then any switch
+void host_kernel_idle(uint32_t idle_ms); // idle task, see power_idle()
+
+// Tools/i2csim, i2c_attach.cpp
+void i2c_sim_attach_devices(void); // DS3231, AT24C32 and a clock stretcher on the soft I2C bus
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_HOST_H_ */
@@ -0,0 +1,258 @@
+/*
+ * host_console.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Host (Linux) console, idle and reset - main.c's UART and power.c's idle, see host.h
+ *
+ *  The console is stdin/stdout, or a pseudo terminal: its name is printed on stderr, connect a
+ *  terminal program to it as if it were the board's ST-LINK serial port.
+ *  - An interactive stdin is put in raw mode: Ctrl-C reaches the command line (cancels the
+ *    foreground task), Ctrl-D quits.
+ *  - Piped input is read one line at a time, as a user would type it at the prompt: input waits
+ *    while a foreground task runs.  At the end of the input, the process exits once the
+ *    foreground task completes - so "echo i2cscan | nucleo_cli" works as a script.
+ *  - stdout is a stdio cookie stream writing to the console, honoring sched_quiet() (as _write() in
+ *    syscalls.c does).
+ *
+ *  Idle: power_sleep() waits in ppoll() for console input or the next TIM4 compare event.
+ *  "reset" restarts the process.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "main.h"
+#include "command_line.h"
+#include "sched.h"
+#include "kernel.h"
+#include "power.h"
+#include "timebase.h"
+#include "host.h"
+
+static int console_in = STDIN_FILENO;
+static int console_out = STDOUT_FILENO;
+static bool console_tty;        // interactive: raw mode stdin, or the pty
+static bool console_eof;        // end of piped input, or Ctrl-D
+static char console_pty[64];    // pseudo terminal name, -p
+static struct termios console_saved;
+static bool console_raw;
+static uint32_t console_rx_bytes;
+static uint32_t console_tx_bytes;
+static char ** host_argv;
+
+// Sleep statistics
+static uint32_t stat_sleeps;
+static uint64_t stat_sleep_us;
+static uint32_t stat_wakes;
+static uint32_t stat_wake_max;
+static uint64_t stat_wake_total;
+
+static void console_restore(void)
+{
+    if(console_raw) tcsetattr(console_in, TCSANOW, &console_saved);
+    console_raw = false;
+}
+
+// Interactive stdin: no line editing, echo or signals - the command line does its own
+static void console_stdin_raw(void)
+{
+    struct termios raw;
+    if(tcgetattr(console_in, &console_saved)) return;
+    raw = console_saved;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if(tcsetattr(console_in, TCSANOW, &raw)) return;
+    console_raw = true;
+    atexit(console_restore);
+}
+
+// Pseudo terminal: the slave end is held open (and raw), so the master doesn't see a hang-up
+// between terminal program connections
+static bool console_open_pty(void)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) || unlockpt(master)) return false;
+    const char * name = ptsname(master);
+    if(!name) return false;
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if(slave < 0) return false;
+    struct termios raw;
+    tcgetattr(slave, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(slave, TCSANOW, &raw);
+    snprintf(console_pty, sizeof(console_pty), "%s", name);
+    console_in = console_out = master;
+    console_tty = true;
+    return true;
+}
+
+// stdout stream write function
+static ssize_t console_write(void * cookie, const char * buf, size_t size)
+{
+    (void)cookie;
+    if(sched_quiet()) return (ssize_t)size; // output discarded, see "repeat -q"
+    size_t done = 0;
+    while(done < size) {
+        ssize_t n = write(console_out, buf + done, size - done);
+        if(n < 0) {
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN) {
+                struct pollfd pfd = {console_out, POLLOUT, 0};
+                poll(&pfd, 1, -1);
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    console_tx_bytes += (uint32_t)size;
+    return (ssize_t)size;
+}
+
+// Non-blocking read of one character, EOF if none
+int __io_getchar(void)
+{
+    static unsigned char buf[64];
+    static int count, next;
+    if(next == count) {
+        if(console_eof) return EOF;
+        if(!console_tty && sched_foreground()) return EOF; // piped: wait for the prompt
+        struct pollfd pfd = {console_in, POLLIN, 0};
+        if(poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLIN | POLLHUP))) return EOF;
+        // Piped input is taken a line at a time
+        int want = console_tty ? (int)sizeof(buf) : 1;
+        int n = (int)read(console_in, buf, (size_t)want);
+        if(n <= 0) {
+            if(n == 0 || errno != EAGAIN) console_eof = true;
+            return EOF;
+        }
+        count = n;
+        next = 0;
+        console_rx_bytes += (uint32_t)n;
+    }
+    int c = buf[next++];
+    if(console_tty && !console_pty[0] && c == 0x04) { // Ctrl-D
+        console_eof = true;
+        next = count;
+        return EOF;
+    }
+    return c;
+}
+
+int __io_putchar(int ch)
+{
+    return putchar(ch);
+}
+
+void uart_tx_flush(void)
+{
+    fflush(stdout);
+}
+
+bool uart_tx_busy(void)
+{
+    return false;
+}
+
+// Display console statistics
+int cl_uart(void)
+{
+    printf("Console: %s\n", console_pty[0] ? console_pty : console_tty ? "terminal (raw)" : "stdin/stdout");
+    printf("RX %lu bytes, TX %lu bytes\n", console_rx_bytes, console_tx_bytes);
+    return 0;
+}
+
+// Wait for console input or the next TIM4 compare event, up to idle_ms
+void power_sleep(uint32_t idle_ms)
+{
+    uint64_t timeout_us = host_tim_next_event_us();
+    if(idle_ms != POWER_IDLE_FOREVER && (uint64_t)idle_ms * 1000 < timeout_us) timeout_us = (uint64_t)idle_ms * 1000;
+    struct timespec ts = {(time_t)(timeout_us / 1000000), (long)(timeout_us % 1000000) * 1000};
+    struct pollfd pfd = {console_in, POLLIN, 0};
+    bool input = !console_eof;
+    if(!input && timeout_us == UINT32_MAX) return; // nothing can wake us
+    uint32_t start = timebase_us32();
+    int rc = ppoll(&pfd, input ? 1 : 0, timeout_us == UINT32_MAX ? NULL : &ts, NULL);
+    stat_sleep_us += timebase_us32() - start;
+    stat_sleeps++;
+    host_tim_poll();
+    if(rc > 0) sched_notify(); // a character for the command line
+}
+
+void power_idle(uint32_t idle_ms)
+{
+    if(kernel_running()) {
+        host_kernel_idle(idle_ms); // the kernel's idle task, in virtual time - see host_kernel_port.c
+        return;
+    }
+    power_sleep(idle_ms);
+}
+
+void power_wake_latency(uint32_t us)
+{
+    if(us > stat_wake_max) stat_wake_max = us;
+    stat_wake_total += us;
+    stat_wakes++;
+}
+
+// power - idle statistics.  The host has no idle modes, it waits in ppoll().
+int cl_power(void)
+{
+    uint32_t elapsed_us = timebase_us32();
+    printf("Mode: host (ppoll)\n");
+    printf("Sleeps: %lu, asleep %lu ms of %lu ms\n", stat_sleeps, (uint32_t)(stat_sleep_us / 1000), elapsed_us / 1000);
+    printf("Wake latency: max %lu us, avg %lu us (%lu wakes)\n", stat_wake_max,
+            stat_wakes ? (uint32_t)(stat_wake_total / stat_wakes) : 0, stat_wakes);
+    return 0;
+}
+
+// "reset" - start again
+void NVIC_SystemReset(void)
+{
+    fflush(stdout);
+    console_restore();
+    execv("/proc/self/exe", host_argv);
+    exit(1);
+}
+
+void Error_Handler(void)
+{
+    fflush(stdout);
+    fprintf(stderr, "Error_Handler()\n");
+    console_restore();
+    exit(1);
+}
+
+// Open the console, a pseudo terminal or stdin/stdout, and send stdout to it
+bool host_console_open(bool pty, char * argv[])
+{
+    host_argv = argv; // for "reset"
+    if(pty) {
+        if(!console_open_pty()) return false;
+        fprintf(stderr, "Console on %s\n", console_pty);
+    } else if(isatty(console_in)) {
+        console_tty = true;
+        console_stdin_raw();
+    }
+    signal(SIGPIPE, SIG_IGN);
+    static const cookie_io_functions_t console_io = {NULL, console_write, NULL, NULL};
+    stdout = fopencookie(NULL, "w", console_io);
+    return stdout != NULL;
+}
+
+// True once the input has ended (piped input, Ctrl-D) and the foreground task completed
+bool host_console_done(void)
+{
+    return console_eof && !sched_foreground();
+}
@@ -0,0 +1,214 @@
+/*
+ * host_hal.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Host (Linux) HAL shim - see stm32f1xx_hal.h
+ *
+ *  Time is CLOCK_MONOTONIC since start-up.  TIM3:TIM4 is its 32-bit microsecond count, as on
+ *  the board (timebase.h), the DWT cycle counter runs at SystemCoreClock.
+ *
+ *  Virtual time (host_time_virtual()) is for the bus simulator: time only advances by a fixed
+ *  cost for each GPIO access and timer read, and in HAL_Delay().  The soft I2C delays spin reading
+ *  TIM4, so they advance time as on the board, and the same code always gives the same timing.
+ *  The costs are zero in real time.
+ *
+ *  There are no interrupts: TIM4 compare "interrupts" are delivered by host_tim_poll(), which the
+ *  main loop calls each pass, and power_sleep() calls when it wakes (see host_console.c).  Software
+ *  timer callbacks therefore run between tasks, never in the middle of one.
+ */
+
+#include <time.h>
+#include "main.h"
+#include "timebase.h"
+
+GPIO_TypeDef host_gpio[4];
+HOST_GPIO_HOOK host_gpio_hook;
+uint32_t host_primask;
+uint32_t SystemCoreClock = 72000000;
+volatile uint32_t timebase_overflows;
+
+const uint8_t host_uid[12] = {'N','U','C','L','E','O','-','H','O','S','T',0};
+const uint16_t host_flash_size = 128;         // K bytes
+const uint32_t host_dbgmcu_idcode = 0x20036410; // STM32F10x medium density, revision X
+
+static TIM_TypeDef tim3;
+static TIM_TypeDef tim4;
+static DWT_Type dwt;
+CoreDebug_Type host_core_debug;
+RCC_TypeDef host_rcc = {RCC_CSR_PORRSTF | RCC_CSR_PINRSTF}; // as at power on
+
+TIM_HandleTypeDef htim4 = {&tim4, HAL_TIM_ACTIVE_CHANNEL_CLEARED}; // TIM4, see host_tim4()
+UART_HandleTypeDef huart2 = {{115200}, 128};
+
+// Virtual time
+static bool virtual_time;
+static uint64_t virtual_ns;
+static uint32_t gpio_cost_ns;   // per GPIO read or write
+static uint32_t timer_cost_ns;  // per TIM3, TIM4 or DWT read
+
+void host_time_virtual(uint32_t gpio_ns, uint32_t timer_ns)
+{
+    virtual_time = true;
+    gpio_cost_ns = gpio_ns;
+    timer_cost_ns = timer_ns;
+}
+
+void host_time_advance(uint64_t ns)
+{
+    virtual_ns += ns;
+}
+
+uint64_t host_time_ns(void)
+{
+    if(virtual_time) return virtual_ns;
+    static uint64_t start;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    if(!start) start = now - 1; // time starts at (about) zero
+    return now - start;
+}
+
+uint64_t host_time_us(void)
+{
+    return host_time_ns() / 1000;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(host_time_us() / 1000);
+}
+
+// As the HAL: waits at least delay_ms, timer "interrupts" are still delivered
+void HAL_Delay(uint32_t delay_ms)
+{
+    uint32_t start = HAL_GetTick();
+    uint32_t wait = delay_ms < 0xFFFFFFFF ? delay_ms + 1 : delay_ms;
+    while(HAL_GetTick() - start < wait) {
+        struct timespec ts = {0, 100000};
+        if(virtual_time)
+            virtual_ns += 100000;
+        else
+            nanosleep(&ts, NULL);
+        host_tim_poll();
+    }
+}
+
+// TIM4 counts microseconds, TIM3 counts TIM4 wraps
+TIM_TypeDef * host_tim4(void)
+{
+    virtual_ns += timer_cost_ns;
+    tim4.CNT = (uint32_t)(host_time_us() & 0xFFFF);
+    return &tim4;
+}
+
+TIM_TypeDef * host_tim3(void)
+{
+    virtual_ns += timer_cost_ns;
+    uint64_t now = host_time_us();
+    tim3.CNT = (uint32_t)((now >> 16) & 0xFFFF);
+    timebase_overflows = (uint32_t)(now >> 32);
+    return &tim3;
+}
+
+DWT_Type * host_dwt(void)
+{
+    virtual_ns += timer_cost_ns;
+    dwt.CYCCNT = (uint32_t)(host_time_ns() * (SystemCoreClock / 1000000) / 1000);
+    return &dwt;
+}
+
+// True if the counter passed the compare value after last, up to and including now
+static bool compare_crossed(uint32_t ccr, uint64_t last, uint64_t now)
+{
+    if(now - last >= 0x10000) return true;
+    uint16_t offset = (uint16_t)(ccr - (uint16_t)last);
+    return offset && offset <= now - last;
+}
+
+void host_tim_poll(void)
+{
+    static uint64_t last;
+    static bool polling;
+    if(polling) return; // from HAL_Delay() in a callback
+    polling = true;
+    // A callback may arm a compare that's already due (TIM4->EGR), deliver those too
+    for(int pass=0;pass<8;pass++) {
+        uint64_t now = host_time_us();
+        for(uint32_t ch=1;ch<=2;ch++) {
+            uint32_t bit = 1 << ch; // TIM_SR_CCxIF, TIM_EGR_CCxG, TIM_IT_CCx
+            uint32_t ccr = ch == 1 ? tim4.CCR1 : tim4.CCR2;
+            if((tim4.EGR & bit) || compare_crossed(ccr, last, now)) tim4.SR |= bit;
+        }
+        tim4.EGR = 0;
+        last = now;
+        uint32_t pending = tim4.SR & tim4.DIER & (TIM_IT_CC1 | TIM_IT_CC2);
+        if(!pending) break;
+        for(uint32_t ch=1;ch<=2;ch++) {
+            uint32_t bit = 1 << ch;
+            if(!(pending & bit)) continue;
+            tim4.SR &= ~bit;
+            htim4.Channel = ch == 1 ? HAL_TIM_ACTIVE_CHANNEL_1 : HAL_TIM_ACTIVE_CHANNEL_2;
+            HAL_TIM_OC_DelayElapsedCallback(&htim4);
+            htim4.Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+        }
+    }
+    polling = false;
+}
+
+uint32_t host_tim_next_event_us(void)
+{
+    if(tim4.EGR & tim4.DIER) return 0;
+    uint16_t now = (uint16_t)host_time_us();
+    uint32_t next = UINT32_MAX;
+    if(tim4.DIER & TIM_IT_CC1) {
+        uint32_t offset = (uint16_t)(tim4.CCR1 - now);
+        if(offset < next) next = offset ? offset : 0x10000;
+    }
+    if(tim4.DIER & TIM_IT_CC2) {
+        uint32_t offset = (uint16_t)(tim4.CCR2 - now);
+        if(offset < next) next = offset ? offset : 0x10000;
+    }
+    return next;
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef * htim)
+{
+    (void)htim; // compare events are delivered by host_tim_poll()
+}
+
+// Input levels: the outputs, with any bus model's devices pulling lines low
+static void gpio_update(GPIO_TypeDef * port)
+{
+    virtual_ns += gpio_cost_ns;
+    port->IDR = host_gpio_hook ? (*host_gpio_hook)(port, port->ODR) : port->ODR;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef * port, GPIO_InitTypeDef * init)
+{
+    (void)init;
+    gpio_update(port);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state)
+{
+    if(state == GPIO_PIN_RESET)
+        port->ODR &= ~(uint32_t)pin;
+    else
+        port->ODR |= pin;
+    gpio_update(port);
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef * port, uint16_t pin)
+{
+    port->ODR ^= pin;
+    gpio_update(port);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef * port, uint16_t pin)
+{
+    gpio_update(port);
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
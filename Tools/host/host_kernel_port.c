@@ -0,0 +1,127 @@
+/*
+ * host_kernel_port.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Host (Linux) port of the minimal kernel - the port_xxx() functions of kernel.h, as
+ *  kernel_port.c is for the Cortex-M3
+ *
+ *  Each task runs on its own ucontext, in one thread.  kernel.c is unchanged: it requests a switch
+ *  (port_request_switch()), and the switch happens where PendSV would run on the board - when a
+ *  critical section ends with interrupts enabled, and on return from the SysTick "interrupt".
+ *  The port runs in virtual time (host_time_virtual()), so the same test always gives the same
+ *  schedule:
+ *  - host_kernel_systick() is the SysTick interrupt: time advances 1ms, kernel_tick() runs, then
+ *    any switch it requested.  A task "computes" for a number of ticks by calling it in a loop.
+ *  - The idle task's power_idle() (host_console.c) calls host_kernel_idle(): ticks pass until a
+ *    delayed task wakes.  When nothing can wake, kernel_start() returns.
+ *
+ *  The tasks run on host stacks (HOST_KERNEL_STACK_SIZE), not their firmware stacks, which are
+ *  only painted - "ps" shows them unused.  Tools/host/kernel_test.c tests the kernel with it.
+ */
+
+#include <ucontext.h>
+#include "main.h"
+#include "kernel.h"
+#include "host.h"
+
+#define HOST_KERNEL_STACK_SIZE  (64 * 1024) // bytes - glibc's printf() needs more than a firmware stack
+
+typedef struct {
+    KTASK * task;
+    ucontext_t context;
+    uint8_t stack[HOST_KERNEL_STACK_SIZE];
+} PORT_TASK;
+
+static PORT_TASK port_tasks[KERNEL_MAX_TASKS];
+static ucontext_t port_main;        // main(), kernel_start()'s caller
+static bool port_switch_pending;    // PendSV pending
+
+static PORT_TASK * port_task(const KTASK * task)
+{
+    for(int i=0;i<KERNEL_MAX_TASKS;i++) {
+        if(port_tasks[i].task == task) return &port_tasks[i];
+    }
+    return NULL;
+}
+
+// First code of every task - the task function, then kernel_task_exit() as its return address
+static void port_task_entry(void)
+{
+    KTASK * task = kernel_current;
+    host_primask = 0;
+    task->entry(task->arg);
+    kernel_task_exit();
+}
+
+// PendSV: switch to kernel_next, if a switch is pending and interrupts are enabled
+static void port_switch(void)
+{
+    if(!port_switch_pending || host_primask) return;
+    port_switch_pending = false;
+    KTASK * prev = kernel_current;
+    KTASK * next = kernel_next;
+    if(next == prev) return;
+    kernel_current = next;
+    swapcontext(&port_task(prev)->context, &port_task(next)->context);
+    host_primask = 0; // resumed - by a switch from another task
+}
+
+void port_init_stack(KTASK * task)
+{
+    PORT_TASK * port = port_task(task);
+    if(!port) port = port_task(NULL); // kernel_task_create() checked there's room
+    port->task = task;
+    getcontext(&port->context);
+    port->context.uc_stack.ss_sp = port->stack;
+    port->context.uc_stack.ss_size = sizeof(port->stack);
+    port->context.uc_link = NULL;
+    makecontext(&port->context, port_task_entry, 0);
+}
+
+// Start the first task (kernel_current) - called with interrupts disabled.  Returns once
+// host_kernel_idle() finds nothing left to wake.
+void port_start(KTASK * first)
+{
+    port_switch_pending = false;
+    swapcontext(&port_main, &port_task(first)->context);
+    host_primask = 0;
+}
+
+void port_request_switch(void)
+{
+    port_switch_pending = true;
+}
+
+uint32_t port_enter_critical(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+void port_exit_critical(uint32_t state)
+{
+    __set_PRIMASK(state);
+    port_switch(); // a switch requested in the critical section happens here
+}
+
+// The SysTick interrupt: 1ms passes, wake / preempt / time slice
+void host_kernel_systick(void)
+{
+    host_time_advance(1000000);
+    kernel_tick();
+    port_switch();
+}
+
+// Idle task: ticks pass until a delayed task wakes, see power_idle().  With none delayed, nothing
+// can wake - back to kernel_start()'s caller.
+void host_kernel_idle(uint32_t idle_ms)
+{
+    if(idle_ms == KERNEL_WAIT_FOREVER) {
+        kernel_current = NULL;
+        setcontext(&port_main);
+    }
+    host_kernel_systick();
+}
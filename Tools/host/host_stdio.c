@@ -0,0 +1,84 @@
+/*
+ * host_stdio.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  ILP32 printf() family for the host build - see host_stdio.h
+ */
+
+#include <string.h>
+#include "host_stdio.h"
+
+#undef printf
+#undef sprintf
+#undef snprintf
+#undef fprintf
+#undef vfprintf
+
+#define HOST_FORMAT_MAX  256  // longer formats are used unchanged
+
+// Copy a format, dropping single 'l' length modifiers ("%lu" -> "%u", "%8lX" -> "%8X")
+static const char * host_format(const char * format, char * buf)
+{
+    size_t len = strlen(format);
+    if(len >= HOST_FORMAT_MAX) return format;
+    char * out = buf;
+    const char * p = format;
+    while(*p) {
+        *out++ = *p;
+        if(*p++ != '%') continue;
+        if(*p == '%') {
+            *out++ = *p++;
+            continue;
+        }
+        while(*p && strchr("-+ #0123456789.*", *p)) *out++ = *p++; // flags, width, precision
+        if(p[0] == 'l' && p[1] != 'l') p++;
+    }
+    *out = 0;
+    return buf;
+}
+
+int host_vfprintf(FILE * stream, const char * format, va_list ap)
+{
+    char buf[HOST_FORMAT_MAX];
+    return vfprintf(stream, host_format(format, buf), ap);
+}
+
+int host_printf(const char * format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    int rc = host_vfprintf(stdout, format, ap);
+    va_end(ap);
+    return rc;
+}
+
+int host_fprintf(FILE * stream, const char * format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    int rc = host_vfprintf(stream, format, ap);
+    va_end(ap);
+    return rc;
+}
+
+int host_sprintf(char * str, const char * format, ...)
+{
+    char buf[HOST_FORMAT_MAX];
+    va_list ap;
+    va_start(ap, format);
+    int rc = vsprintf(str, host_format(format, buf), ap);
+    va_end(ap);
+    return rc;
+}
+
+int host_snprintf(char * str, size_t size, const char * format, ...)
+{
+    char buf[HOST_FORMAT_MAX];
+    va_list ap;
+    va_start(ap, format);
+    int rc = vsnprintf(str, size, host_format(format, buf), ap);
+    va_end(ap);
+    return rc;
+}
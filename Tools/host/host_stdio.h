@@ -0,0 +1,41 @@
+/*
+ * host_stdio.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  printf() family for firmware sources built on a 64-bit host - see host_stdio.c
+ *
+ *  On the STM32 (ILP32) long is 32 bits, and the firmware prints uint32_t values with "%lu".  On
+ *  an LP64 host that reads a 64-bit argument from a 32-bit one.  The host build force-includes
+ *  this file (-include): the printf() family then drops the 'l' length modifier from formats,
+ *  so "%lu" reads an unsigned int, as on the target.  ("%llu" is unchanged.)
+ */
+
+#ifndef HOST_STDIO_H_
+#define HOST_STDIO_H_
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int host_printf(const char * format, ...);
+int host_sprintf(char * str, const char * format, ...);
+int host_snprintf(char * str, size_t size, const char * format, ...);
+int host_fprintf(FILE * stream, const char * format, ...);
+int host_vfprintf(FILE * stream, const char * format, va_list ap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define printf   host_printf
+#define sprintf  host_sprintf
+#define snprintf host_snprintf
+#define fprintf  host_fprintf
+#define vfprintf host_vfprintf
+
+#endif /* HOST_STDIO_H_ */
@@ -0,0 +1,68 @@
+/*
+ * host_stubs.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Host (Linux) build - stand-ins for the firmware modules bound to the hardware
+ *
+ *  clock.c (RCC), mem.c (linker symbols, MSP) and pcsample.c (TIM2 exception frames) aren't built
+ *  for the host.  Their commands report that they aren't available.  kernel_port.c's host
+ *  counterpart is host_kernel_port.c - the command line still runs without the kernel
+ *  (KERNEL_ENABLED 0), it's started by the kernel test only.
+ */
+
+#include <stdio.h>  // printf()
+#include "main.h"
+#include "clock.h"
+#include "mem.h"
+#include "pcsample.h"
+#include "command_line.h"
+#include "stm32f1xx_it.h" // irq_counts[]
+
+volatile uint32_t irq_counts[IRQ_COUNT_SOURCES]; // no interrupts, see delaybench.c
+
+static int host_not_available(void)
+{
+    printf("\"%s\" isn't available on the host build\n", argv[0]);
+    return 1;
+}
+
+// clock.c - fixed at the default 72MHz profile
+static const CLOCK_PROFILE host_profile = {72, 0, 0, 0};
+
+bool clock_set_profile(int profile)
+{
+    return profile == CLOCK_PROFILE_DEFAULT;
+}
+
+void clock_restore(void)
+{
+}
+
+const CLOCK_PROFILE * clock_profile(void)
+{
+    return &host_profile;
+}
+
+uint32_t clock_apb1_timer_hz(void)
+{
+    return SystemCoreClock;
+}
+
+int cl_clock(void)
+{
+    return host_not_available();
+}
+
+// mem.c
+int cl_mem(void)
+{
+    return host_not_available();
+}
+
+// pcsample.c
+int cl_pcsample(void)
+{
+    return host_not_available();
+}
@@ -0,0 +1,253 @@
+/*
+ * kernel_test.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Scheduling tests of the minimal kernel (kernel.c, unmodified) on the host port
+ *
+ *  Usage: kernel_test <slice|preempt|delay_until|inherit>
+ *    slice        two equal priority tasks computing take turns, KERNEL_TIME_SLICE_MS each
+ *    preempt      a delayed high priority task preempts a computing one on the tick it wakes
+ *    delay_until  kernel_delay_until() wakes on the period, without drift, and restarts the
+ *                 schedule after an overrun
+ *    inherit      priority inheritance: a low priority mutex owner runs at the waiter's priority,
+ *                 ahead of a medium priority task, and drops back when it unlocks
+ *
+ *  Time is virtual (host_kernel_port.c): a task "computes" with work(), one SysTick at a time, and
+ *  each tick is traced with the task that ran it.  kernel_start() returns when every task has
+ *  completed.  Prints the trace and the checks, exits 1 if a check fails.  Run by ctest.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "kernel.h"
+#include "host.h"
+
+#define TRACE_MAX    256
+#define STACK_WORDS  64  // painted only, tasks run on host stacks
+
+static char trace[TRACE_MAX];   // task letter that ran each tick, '.' idle
+static unsigned failures;
+
+static KTASK tasks[3];
+static uint32_t stacks[3][STACK_WORDS];
+static KMUTEX mutex;
+
+// Compute for a number of ticks
+static void work(char who, uint32_t ticks)
+{
+    for(uint32_t i=0;i<ticks;i++) {
+        uint32_t tick = HAL_GetTick();
+        if(tick < TRACE_MAX) trace[tick] = who;
+        host_kernel_systick();
+    }
+}
+
+static void check(bool ok, const char * what)
+{
+    printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+    if(!ok) failures++;
+}
+
+static void check_u32(uint32_t value, uint32_t expected, const char * what)
+{
+    char text[96];
+    snprintf(text, sizeof(text), "%s: %u, expected %u", what, (unsigned)value, (unsigned)expected);
+    check(value == expected, text);
+}
+
+// Ticks traced for a task, from first to last (exclusive)
+static uint32_t ran(char who, uint32_t first, uint32_t last)
+{
+    uint32_t n = 0;
+    for(uint32_t t=first;t<last && t<TRACE_MAX;t++) {
+        if(trace[t] == who) n++;
+    }
+    return n;
+}
+
+static void start(KTASK * task, const char * name, void (*entry)(void *), uint8_t priority)
+{
+    kernel_task_create(task, name, entry, NULL, stacks[task - tasks], STACK_WORDS, priority);
+}
+
+// slice: A and B, equal priority, 30 ticks of work each
+static void slice_a(void * arg) { (void)arg; work('A', 30); }
+static void slice_b(void * arg) { (void)arg; work('B', 30); }
+
+static void slice_setup(void)
+{
+    start(&tasks[0], "A", slice_a, KERNEL_PRIORITY_CLI);
+    start(&tasks[1], "B", slice_b, KERNEL_PRIORITY_CLI);
+}
+
+static void slice_check(void)
+{
+    // Runs of KERNEL_TIME_SLICE_MS, alternating
+    unsigned runs = 0;
+    bool even = true;
+    for(uint32_t t=0;t<60;t+=KERNEL_TIME_SLICE_MS) {
+        char who = trace[t];
+        if(who != 'A' && who != 'B') even = false;
+        if(ran(who, t, t + KERNEL_TIME_SLICE_MS) != KERNEL_TIME_SLICE_MS) even = false;
+        if(t && who == trace[t - 1]) even = false;
+        runs++;
+    }
+    check(even, "A and B alternate, a time slice each");
+    check_u32(runs, 6, "time slices");
+}
+
+// preempt: L computes, H wakes from a delay part way through
+static uint32_t h_woke;
+
+static void preempt_l(void * arg) { (void)arg; work('L', 40); }
+
+static void preempt_h(void * arg)
+{
+    (void)arg;
+    kernel_delay(15);
+    h_woke = HAL_GetTick();
+    work('H', 3);
+}
+
+static void preempt_setup(void)
+{
+    start(&tasks[0], "L", preempt_l, KERNEL_PRIORITY_CLI);
+    start(&tasks[1], "H", preempt_h, KERNEL_PRIORITY_ACQ);
+}
+
+static void preempt_check(void)
+{
+    check_u32(h_woke, 15, "H woke at tick");
+    check_u32(ran('H', 15, 18), 3, "ticks 15 - 17 run by H");
+    check_u32(ran('L', 0, 15), 15, "ticks 0 - 14 run by L");
+    check_u32(ran('L', 0, 43), 40, "ticks run by L");
+}
+
+// delay_until: H wakes every 7 ticks while L computes, overruns once
+#define PERIOD  7
+static uint32_t wakes[8];
+
+static void delay_until_l(void * arg) { (void)arg; work('L', 60); }
+
+static void delay_until_h(void * arg)
+{
+    (void)arg;
+    uint32_t last_wake = HAL_GetTick();
+    for(int i=0;i<5;i++) {
+        kernel_delay_until(&last_wake, PERIOD);
+        wakes[i] = HAL_GetTick();
+    }
+    work('H', PERIOD + 3); // overrun
+    kernel_delay_until(&last_wake, PERIOD);
+    wakes[5] = HAL_GetTick();
+    kernel_delay_until(&last_wake, PERIOD);
+    wakes[6] = HAL_GetTick();
+}
+
+static void delay_until_setup(void)
+{
+    start(&tasks[0], "L", delay_until_l, KERNEL_PRIORITY_CLI);
+    start(&tasks[1], "H", delay_until_h, KERNEL_PRIORITY_ACQ);
+}
+
+static void delay_until_check(void)
+{
+    static const uint32_t expected[] = {7, 14, 21, 28, 35, 45, 52}; // overrun: restarts from 45
+    for(unsigned i=0;i<sizeof(expected)/sizeof(expected[0]);i++) {
+        char what[32];
+        snprintf(what, sizeof(what), "wake %u at tick", i + 1);
+        check_u32(wakes[i], expected[i], what);
+    }
+}
+
+// inherit: L holds the mutex, M computes, H waits for the mutex
+static uint32_t l_inherited;    // L's priority after H blocked
+static uint32_t l_after;        // L's priority after unlocking
+static uint32_t h_locked;       // tick H got the mutex
+static uint32_t m_done;
+
+static void inherit_l(void * arg)
+{
+    (void)arg;
+    kmutex_lock(&mutex);
+    work('L', 10);
+    l_inherited = tasks[0].priority;
+    kmutex_unlock(&mutex);
+    l_after = tasks[0].priority;
+}
+
+static void inherit_m(void * arg)
+{
+    (void)arg;
+    kernel_delay(2);
+    work('M', 20);
+    m_done = HAL_GetTick();
+}
+
+static void inherit_h(void * arg)
+{
+    (void)arg;
+    kernel_delay(4);
+    kmutex_lock(&mutex);
+    h_locked = HAL_GetTick();
+    work('H', 2);
+    kmutex_unlock(&mutex);
+}
+
+static void inherit_setup(void)
+{
+    start(&tasks[0], "L", inherit_l, KERNEL_PRIORITY_CLI);
+    start(&tasks[1], "M", inherit_m, KERNEL_PRIORITY_CLI + 1);
+    start(&tasks[2], "H", inherit_h, KERNEL_PRIORITY_ACQ);
+}
+
+static void inherit_check(void)
+{
+    // L locks at 0, M preempts at 2, H blocks at 4: L (at H's priority) finishes its 8 remaining
+    // ticks ahead of M, and hands the mutex to H at 12
+    check_u32(l_inherited, KERNEL_PRIORITY_ACQ, "L's priority holding the mutex H waits for");
+    check_u32(l_after, KERNEL_PRIORITY_CLI, "L's priority after unlocking");
+    check_u32(h_locked, 12, "H got the mutex at tick");
+    check_u32(ran('M', 4, 12), 0, "ticks 4 - 11 run by M");
+    check_u32(mutex.contentions, 1, "mutex contentions");
+    check_u32(m_done, 32, "M done at tick"); // 2 ticks before H woke, 18 after H unlocked
+}
+
+static const struct {
+    const char * name;
+    void (*setup)(void);
+    void (*check)(void);
+} tests[] = {
+    {"slice",       slice_setup,       slice_check},
+    {"preempt",     preempt_setup,     preempt_check},
+    {"delay_until", delay_until_setup, delay_until_check},
+    {"inherit",     inherit_setup,     inherit_check},
+};
+
+int main(int argc, char * argv[])
+{
+    int test = -1;
+    for(int i=0;argc == 2 && i<(int)(sizeof(tests)/sizeof(tests[0]));i++) {
+        if(!strcmp(argv[1], tests[i].name)) test = i;
+    }
+    if(test < 0) {
+        fprintf(stderr, "Usage: kernel_test <slice|preempt|delay_until|inherit>\n");
+        return 1;
+    }
+
+    host_time_virtual(0, 0);
+    memset(trace, '.', sizeof(trace));
+    kernel_init();
+    tests[test].setup();
+    kernel_start(); // returns when every task has completed, see host_kernel_idle()
+
+    uint32_t end = HAL_GetTick();
+    printf("Kernel test \"%s\", %u ticks:\n%.*s\n", tests[test].name, (unsigned)end,
+            (int)(end < TRACE_MAX ? end : TRACE_MAX), trace);
+    tests[test].check();
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * nucleo_cli.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  The firmware command line as a Linux process - the host's main.c
+ *
+ *  Usage: nucleo_cli [-p] [-s]
+ *    -p  console on a pseudo terminal, instead of stdin/stdout (see host_console.c)
+ *    -s  simulated devices on the I2C bus (Tools/i2csim): DS3231 0x68, AT24C32 0x50, and a clock
+ *        stretching register file 0x42
+ *
+ *  The firmware's command line, scheduler, soft I2C and statistics modules run unchanged against
+ *  the HAL shim (stm32f1xx_hal.h).  Without -s, nothing answers on the I2C bus.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "command_line.h"
+#include "sched.h"
+#include "dwt.h"
+#include "prof.h"
+#include "pool.h"
+#include "boot.h"
+#include "host.h"
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: nucleo_cli [-p] [-s]\n"
+                    "  -p  console on a pseudo terminal, instead of stdin/stdout\n"
+                    "  -s  simulated devices on the I2C bus\n");
+}
+
+int main(int argc, char * argv[])
+{
+    bool pty = false;
+    bool sim = false;
+    for(int i=1;i<argc;i++) {
+        if(!strcmp(argv[i], "-p")) {
+            pty = true;
+        } else if(!strcmp(argv[i], "-s")) {
+            sim = true;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if(!host_console_open(pty, argv)) {
+        perror("console");
+        return 1;
+    }
+
+    if(sim) i2c_sim_attach_devices();
+
+    // As main.c, without the hardware set up
+    dwt_init();
+    boot_start();
+    HAL_GPIO_WritePin(GPIOC, Soft_SCL_Pin|Soft_SDA_Pin, GPIO_PIN_SET); // MX_GPIO_Init()
+    boot_mark(BOOT_STAGE_MX_INIT);
+    prof_init();
+    boot_mark(BOOT_STAGE_PROF);
+    pool_init();
+    boot_mark(BOOT_STAGE_POOL);
+    cl_setup();
+    boot_finish();
+
+    while(!host_console_done()) {
+        host_tim_poll();
+        if(sched_run())
+            sched_idle();
+    }
+    printf("\n");
+    fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * stm32f1xx_hal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Host (Linux) stand-in for the STM32F1 HAL and CMSIS headers - see host_hal.c
+ *
+ *  Core/Inc/main.h includes "stm32f1xx_hal.h", so firmware modules compiled for the host pick
+ *  this file up instead of the real HAL, and are built unchanged.  Only what the host build's
+ *  modules use is provided:
+ *  - GPIO ports, as open-drain output latches (ODR) and input levels (IDR).  The input levels are
+ *    the outputs, unless a bus model is attached, see host_gpio_hook.
+ *  - TIM3 and TIM4, a virtual microsecond counter read from the host's monotonic clock.  TIM4's
+ *    CC1/CC2 compare interrupts are delivered by host_tim_poll(), from the main loop.
+ *  - DWT cycle counter, at SystemCoreClock (72MHz) from the same clock
+ *  - HAL_GetTick(), HAL_Delay(), PRIMASK and the other CMSIS intrinsics
+ *  - UID, flash size and device ID registers, with fixed values
+ *  - RCC reset flags (RCC->CSR), for the boot record
+ *
+ *  Register "pointers" such as TIM4 are function calls, which update the register values from
+ *  the clock before they are read.
+ */
+
+#ifndef HOST_STM32F1XX_HAL_H_
+#define HOST_STM32F1XX_HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+// GPIO
+typedef struct {
+    volatile uint32_t IDR;  // input level, see host_gpio_hook
+    volatile uint32_t ODR;  // output latch, 1: released (open-drain) or high
+} GPIO_TypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0   ((uint16_t)0x0001)
+#define GPIO_PIN_1   ((uint16_t)0x0002)
+#define GPIO_PIN_2   ((uint16_t)0x0004)
+#define GPIO_PIN_3   ((uint16_t)0x0008)
+#define GPIO_PIN_4   ((uint16_t)0x0010)
+#define GPIO_PIN_5   ((uint16_t)0x0020)
+#define GPIO_PIN_6   ((uint16_t)0x0040)
+#define GPIO_PIN_7   ((uint16_t)0x0080)
+#define GPIO_PIN_8   ((uint16_t)0x0100)
+#define GPIO_PIN_9   ((uint16_t)0x0200)
+#define GPIO_PIN_10  ((uint16_t)0x0400)
+#define GPIO_PIN_11  ((uint16_t)0x0800)
+#define GPIO_PIN_12  ((uint16_t)0x1000)
+#define GPIO_PIN_13  ((uint16_t)0x2000)
+#define GPIO_PIN_14  ((uint16_t)0x4000)
+#define GPIO_PIN_15  ((uint16_t)0x8000)
+
+#define GPIO_MODE_INPUT       0x00000000U
+#define GPIO_MODE_OUTPUT_PP   0x00000001U
+#define GPIO_MODE_OUTPUT_OD   0x00000011U
+#define GPIO_MODE_IT_RISING   0x10110000U
+#define GPIO_NOPULL           0x00000000U
+#define GPIO_PULLUP           0x00000001U
+#define GPIO_SPEED_FREQ_LOW   0x00000002U
+#define GPIO_SPEED_FREQ_HIGH  0x00000003U
+
+extern GPIO_TypeDef host_gpio[4];
+#define GPIOA (&host_gpio[0])
+#define GPIOB (&host_gpio[1])
+#define GPIOC (&host_gpio[2])
+#define GPIOD (&host_gpio[3])
+
+// Called after every GPIO write, and before every read: returns the port's input levels (IDR)
+// given its output latch.  NULL: the inputs follow the outputs (pull-ups, nothing driving low).
+typedef uint32_t (*HOST_GPIO_HOOK)(GPIO_TypeDef * port, uint32_t odr);
+extern HOST_GPIO_HOOK host_gpio_hook;
+
+void HAL_GPIO_Init(GPIO_TypeDef * port, GPIO_InitTypeDef * init);
+void HAL_GPIO_WritePin(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef * port, uint16_t pin);
+void HAL_GPIO_TogglePin(GPIO_TypeDef * port, uint16_t pin);
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  do { } while(0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  do { } while(0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  do { } while(0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE()  do { } while(0)
+
+// Timers
+typedef struct {
+    volatile uint32_t DIER;
+    volatile uint32_t SR;
+    volatile uint32_t EGR;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+    volatile uint32_t CCR3;
+    volatile uint32_t CCR4;
+} TIM_TypeDef;
+
+typedef enum {
+    HAL_TIM_ACTIVE_CHANNEL_1       = 0x01U,
+    HAL_TIM_ACTIVE_CHANNEL_2       = 0x02U,
+    HAL_TIM_ACTIVE_CHANNEL_3       = 0x04U,
+    HAL_TIM_ACTIVE_CHANNEL_4       = 0x08U,
+    HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U
+} HAL_TIM_ActiveChannel;
+
+typedef struct {
+    TIM_TypeDef * Instance;
+    HAL_TIM_ActiveChannel Channel;
+} TIM_HandleTypeDef;
+
+#define TIM_SR_UIF    0x0001U
+#define TIM_SR_CC1IF  0x0002U
+#define TIM_SR_CC2IF  0x0004U
+#define TIM_EGR_UG    0x0001U
+#define TIM_EGR_CC1G  0x0002U
+#define TIM_EGR_CC2G  0x0004U
+#define TIM_FLAG_CC1  TIM_SR_CC1IF
+#define TIM_FLAG_CC2  TIM_SR_CC2IF
+#define TIM_IT_CC1    0x0002U
+#define TIM_IT_CC2    0x0004U
+
+#define __HAL_TIM_ENABLE_IT(handle, it)   ((handle)->Instance->DIER |= (it))
+#define __HAL_TIM_DISABLE_IT(handle, it)  ((handle)->Instance->DIER &= ~(it))
+#define __HAL_TIM_CLEAR_FLAG(handle, flag) ((handle)->Instance->SR &= ~(flag)) // rc_w0
+
+TIM_TypeDef * host_tim3(void);
+TIM_TypeDef * host_tim4(void);
+#define TIM3 (host_tim3())
+#define TIM4 (host_tim4())
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef * htim);
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef * htim);
+void host_tim_poll(void);             // deliver TIM4 compare interrupts that are due
+uint32_t host_tim_next_event_us(void); // time to the next TIM4 compare interrupt, UINT32_MAX: none
+
+// UART - only what's read from huart2
+typedef struct {
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct {
+    UART_InitTypeDef Init;
+    uint16_t RxXferSize;
+} UART_HandleTypeDef;
+
+// RCC - reset flags only
+typedef struct {
+    volatile uint32_t CSR;
+} RCC_TypeDef;
+
+#define RCC_CSR_RMVF      0x01000000U
+#define RCC_CSR_PINRSTF   0x04000000U
+#define RCC_CSR_PORRSTF   0x08000000U
+#define RCC_CSR_SFTRSTF   0x10000000U
+#define RCC_CSR_IWDGRSTF  0x20000000U
+#define RCC_CSR_WWDGRSTF  0x40000000U
+#define RCC_CSR_LPWRRSTF  0x80000000U
+
+extern RCC_TypeDef host_rcc;
+#define RCC (&host_rcc)
+
+// Cortex-M3 core: DWT cycle counter
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk         0x00000001UL
+#define CoreDebug_DEMCR_TRCENA_Msk     0x01000000UL
+
+DWT_Type * host_dwt(void);
+extern CoreDebug_Type host_core_debug;
+#define DWT       (host_dwt())
+#define CoreDebug (&host_core_debug)
+
+// Device identification registers
+extern const uint8_t host_uid[12];
+extern const uint16_t host_flash_size;
+extern const uint32_t host_dbgmcu_idcode;
+#define UID_BASE        ((uintptr_t)host_uid)
+#define FLASHSIZE_BASE  ((uintptr_t)&host_flash_size)
+#define DBGMCU_BASE     ((uintptr_t)&host_dbgmcu_idcode)
+
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay_ms);
+uint64_t host_time_ns(void);    // nanoseconds since start-up
+uint64_t host_time_us(void);    // microseconds since start-up, the virtual TIM3:TIM4 count
+void host_time_virtual(uint32_t gpio_ns, uint32_t timer_ns); // see host_hal.c
+void host_time_advance(uint64_t ns);
+
+// CMSIS intrinsics.  There are no interrupts to mask, PRIMASK is only remembered.
+extern uint32_t host_primask;
+static inline uint32_t __get_PRIMASK(void) { return host_primask; }
+static inline void __set_PRIMASK(uint32_t primask) { host_primask = primask; }
+static inline void __disable_irq(void) { host_primask = 1; }
+static inline void __enable_irq(void) { host_primask = 0; }
+static inline uint32_t __get_IPSR(void) { return 0; }
+static inline void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __DSB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __ISB(void) { }
+static inline void __NOP(void) { }
+static inline void __WFI(void) { }
+
+void NVIC_SystemReset(void);    // restarts the process, see host_console.c
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_STM32F1XX_HAL_H_ */
@@ -0,0 +1,130 @@
+/*
+ * i2c2vcd.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Convert a soft I2C edge trace to a VCD file, for GTKWave
+ *
+ *  Usage: i2c2vcd [trace.txt|-] [trace.vcd]
+ *
+ *  Input is the output of "i2ctrace raw" (a terminal capture is fine, other lines are skipped):
+ *    # i2ctrace hz=<timestamp clock> bits=<timestamp bits>
+ *    <timestamp> <flags>
+ *  Flags are those of i2c_trace.h: 1 SCL, 2 SDA, 4 SDA sample.  Timestamps wrap at 2^bits, so
+ *  consecutive events must be less than that apart.  Without a header line, timestamps are
+ *  64-bit nanoseconds (hz=1000000000 bits=64), as written by simulations.
+ *
+ *  The input is streamed a line at a time, the decoding and VCD writing is i2c_vcd.c (shared
+ *  with the firmware), so traces of any length convert in constant memory.
+ */
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "i2c_vcd.h"
+
+namespace {
+
+struct TraceClock {
+    uint64_t hz = 1000000000;
+    unsigned bits = 64;
+};
+
+void write_text(void * arg, const char * text)
+{
+    static_cast<std::ostream *>(arg)->write(text, std::strlen(text));
+}
+
+// "# i2ctrace hz=72000000 bits=29"
+bool parse_header(const std::string & line, TraceClock & clock)
+{
+    if(line.find("i2ctrace") == std::string::npos) return false;
+    std::size_t hz = line.find("hz=");
+    std::size_t bits = line.find("bits=");
+    if(hz != std::string::npos) clock.hz = std::strtoull(line.c_str() + hz + 3, nullptr, 10);
+    if(bits != std::string::npos) clock.bits = static_cast<unsigned>(std::strtoul(line.c_str() + bits + 5, nullptr, 10));
+    return clock.hz && clock.bits && clock.bits <= 64;
+}
+
+// "<timestamp> <flags>"
+bool parse_event(const std::string & line, uint64_t & stamp, unsigned & flags)
+{
+    char * end;
+    const char * text = line.c_str();
+    if(!std::isdigit(static_cast<unsigned char>(*text))) return false;
+    stamp = std::strtoull(text, &end, 10);
+    if(end == text || *end != ' ') return false;
+    text = end;
+    unsigned long value = std::strtoul(text, &end, 10);
+    if(end == text || value > 7) return false;
+    flags = static_cast<unsigned>(value);
+    return true;
+}
+
+uint64_t to_ns(uint64_t ticks, uint64_t hz)
+{
+    return ticks / hz * 1000000000ULL + ticks % hz * 1000000000ULL / hz;
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    if(argc > 3 || (argc > 1 && (!std::strcmp(argv[1], "-h") || !std::strcmp(argv[1], "--help")))) {
+        std::fprintf(stderr, "Usage: %s [trace.txt|-] [trace.vcd]\n", argv[0]);
+        return 2;
+    }
+    std::ios::sync_with_stdio(false);
+    std::ifstream in_file;
+    std::istream * in = &std::cin;
+    if(argc > 1 && std::strcmp(argv[1], "-")) {
+        in_file.open(argv[1]);
+        if(!in_file) {
+            std::fprintf(stderr, "Can't open %s\n", argv[1]);
+            return 1;
+        }
+        in = &in_file;
+    }
+    std::ofstream out_file;
+    std::ostream * out = &std::cout;
+    if(argc > 2) {
+        out_file.open(argv[2], std::ios::binary);
+        if(!out_file) {
+            std::fprintf(stderr, "Can't create %s\n", argv[2]);
+            return 1;
+        }
+        out = &out_file;
+    }
+
+    TraceClock clock;
+    I2C_VCD vcd;
+    i2c_vcd_begin(&vcd, write_text, out, "i2c2vcd");
+    std::string line;
+    uint64_t events = 0, ticks = 0, last = 0;
+    while(std::getline(*in, line)) {
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        if(line.rfind("#", 0) == 0) {
+            if(parse_header(line, clock)) events = 0; // a new capture starts from its first event
+            continue;
+        }
+        uint64_t stamp;
+        unsigned flags;
+        if(!parse_event(line, stamp, flags)) continue;
+        uint64_t mask = clock.bits == 64 ? ~0ULL : (1ULL << clock.bits) - 1;
+        if(events) ticks += (stamp - last) & mask;
+        else if(clock.bits == 64) ticks = stamp; // absolute time
+        last = stamp;
+        events++;
+        i2c_vcd_event(&vcd, to_ns(ticks, clock.hz), static_cast<uint8_t>(flags));
+    }
+    i2c_vcd_end(&vcd, to_ns(ticks, clock.hz) + 1000);
+    out->flush();
+    std::fprintf(stderr, "%llu events\n", static_cast<unsigned long long>(events));
+    return out->good() ? 0 : 1;
+}
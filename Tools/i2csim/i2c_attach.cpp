@@ -0,0 +1,28 @@
+/*
+ * i2c_attach.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  The simulated devices on the host build's soft I2C bus, for the command line (nucleo_cli -s)
+ */
+
+#include "i2c_sim.h"
+#include "i2c_devices.h"
+#include "host.h"
+
+using namespace i2c_sim;
+
+// In real time, so the bus is only as accurate as the host's timing: the monitor isn't reported
+void i2c_sim_attach_devices(void)
+{
+    static Monitor monitor(Mode::Standard);
+    static Bus bus(monitor);
+    static Ds3231 rtc;
+    static At24c32 eeprom;
+    static Stretcher stretcher;
+    bus.add(rtc);
+    bus.add(eeprom);
+    bus.add(stretcher);
+    bus.attach();
+}
@@ -0,0 +1,155 @@
+/*
+ * i2c_bus.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Wired-AND bus, see i2c_sim.h
+ */
+
+#include "i2c_sim.h"
+#include "i2c_devices.h"
+
+extern "C" {
+#include "main.h"
+#include "soft_i2c.h"   // Soft_SCL_Pin, Soft_SDA_Pin
+}
+
+namespace i2c_sim {
+
+namespace {
+
+Bus * attached; // the bus on the host's GPIO hook
+
+// Called after each GPIO write and before each read: the master's outputs in, the input levels out
+uint32_t gpio_hook(GPIO_TypeDef * port, uint32_t odr)
+{
+    if(port != Soft_SCL_GPIO_Port || !attached) return odr;
+    attached->master(host_time_ns(), odr & Soft_SCL_Pin, odr & Soft_SDA_Pin);
+    odr &= ~(uint32_t)(Soft_SCL_Pin | Soft_SDA_Pin);
+    if(attached->level(SCL)) odr |= Soft_SCL_Pin;
+    if(attached->level(SDA)) odr |= Soft_SDA_Pin;
+    return odr;
+}
+
+} // namespace
+
+Bus::Bus(Monitor & monitor) : monitor_(monitor)
+{
+    set_rise_ns(300, 300);
+}
+
+Bus::~Bus()
+{
+    detach();
+}
+
+void Bus::add(Device & device)
+{
+    devices_.push_back(&device);
+    device.attach(*this, (unsigned)devices_.size()); // driver 0 is the master
+}
+
+void Bus::set_rise_ns(uint32_t scl_ns, uint32_t sda_ns)
+{
+    lines_[SCL].rise_ns = scl_ns;
+    lines_[SDA].rise_ns = sda_ns;
+}
+
+void Bus::attach()
+{
+    attached = this;
+    host_gpio_hook = gpio_hook;
+}
+
+void Bus::detach()
+{
+    if(attached != this) return;
+    attached = nullptr;
+    host_gpio_hook = nullptr;
+}
+
+void Bus::master(uint64_t t, bool scl, bool sda)
+{
+    run(t);
+    if(t > now_) now_ = t;
+    if(scl != master_scl_) {
+        master_scl_ = scl;
+        set_drive(0, SCL, scl, now_);
+    }
+    if(sda != master_sda_) {
+        master_sda_ = sda;
+        set_drive(0, SDA, sda, now_);
+    }
+    run(now_); // anything the change started now
+}
+
+void Bus::drive(unsigned driver, Line line, bool release)
+{
+    set_drive(driver, line, release, now_);
+}
+
+void Bus::schedule(uint64_t t, std::function<void()> action)
+{
+    events_.push(Event{t < now_ ? now_ : t, seq_++, std::move(action)});
+}
+
+void Bus::run(uint64_t t)
+{
+    while(!events_.empty() && events_.top().t <= t) {
+        Event event = events_.top();
+        events_.pop();
+        now_ = event.t;
+        event.action();
+    }
+}
+
+uint64_t Bus::settle()
+{
+    run(UINT64_MAX);
+    return now_;
+}
+
+void Bus::set_drive(unsigned driver, Line line, bool release, uint64_t t)
+{
+    LineState & state = lines_[line];
+    uint32_t low = state.low;
+    if(release)
+        state.low &= ~(1u << driver);
+    else
+        state.low |= 1u << driver;
+    if(state.low == low) return;
+    state.generation++; // cancels a rise in progress
+    if(state.low) {
+        // Pulled low: a falling edge, unless the line hadn't reached VIH yet
+        if(!low && state.level) {
+            state.level = false;
+            notify(line, false, t, t);
+        } else if(!low) {
+            monitor_.runt(line, state.released, t);
+        }
+        return;
+    }
+    // Released by the last driver: high once it's risen
+    state.released = t;
+    if(!state.rise_ns) {
+        state.level = true;
+        notify(line, true, t, t);
+        return;
+    }
+    uint32_t generation = state.generation;
+    schedule(t + state.rise_ns, [this, line, generation] {
+        LineState & s = lines_[line];
+        if(s.generation != generation) return;
+        s.level = true;
+        notify(line, true, s.released, now_);
+    });
+}
+
+void Bus::notify(Line line, bool level, uint64_t begin, uint64_t end)
+{
+    monitor_.edge(line, level, begin, end);
+    for(Device * device : devices_) device->edge(line, level, end);
+}
+
+} // namespace i2c_sim
@@ -0,0 +1,357 @@
+/*
+ * i2c_conformance.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  UM10204 timing conformance of the soft I2C master (soft_i2c.c, unmodified), for each of its
+ *  bus speeds
+ *
+ *  Usage: i2c_conformance [-m std|fast|fast+] [-e excess_ns] [-v]
+ *    -m  check one speed mode, default each mode soft_i2c.c has a speed for (I2C_SPEED)
+ *    -e  largest worst case margin that isn't excessive, default 1000 ns (see below)
+ *    -v  list each run
+ *
+ *  soft_i2c_start(), soft_i2c_stop(), soft_i2c_write8() and soft_i2c_read8(), and the transactions
+ *  built from them, are run against a DS3231 on the simulated bus (i2c_sim.h), in virtual time.
+ *  The runs sweep the GPIO access cost, the timer read cost, the rise time (up to the mode's tr)
+ *  and "interrupts": random extra time before GPIO accesses, which leaves the delays starting
+ *  anywhere in a timebase microsecond.  Each measurement is attributed to the operation in
+ *  progress as it ended.  The least value over all the runs is taken as the worst case.
+ *
+ *  A mode fails on a transfer error, a protocol error or timing violation, a parameter with no
+ *  samples, or an excessive margin: a worst case more than -e over the minimum, for the times set
+ *  by a delay (tHD;STA, tLOW, tHIGH, tSU;STA, tSU;STO, tBUF).  The delays are whole microseconds, so a worst case a microsecond over means
+ *  the delay could be a microsecond shorter - throughput wasted.  The report gives each mode's
+ *  effective SCL clock: clocks over the time the bus was busy (START to STOP).
+ *  Exits 1 if a mode fails.  Run by ctest.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "i2c_sim.h"
+#include "i2c_devices.h"
+
+extern "C" {
+#include "main.h"
+#include "soft_i2c.h"
+}
+
+using namespace i2c_sim;
+
+namespace {
+
+enum Op { START, STOP, WRITE8, READ8, WRITE_READ, DEVICE_READY, OP_COUNT };
+
+const char * const kOpNames[OP_COUNT] = {
+    "soft_i2c_start", "soft_i2c_stop", "soft_i2c_write8", "soft_i2c_read8", "i2c_write_read", "i2c_device_ready",
+};
+
+// Parameters set by the master's delays, checked for excessive margins
+const Param kDelayed[] = {HD_STA, LOW, HIGH, SU_STA, SU_STO, BUF};
+
+// Parameters the workload must measure - a mode without samples of one fails
+const Param kRequired[] = {HD_STA, LOW, HIGH, SU_STA, HD_DAT, SU_DAT, SU_STO, BUF};
+
+struct Run {
+    uint32_t gpio_ns;
+    uint32_t timer_ns;
+    uint32_t rise_ns;
+    uint32_t irq_ns;    // longest interrupt, 0: none
+};
+
+const uint32_t kGpioNs[] = {60, 150, 250, 400};
+const uint32_t kTimerNs[] = {30, 90, 140, 230};
+const uint32_t kIrqNs = 2000;
+
+// Operations in progress: their start times, for attributing measurements
+class Timeline {
+public:
+    void mark(Op op) { marks_.emplace_back(host_time_ns(), op); }
+    void clear() { marks_.clear(); }
+    int at(uint64_t t) const
+    {
+        auto it = std::upper_bound(marks_.begin(), marks_.end(), t,
+                [](uint64_t time, const std::pair<uint64_t, Op> & mark) { return time < mark.first; });
+        return it == marks_.begin() ? -1 : (int)std::prev(it)->second;
+    }
+
+private:
+    std::vector<std::pair<uint64_t, Op>> marks_;
+};
+
+Timeline timeline;
+
+// Interrupts: before a quarter of the GPIO accesses, up to irq_ns of extra time
+HOST_GPIO_HOOK bus_hook;
+uint32_t irq_ns;
+uint32_t irq_seed = 1;
+
+uint32_t irq_random()
+{
+    irq_seed ^= irq_seed << 13;  // xorshift32
+    irq_seed ^= irq_seed >> 17;
+    irq_seed ^= irq_seed << 5;
+    return irq_seed;
+}
+
+uint32_t irq_hook(GPIO_TypeDef * port, uint32_t odr)
+{
+    if(irq_ns && !(irq_random() & 3)) host_time_advance(irq_random() % irq_ns);
+    return bus_hook(port, odr);
+}
+
+// One pass of every operation.  Returns the number of transfer errors.
+unsigned workload(const Ds3231 & rtc)
+{
+    unsigned errors = 0;
+    const uint8_t time[] = {0x00, 0x56, 0x34, 0x12}; // register 0, 12:34:56
+
+    // Write the time
+    timeline.mark(START);
+    soft_i2c_start();
+    timeline.mark(WRITE8);
+    errors += soft_i2c_write8(DS3231_ADDRESS << 1);
+    for(uint8_t data : time) errors += soft_i2c_write8(data);
+    timeline.mark(STOP);
+    soft_i2c_stop();
+
+    // Register pointer back to 0, then read: each START closely follows a STOP (tBUF)
+    timeline.mark(START);
+    soft_i2c_start();
+    timeline.mark(WRITE8);
+    errors += soft_i2c_write8(DS3231_ADDRESS << 1);
+    errors += soft_i2c_write8(0x00);
+    timeline.mark(STOP);
+    soft_i2c_stop();
+    timeline.mark(START);
+    soft_i2c_start();
+    timeline.mark(WRITE8);
+    errors += soft_i2c_write8(DS3231_ADDRESS << 1 | 1);
+    uint8_t data[3];
+    timeline.mark(READ8);
+    for(unsigned i=0;i<sizeof(data);i++) data[i] = soft_i2c_read8(i == sizeof(data) - 1); // NAK the last
+    timeline.mark(STOP);
+    soft_i2c_stop();
+    if(std::memcmp(data, time + 1, sizeof(data))) errors++;
+
+    // Register pointer to 1, then a repeated START to read the minutes (tSU;STA)
+    timeline.mark(START);
+    soft_i2c_start();
+    timeline.mark(WRITE8);
+    errors += soft_i2c_write8(DS3231_ADDRESS << 1);
+    errors += soft_i2c_write8(0x01);
+    timeline.mark(START);
+    soft_i2c_start();
+    timeline.mark(WRITE8);
+    errors += soft_i2c_write8(DS3231_ADDRESS << 1 | 1);
+    timeline.mark(READ8);
+    uint8_t minutes = soft_i2c_read8(true);
+    timeline.mark(STOP);
+    soft_i2c_stop();
+    if(minutes != time[2]) errors++;
+
+    // Transactions
+    uint8_t reg = 0;
+    uint8_t regs[7];
+    timeline.mark(WRITE_READ);
+    if(i2c_write_read(DS3231_ADDRESS, &reg, 1, regs, sizeof(regs))) errors++;
+    for(unsigned i=0;i<sizeof(regs);i++) if(regs[i] != rtc.reg(i)) errors++;
+    timeline.mark(DEVICE_READY);
+    if(!i2c_device_ready(DS3231_ADDRESS)) errors++;
+    if(i2c_device_ready(DS3231_ADDRESS - 1)) errors++; // nobody there: NAK
+    return errors;
+}
+
+struct OpStats {
+    Measurement params[PARAM_COUNT];
+};
+
+// Sweep one speed mode.  Returns true if it conforms.
+bool check_mode(Mode mode, I2C_SPEED speed, int64_t excess_ns, bool verbose)
+{
+    Monitor monitor(mode);
+    const Timing & spec = monitor.spec();
+    const I2C_TIMING * delays = soft_i2c_timing(speed);
+    soft_i2c_set_speed(speed);
+
+    OpStats ops[OP_COUNT];
+    monitor.set_observer([&ops, &spec](Param param, int64_t value, uint64_t t) {
+        int op = timeline.at(t);
+        if(op < 0 || param == RISE) return;
+        Measurement & m = ops[op].params[param];
+        if(!m.count || value < m.min) m.min = value;
+        if(!m.count || value > m.max) m.max = value;
+        m.count++;
+        if(value < param_limit(spec, param)) m.violations++;
+    });
+
+    Ds3231 rtc;
+    Bus bus(monitor);
+    bus.add(rtc);
+    bus.attach();
+    bus_hook = host_gpio_hook;
+    host_gpio_hook = irq_hook;
+    HAL_GPIO_WritePin(Soft_SCL_GPIO_Port, Soft_SCL_Pin|Soft_SDA_Pin, GPIO_PIN_SET); // MX_GPIO_Init()
+
+    std::vector<Run> runs;
+    for(uint32_t rise : {spec.rise_max / 4, spec.rise_max})
+        for(uint32_t irq : {0u, kIrqNs})
+            for(uint32_t gpio : kGpioNs)
+                for(uint32_t timer : kTimerNs)
+                    runs.push_back(Run{gpio, timer, rise, irq});
+
+    std::printf("UM10204 %s (%u kHz), soft_i2c speed \"%s\": tLOW %u, tHIGH %u, tHD;STA %u, tSU;STO %u, "
+            "tSU;STA %u, tBUF %u us\n", spec.name, spec.fscl_khz, delays->name, delays->low_us, delays->high_us,
+            delays->start_us, delays->stop_us, delays->restart_us, delays->buf_us);
+    std::printf("%u runs: GPIO %u-%u ns, timer read %u-%u ns, rise %u-%u ns, interrupts none or up to %u ns\n\n",
+            (unsigned)runs.size(), kGpioNs[0], kGpioNs[3], kTimerNs[0], kTimerNs[3], spec.rise_max / 4, spec.rise_max,
+            kIrqNs);
+    if(verbose) std::printf("  GPIO  Timer   Rise    IRQ  Errors  SCL kHz\n");
+
+    unsigned errors = 0;
+    double slowest = 0, fastest = 0;
+    for(std::size_t r=0;r<runs.size();r++) {
+        const Run & run = runs[r];
+        host_time_virtual(run.gpio_ns, run.timer_ns);
+        host_time_advance(333); // each run starts at a different point in the microsecond
+        bus.set_rise_ns(run.rise_ns, run.rise_ns);
+        irq_ns = run.irq_ns;
+        uint64_t clocks = monitor.clocks(), busy = monitor.busy_ns();
+        timeline.clear();
+        unsigned run_errors = 0;
+        for(unsigned pass=0;pass<4;pass++) run_errors += workload(rtc);
+        uint64_t settled = bus.settle(); // the last STOP's rise
+        if(settled > host_time_ns()) host_time_advance(settled - host_time_ns());
+        errors += run_errors;
+        clocks = monitor.clocks() - clocks;
+        busy = monitor.busy_ns() - busy;
+        double khz = busy ? clocks * 1e6 / busy : 0.0;
+        if(!r || khz < slowest) slowest = khz;
+        if(!r || khz > fastest) fastest = khz;
+        if(verbose)
+            std::printf("%6u %6u %6u %6u %7u %8.1f\n", run.gpio_ns, run.timer_ns, run.rise_ns, run.irq_ns,
+                    run_errors, khz);
+    }
+    if(verbose) std::printf("\n");
+    host_gpio_hook = bus_hook;
+    bus.detach();
+    irq_ns = 0;
+
+    // Each operation's times
+    std::printf("Operation          Param      Limit ns   Min ns   Max ns    Count  Violations\n");
+    for(int op=0;op<OP_COUNT;op++) {
+        bool first = true;
+        for(int p=0;p<PARAM_COUNT;p++) {
+            const Measurement & m = ops[op].params[p];
+            if(!m.count) continue;
+            std::printf("%-18s %-8s >= %7" PRId64 " %8" PRId64 " %8" PRId64 " %8" PRIu64 " %11" PRIu64 "\n",
+                    first ? kOpNames[op] : "", param_name((Param)p), param_limit(spec, (Param)p), m.min, m.max,
+                    m.count, m.violations);
+            first = false;
+        }
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+    monitor.report(std::cout);
+    std::cout.flush();
+
+    // Worst case margins of the delayed times
+    unsigned excessive = 0;
+    std::printf("\nWorst case margin, excessive over %" PRId64 " ns:\n", excess_ns);
+    for(Param param : kDelayed) {
+        const Measurement & m = monitor.measurement(param);
+        if(!m.count) continue;
+        int64_t margin = m.min - param_limit(spec, param);
+        bool excess = margin > excess_ns;
+        if(excess) excessive++;
+        std::printf("%-8s %+7" PRId64 " ns  %3.0f%%  %s\n", param_name(param), margin,
+                margin * 100.0 / param_limit(spec, param), margin < 0 ? "VIOLATION" : excess ? "EXCESSIVE" : "ok");
+    }
+
+    // Parameters never measured - the workload didn't exercise them
+    unsigned missing = 0;
+    for(Param param : kRequired) {
+        if(monitor.measurement(param).count) continue;
+        std::printf("%-8s no samples\n", param_name(param));
+        missing++;
+    }
+
+    double khz = monitor.busy_ns() ? monitor.clocks() * 1e6 / monitor.busy_ns() : 0.0;
+    std::printf("\nEffective SCL clock %.1f kHz, %.0f%% of %u kHz (runs %.1f - %.1f kHz)\n", khz,
+            khz * 100 / spec.fscl_khz, spec.fscl_khz, slowest, fastest);
+    std::printf("Transactions %" PRIu64 ", bytes %" PRIu64 ", transfer errors %u\n", monitor.transactions(),
+            monitor.bytes(), errors);
+    bool pass = !errors && !monitor.violation_count() && !excessive && !missing;
+    std::printf("%s: %s\n\n", spec.name, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+bool number(const char * text, int64_t & value)
+{
+    char * end;
+    long long n = std::strtoll(text, &end, 0);
+    if(!*text || *end || n < 0) return false;
+    value = n;
+    return true;
+}
+
+// The soft I2C speed for a mode: the one with the mode's maximum clock
+bool find_speed(Mode mode, I2C_SPEED & speed)
+{
+    for(int s=0;s<I2C_SPEEDS;s++) {
+        if(soft_i2c_timing((I2C_SPEED)s)->max_khz == timing(mode).fscl_khz) {
+            speed = (I2C_SPEED)s;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    std::vector<Mode> modes = {Mode::Standard, Mode::Fast, Mode::FastPlus};
+    bool all = true, verbose = false;
+    int64_t excess_ns = 1000;
+    for(int i=1;i<argc;i++) {
+        bool ok = true;
+        Mode mode;
+        if(!std::strcmp(argv[i], "-v")) verbose = true;
+        else if(i + 1 < argc && !std::strcmp(argv[i], "-m") && (ok = parse_mode(argv[++i], mode))) {
+            modes = {mode};
+            all = false;
+        }
+        else if(i + 1 < argc && !std::strcmp(argv[i], "-e")) ok = number(argv[++i], excess_ns);
+        else ok = false;
+        if(!ok) {
+            std::fprintf(stderr, "Usage: %s [-m std|fast|fast+] [-e excess_ns] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    host_time_virtual(0, 0);
+    unsigned failed = 0, checked = 0;
+    for(Mode mode : modes) {
+        I2C_SPEED speed;
+        if(!find_speed(mode, speed)) {
+            std::printf("UM10204 %s: soft_i2c has no speed for it%s\n\n", timing(mode).name, all ? ", skipped" : "");
+            if(!all) failed++;
+            continue;
+        }
+        checked++;
+        if(!check_mode(mode, speed, excess_ns, verbose)) failed++;
+    }
+    soft_i2c_set_speed(I2C_SPEED_STANDARD);
+    std::printf("Speed modes checked %u, failed %u\n", checked, failed);
+    return failed ? 1 : 0;
+}
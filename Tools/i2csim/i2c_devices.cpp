@@ -0,0 +1,224 @@
+/*
+ * i2c_devices.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Simulated I2C targets, see i2c_devices.h
+ */
+
+#include "i2c_devices.h"
+
+namespace i2c_sim {
+
+Device::Device(uint8_t address, const char * name) : address_(address), name_(name)
+{
+}
+
+// Bus edge, at time t.  Data is sampled as SCL rises, driven after SCL falls.
+void Device::edge(Line line, bool level, uint64_t t)
+{
+    if(line == SDA) {
+        if(!bus_->level(SCL)) return; // data
+        if(selected_) on_stop();      // STOP, or a repeated START, ends any transfer to us
+        selected_ = false;
+        sda(true, t);
+        state_ = level ? State::Idle : State::Address;
+        shift_ = 0;
+        bits_ = 0;
+        return;
+    }
+
+    if(level) {
+        bool sda_level = bus_->level(SDA);
+        switch(state_) {
+        case State::Address:
+        case State::Write:
+            shift_ = (uint8_t)(shift_ << 1 | sda_level);
+            bits_++;
+            break;
+        case State::ReadAck:
+            master_ack_ = !sda_level;
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    // SCL fell
+    switch(state_) {
+    case State::Address:
+        if(bits_ < 8) break;
+        if((shift_ >> 1) == address_ && on_address(shift_ & 1)) {
+            selected_ = true;
+            read_ = shift_ & 1;
+            sda(false, t);
+            state_ = State::AddressAck;
+        } else {
+            state_ = State::Ignore;
+        }
+        break;
+    case State::Write:
+        if(bits_ < 8) break;
+        if(on_write(shift_)) sda(false, t);
+        state_ = State::WriteAck;
+        break;
+    case State::AddressAck:
+    case State::WriteAck:
+        if(read_) {
+            load(t);
+        } else {
+            sda(true, t);
+            state_ = State::Write;
+            shift_ = 0;
+            bits_ = 0;
+        }
+        stretch(t);
+        break;
+    case State::Read:
+        if(++bits_ < 8) {
+            sda(shift_ & (0x80 >> bits_), t);
+        } else {
+            sda(true, t); // the master acknowledges
+            state_ = State::ReadAck;
+        }
+        break;
+    case State::ReadAck:
+        if(master_ack_) {
+            load(t);
+            stretch(t);
+        } else {
+            state_ = State::Ignore; // NAK, the master sends STOP
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Device::sda(bool release, uint64_t t)
+{
+    bus_->schedule(t + output_delay_ns_, [this, release] { bus_->drive(driver_, SDA, release); });
+}
+
+void Device::load(uint64_t t)
+{
+    shift_ = on_read();
+    bits_ = 0;
+    sda(shift_ & 0x80, t);
+    state_ = State::Read;
+}
+
+void Device::stretch(uint64_t t)
+{
+    uint32_t ns = stretch_ns();
+    if(!ns) return;
+    bus_->drive(driver_, SCL, false); // SCL is already low, held from here
+    bus_->schedule(t + ns, [this] { bus_->drive(driver_, SCL, true); });
+}
+
+RegisterFile::RegisterFile(uint8_t address, const char * name, std::size_t size) :
+        Device(address, name), regs_(size)
+{
+}
+
+bool RegisterFile::on_address(bool read)
+{
+    (void)read;
+    pointer_set_ = false;
+    return true;
+}
+
+bool RegisterFile::on_write(uint8_t data)
+{
+    if(!pointer_set_) {
+        pointer_ = data % regs_.size();
+        pointer_set_ = true;
+        return true;
+    }
+    regs_[pointer_] = data;
+    pointer_ = (pointer_ + 1) % regs_.size();
+    return true;
+}
+
+uint8_t RegisterFile::on_read()
+{
+    uint8_t data = regs_[pointer_];
+    pointer_ = (pointer_ + 1) % regs_.size();
+    return data;
+}
+
+// Saturday (day 7) 17 October 2026, 12:00:00, control INTCN set, status OSF set (as at power on)
+Ds3231::Ds3231() : RegisterFile(0x68, "DS3231", 0x13)
+{
+    static const uint8_t reset[] = {0x00, 0x00, 0x12, 0x07, 0x17, 0x10, 0x26, 0, 0, 0, 0, 0, 0, 0, 0x1C, 0x88, 0, 0x19, 0x40};
+    for(std::size_t i=0;i<sizeof(reset);i++) regs_[i] = reset[i];
+}
+
+At24c32::At24c32(uint8_t address) : Device(address, "AT24C32"), memory_(kSize, 0xFF)
+{
+}
+
+bool At24c32::on_address(bool read)
+{
+    (void)read;
+    if(now() < busy_until_) {
+        busy_naks_++;
+        return false;
+    }
+    written_ = 0;
+    page_.clear();
+    return true;
+}
+
+bool At24c32::on_write(uint8_t data)
+{
+    switch(written_++) {
+    case 0:
+        pointer_ = (uint32_t)(data & 0x0F) << 8;
+        break;
+    case 1:
+        pointer_ |= data;
+        page_start_ = pointer_;
+        break;
+    default:
+        // Within the page, the address rolls over
+        if(page_.size() < kPage) page_.push_back(data);
+        else page_[(written_ - 3) % kPage] = data;
+        break;
+    }
+    return true;
+}
+
+uint8_t At24c32::on_read()
+{
+    uint8_t data = memory_[pointer_];
+    pointer_ = (pointer_ + 1) % kSize;
+    return data;
+}
+
+void At24c32::on_stop()
+{
+    if(page_.empty()) return;
+    uint32_t page = page_start_ & ~(uint32_t)(kPage - 1);
+    for(std::size_t i=0;i<page_.size();i++)
+        memory_[page | ((page_start_ + i) & (kPage - 1))] = page_[i];
+    pointer_ = page | ((page_start_ + page_.size()) & (kPage - 1));
+    page_.clear();
+    busy_until_ = now() + write_cycle_ns_;
+    write_cycles_++;
+}
+
+Stretcher::Stretcher(uint8_t address, uint32_t stretch_ns) :
+        RegisterFile(address, "stretcher", 16), stretch_ns_(stretch_ns)
+{
+}
+
+uint32_t Stretcher::stretch_ns()
+{
+    stretched_ns_ += stretch_ns_;
+    return stretch_ns_;
+}
+
+} // namespace i2c_sim
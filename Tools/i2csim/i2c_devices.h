@@ -0,0 +1,140 @@
+/*
+ * i2c_devices.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Simulated I2C targets, for the bus in i2c_sim.h
+ *
+ *  Device is the bit-level target: it follows START, the address, data bytes, acknowledges and
+ *  STOP on the bus edges, driving SDA tVD;DAT after SCL falls.  Models implement the byte-level
+ *  virtual functions.  A device may stretch the clock after each acknowledge, by holding SCL low.
+ */
+
+#ifndef TOOLS_I2CSIM_I2C_DEVICES_H_
+#define TOOLS_I2CSIM_I2C_DEVICES_H_
+
+#include <cstdint>
+#include <vector>
+#include "i2c_sim.h"
+
+namespace i2c_sim {
+
+class Device {
+public:
+    Device(uint8_t address, const char * name);
+    virtual ~Device() = default;
+
+    uint8_t address() const { return address_; }
+    const char * name() const { return name_; }
+    void set_output_delay(uint32_t ns) { output_delay_ns_ = ns; } // SCL falling to SDA valid
+
+protected:
+    // Byte level model, called at the acknowledge.  Return true to ACK, false to NAK.
+    virtual bool on_address(bool read) { (void)read; return true; }
+    virtual bool on_write(uint8_t data) = 0;
+    virtual uint8_t on_read() = 0;              // the next byte to send
+    virtual void on_stop() {}                   // STOP, or a START, ending a transfer to this device
+    virtual uint32_t stretch_ns() { return 0; } // hold SCL low this long after each acknowledge
+
+    uint64_t now() const { return bus_ ? bus_->now() : 0; }
+
+private:
+    friend class Bus;
+    enum class State { Idle, Address, AddressAck, Write, WriteAck, Read, ReadAck, Ignore };
+
+    void attach(Bus & bus, unsigned driver) { bus_ = &bus; driver_ = driver; }
+    void edge(Line line, bool level, uint64_t t);
+    void sda(bool release, uint64_t t);   // drive SDA, after the output delay
+    void load(uint64_t t);                // the next byte to read
+    void stretch(uint64_t t);
+
+    uint8_t address_;
+    const char * name_;
+    uint32_t output_delay_ns_ = 300;
+    Bus * bus_ = nullptr;
+    unsigned driver_ = 0;
+    State state_ = State::Idle;
+    bool selected_ = false; // addressed since the last START
+    bool read_ = false;
+    bool master_ack_ = false;
+    uint8_t shift_ = 0;
+    unsigned bits_ = 0;
+};
+
+// Register file with a register pointer: the first byte written sets the pointer, following bytes
+// are written from there, reads continue from there.  The pointer wraps at the end.
+class RegisterFile : public Device {
+public:
+    RegisterFile(uint8_t address, const char * name, std::size_t size);
+
+    uint8_t reg(std::size_t index) const { return regs_[index]; }
+    void set_reg(std::size_t index, uint8_t value) { regs_[index] = value; }
+
+protected:
+    bool on_address(bool read) override;
+    bool on_write(uint8_t data) override;
+    uint8_t on_read() override;
+
+    std::vector<uint8_t> regs_;
+    std::size_t pointer_ = 0;
+    bool pointer_set_ = false; // this transfer has written the pointer
+};
+
+// DS3231 RTC, 0x68: registers 0x00 - 0x12 (time, alarms, control, status, aging, temperature)
+class Ds3231 : public RegisterFile {
+public:
+    Ds3231();
+};
+
+// AT24C32 EEPROM, 0x50: 4K bytes, two address bytes, 32 byte pages.  A write is programmed at
+// STOP, the device doesn't acknowledge its address during the write cycle (tWR).
+class At24c32 : public Device {
+public:
+    static const std::size_t kSize = 4096;
+    static const std::size_t kPage = 32;
+
+    explicit At24c32(uint8_t address = 0x50);
+
+    void set_write_cycle_ns(uint64_t ns) { write_cycle_ns_ = ns; }
+    uint8_t data(std::size_t index) const { return memory_[index]; }
+    uint32_t write_cycles() const { return write_cycles_; }
+    uint32_t busy_naks() const { return busy_naks_; } // addresses not acknowledged, while writing
+
+protected:
+    bool on_address(bool read) override;
+    bool on_write(uint8_t data) override;
+    uint8_t on_read() override;
+    void on_stop() override;
+
+private:
+    std::vector<uint8_t> memory_;
+    std::vector<uint8_t> page_;   // written bytes, programmed at STOP
+    uint32_t pointer_ = 0;
+    uint32_t page_start_ = 0;
+    unsigned written_ = 0;        // bytes written this transfer, including the address
+    uint64_t write_cycle_ns_ = 5000000;
+    uint64_t busy_until_ = 0;
+    uint32_t write_cycles_ = 0;
+    uint32_t busy_naks_ = 0;
+};
+
+// A register file that stretches the clock after every acknowledge
+class Stretcher : public RegisterFile {
+public:
+    explicit Stretcher(uint8_t address = 0x42, uint32_t stretch_ns = 50000);
+
+    void set_stretch_ns(uint32_t ns) { stretch_ns_ = ns; }
+    uint64_t stretched_ns() const { return stretched_ns_; }
+
+protected:
+    uint32_t stretch_ns() override;
+
+private:
+    uint32_t stretch_ns_;
+    uint64_t stretched_ns_ = 0;
+};
+
+} // namespace i2c_sim
+
+#endif /* TOOLS_I2CSIM_I2C_DEVICES_H_ */
@@ -0,0 +1,256 @@
+/*
+ * i2c_monitor.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Protocol and timing checks, see i2c_sim.h
+ *
+ *  A START or STOP is only legal between bytes: after a multiple of 9 clocks.  The SCL rise before
+ *  a STOP or repeated START isn't a clock.  A line released and pulled low again before it reaches
+ *  VIH is a runt: no edge for the receivers, a violation if it was meant as a STOP (SDA with SCL
+ *  high) - typically a STOP followed too soon by a START.  tHD;DAT is measured
+ *  from SCL falling to each SDA change, tSU;DAT from the SDA change settling to SCL starting to
+ *  rise.  Rise times are checked against tr for both lines.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <ostream>
+#include "i2c_sim.h"
+
+namespace i2c_sim {
+
+namespace {
+
+// UM10204 rev. 7, Table 10
+const Timing kTiming[] = {
+    // name              kHz   HD;STA LOW   HIGH  SU;STA HD;DAT SU;DAT SU;STO BUF   tr    VD;DAT
+    {"Standard-mode",    100,  4000,  4700, 4000, 4700,  0,     250,   4000,  4700, 1000, 3450},
+    {"Fast-mode",        400,  600,   1300, 600,  600,   0,     100,   600,   1300, 300,  900},
+    {"Fast-mode Plus",   1000, 260,   500,  260,  260,   0,     50,    260,   500,  120,  450},
+};
+
+const char * const kParamNames[PARAM_COUNT] = {
+    "tHD;STA", "tLOW", "tHIGH", "tSU;STA", "tHD;DAT", "tSU;DAT", "tSU;STO", "tBUF", "tr",
+};
+
+} // namespace
+
+const Timing & timing(Mode mode)
+{
+    return kTiming[(int)mode];
+}
+
+bool parse_mode(const std::string & text, Mode & mode)
+{
+    if(text == "std" || text == "standard") mode = Mode::Standard;
+    else if(text == "fast") mode = Mode::Fast;
+    else if(text == "fast+" || text == "fm+") mode = Mode::FastPlus;
+    else return false;
+    return true;
+}
+
+const char * param_name(Param param)
+{
+    return kParamNames[param];
+}
+
+bool param_is_max(Param param)
+{
+    return param == RISE;
+}
+
+int64_t param_limit(const Timing & spec, Param param)
+{
+    switch(param) {
+    case HD_STA: return spec.hd_sta;
+    case LOW:    return spec.low;
+    case HIGH:   return spec.high;
+    case SU_STA: return spec.su_sta;
+    case HD_DAT: return spec.hd_dat;
+    case SU_DAT: return spec.su_dat;
+    case SU_STO: return spec.su_sto;
+    case BUF:    return spec.buf;
+    case RISE:   return spec.rise_max;
+    default:     return 0;
+    }
+}
+
+Monitor::Monitor(Mode mode) : spec_(timing(mode))
+{
+}
+
+void Monitor::clear()
+{
+    for(Measurement & m : measurements_) m = Measurement();
+    violations_.clear();
+    violation_count_ = 0;
+    protocol_errors_ = 0;
+    transactions_ = 0;
+    clocks_ = 0;
+    bytes_ = 0;
+    busy_ns_ = 0;
+}
+
+void Monitor::edge(Line line, bool level, uint64_t begin, uint64_t end)
+{
+    if(level && end > begin) measure(RISE, (int64_t)(end - begin), end);
+
+    if(line == SCL) {
+        if(level) {
+            if(busy_) {
+                if(scl_fell_) measure(LOW, (int64_t)(begin - scl_fall_), begin);
+                if(sda_changed_) measure(SU_DAT, (int64_t)begin - (int64_t)sda_change_, begin);
+                clocks_++;
+                frame_clocks_++;
+            }
+            sda_changed_ = false;
+            scl_rise_ = end;
+            scl_high_ = true;
+        } else {
+            if(busy_) {
+                if(start_pending_)
+                    measure(HD_STA, (int64_t)(begin - start_), begin);
+                else
+                    measure(HIGH, (int64_t)(begin - scl_rise_), begin);
+            }
+            start_pending_ = false;
+            scl_fall_ = begin;
+            scl_fell_ = true;
+            scl_high_ = false;
+        }
+        return;
+    }
+
+    if(!scl_high_) {
+        // Data change, while SCL is low
+        if(busy_ && scl_fell_) {
+            measure(HD_DAT, (int64_t)(begin - scl_fall_), begin);
+            sda_change_ = end;
+            sda_changed_ = true;
+        }
+        return;
+    }
+
+    // The SCL rise before a STOP or repeated START wasn't a clock
+    if(busy_ && scl_fell_) {
+        clocks_--;
+        frame_clocks_--;
+    }
+
+    if(!level) {
+        // START, or a repeated START
+        if(busy_) {
+            bytes_ += frame_clocks_ / 9;
+            measure(SU_STA, (int64_t)(begin - scl_rise_), begin);
+            if(frame_clocks_ % 9) {
+                protocol_errors_++;
+                violation("Sr", begin, "repeated START part way through a byte, " + where());
+            }
+        } else if(stopped_) {
+            measure(BUF, (int64_t)(begin - stop_), begin);
+        }
+        if(!busy_) busy_start_ = begin;
+        busy_ = true;
+        start_ = begin;
+        start_pending_ = true;
+        scl_fell_ = false;
+        frame_clocks_ = 0;
+        return;
+    }
+
+    // STOP.  Bus recovery may STOP without a START, that's allowed.
+    if(busy_) {
+        measure(SU_STO, (int64_t)(begin - scl_rise_), begin);
+        if(frame_clocks_ % 9) {
+            protocol_errors_++;
+            violation("P", begin, "STOP part way through a byte, " + where());
+        }
+        transactions_++;
+        bytes_ += frame_clocks_ / 9;
+        busy_ns_ += end - busy_start_;
+    }
+    busy_ = false;
+    start_pending_ = false;
+    stopped_ = true;
+    stop_ = end;
+}
+
+void Monitor::runt(Line line, uint64_t released, uint64_t t)
+{
+    if(line != SDA || !scl_high_) return; // data settling, not a condition
+    protocol_errors_++;
+    char text[96];
+    std::snprintf(text, sizeof(text), "SDA pulled low %" PRIu64 " ns after release, before VIH: no STOP, after byte %u",
+            t - released, (frame_clocks_ - (scl_fell_ ? 1 : 0)) / 9);
+    violation("runt", t, text);
+}
+
+void Monitor::measure(Param param, int64_t value, uint64_t t)
+{
+    Measurement & m = measurements_[param];
+    if(!m.count || value < m.min) m.min = value;
+    if(!m.count || value > m.max) m.max = value;
+    m.count++;
+    if(observer_) observer_(param, value, t);
+    int64_t limit = param_limit(spec_, param);
+    bool bad = param_is_max(param) ? value > limit : value < limit;
+    if(!bad) return;
+    m.violations++;
+    char text[96];
+    std::snprintf(text, sizeof(text), "%s %" PRId64 " ns, %s %" PRId64 " ns, ", param_name(param), value,
+            param_is_max(param) ? "max" : "min", limit);
+    violation(param_name(param), t, text + where());
+}
+
+void Monitor::violation(const char * kind, uint64_t t, const std::string & what)
+{
+    violation_count_++;
+    for(Violation & v : violations_) {
+        if(v.kind == kind) {
+            v.count++;
+            return;
+        }
+    }
+    violations_.push_back(Violation{kind, t, what, 1});
+}
+
+std::string Monitor::where() const
+{
+    if(!busy_) return "bus idle";
+    char text[48];
+    std::snprintf(text, sizeof(text), "byte %u bit %u", frame_clocks_ / 9, frame_clocks_ % 9);
+    return text;
+}
+
+void Monitor::report(std::ostream & out) const
+{
+    char line[96];
+    std::snprintf(line, sizeof(line), "Timing, UM10204 %s (%u kHz):\n", spec_.name, spec_.fscl_khz);
+    out << line;
+    out << "Param      Limit ns       Min ns     Max ns      Count  Violations\n";
+    for(int p=0;p<PARAM_COUNT;p++) {
+        Param param = (Param)p;
+        const Measurement & m = measurements_[p];
+        if(!m.count) {
+            std::snprintf(line, sizeof(line), "%-8s %2s %7" PRId64 "            -          -          0\n", param_name(param),
+                    param_is_max(param) ? "<=" : ">=", param_limit(spec_, param));
+        } else {
+            std::snprintf(line, sizeof(line), "%-8s %2s %7" PRId64 " %12" PRId64 " %10" PRId64 " %10" PRIu64 " %11" PRIu64 "\n",
+                    param_name(param), param_is_max(param) ? "<=" : ">=", param_limit(spec_, param),
+                    m.min, m.max, m.count, m.violations);
+        }
+        out << line;
+    }
+    if(protocol_errors_) out << "Protocol errors: " << protocol_errors_ << "\n";
+    if(violation_count_) {
+        out << "Violations: " << violation_count_ << ", the first of each kind:\n";
+        for(const Violation & v : violations_) {
+            std::snprintf(line, sizeof(line), "%8" PRIu64 " x  %12.3f us  ", v.count, v.t / 1000.0);
+            out << line << v.what << "\n";
+        }
+    }
+}
+
+} // namespace i2c_sim
@@ -0,0 +1,192 @@
+/*
+ * i2c_sim.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Cycle-approximate open-drain I2C bus simulator, for running soft_i2c.c on the host
+ *
+ *  Bus      Wired-AND SCL and SDA.  Each driver - the master's GPIO output latch, each device -
+ *           either pulls a line low or releases it.  A released line takes rise_ns to reach VIH
+ *           (the spec's tr, 30% to 70%), and reads low until then.  Falling edges are immediate.
+ *  Time     The host's clock in ns (host_time_ns(), Tools/host/host_hal.c) - normally virtual
+ *           time, advanced by the master's GPIO accesses and the delay loops' timer reads.
+ *           Devices react to bus edges through an event queue.  The bus is evaluated lazily:
+ *           each master GPIO access first runs the events due by then.
+ *  Devices  Bit-level I2C targets (Device, i2c_devices.h), with a byte-level model interface.
+ *  Monitor  Checks START/STOP placement and the UM10204 timing parameters of a speed mode, and
+ *           counts clocks and bytes for throughput.
+ *
+ *  Edges are reported with two times: a rising edge begins when the line is released (below VIL,
+ *  the 30% point, taken as the release) and ends at VIH (70%).  Parameters are measured between
+ *  the points UM10204 Figure 38 uses: e.g. tLOW ends as SCL starts to rise, tHIGH starts once
+ *  SCL is high.
+ */
+
+#ifndef TOOLS_I2CSIM_I2C_SIM_H_
+#define TOOLS_I2CSIM_I2C_SIM_H_
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace i2c_sim {
+
+enum Line { SCL, SDA };
+
+// UM10204 Table 10 - ns, minimums except rise_max (tr) and vd_dat (tVD;DAT, tVD;ACK)
+struct Timing {
+    const char * name;
+    uint32_t fscl_khz;  // maximum SCL clock
+    uint32_t hd_sta;
+    uint32_t low;
+    uint32_t high;
+    uint32_t su_sta;
+    uint32_t hd_dat;
+    uint32_t su_dat;
+    uint32_t su_sto;
+    uint32_t buf;
+    uint32_t rise_max;
+    uint32_t vd_dat;
+};
+
+enum class Mode { Standard, Fast, FastPlus };
+const Timing & timing(Mode mode);
+bool parse_mode(const std::string & text, Mode & mode); // "std", "fast", "fast+"
+
+// Parameters measured by the monitor
+enum Param { HD_STA, LOW, HIGH, SU_STA, HD_DAT, SU_DAT, SU_STO, BUF, RISE, PARAM_COUNT };
+const char * param_name(Param param);
+bool param_is_max(Param param);                       // a maximum (tr), not a minimum
+int64_t param_limit(const Timing & spec, Param param);
+
+struct Measurement {
+    uint64_t count = 0;
+    int64_t min = 0;
+    int64_t max = 0;
+    uint64_t violations = 0;
+};
+
+// Violations of one kind: the first, and how many
+struct Violation {
+    std::string kind;
+    uint64_t t;         // ns, the first
+    std::string what;
+    uint64_t count;
+};
+
+class Monitor {
+public:
+    explicit Monitor(Mode mode);
+
+    void edge(Line line, bool level, uint64_t begin, uint64_t end);
+    void runt(Line line, uint64_t released, uint64_t t); // pulled low again before reaching VIH
+    void clear();   // measurements, violations and counts - not the bus state
+
+    // Called with each measurement (t: the edge ending it), e.g. to attribute it to an operation
+    using Observer = std::function<void(Param param, int64_t value, uint64_t t)>;
+    void set_observer(Observer observer) { observer_ = std::move(observer); }
+
+    const Timing & spec() const { return spec_; }
+    const Measurement & measurement(Param param) const { return measurements_[param]; }
+    const std::vector<Violation> & violations() const { return violations_; }
+    uint64_t violation_count() const { return violation_count_; }
+    uint64_t protocol_errors() const { return protocol_errors_; }
+
+    // Throughput: clocks and complete bytes (9 clocks) inside START ... STOP
+    uint64_t transactions() const { return transactions_; }
+    uint64_t clocks() const { return clocks_; }
+    uint64_t bytes() const { return bytes_; }
+    uint64_t busy_ns() const { return busy_ns_; }   // START to STOP, summed
+
+    void report(std::ostream & out) const;
+
+private:
+    void measure(Param param, int64_t value, uint64_t t);
+    void violation(const char * kind, uint64_t t, const std::string & what);
+    std::string where() const;
+
+    const Timing & spec_;
+    Observer observer_;
+    Measurement measurements_[PARAM_COUNT];
+    std::vector<Violation> violations_;
+    uint64_t violation_count_ = 0;
+    uint64_t protocol_errors_ = 0;
+    uint64_t transactions_ = 0;
+    uint64_t clocks_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t busy_ns_ = 0;
+
+    // Bus state
+    bool scl_high_ = true;
+    bool busy_ = false;         // between START and STOP
+    bool start_pending_ = false; // START seen, SCL hasn't fallen yet
+    bool scl_fell_ = false;     // SCL has fallen since START
+    bool sda_changed_ = false;  // SDA changed since SCL fell
+    bool stopped_ = false;      // a STOP has been seen
+    uint32_t frame_clocks_ = 0; // clocks since START
+    uint64_t busy_start_ = 0;   // first START of the transaction
+    uint64_t start_ = 0;
+    uint64_t stop_ = 0;
+    uint64_t scl_rise_ = 0;     // SCL reached VIH
+    uint64_t scl_fall_ = 0;
+    uint64_t sda_change_ = 0;   // SDA settled
+};
+
+class Device;
+
+class Bus {
+public:
+    explicit Bus(Monitor & monitor);
+    ~Bus();
+
+    void add(Device & device);
+    void set_rise_ns(uint32_t scl_ns, uint32_t sda_ns);
+    void attach();  // become the host's GPIO hook, for the soft I2C pins (host_gpio_hook)
+    void detach();
+
+    // The master's output latch (true: released), at time t
+    void master(uint64_t t, bool scl, bool sda);
+    bool level(Line line) const { return lines_[line].level; }
+    uint64_t now() const { return now_; }
+
+    // For devices: change a driver's output at the current time, or later
+    void drive(unsigned driver, Line line, bool release);
+    void schedule(uint64_t t, std::function<void()> action);
+    void run(uint64_t t);   // run the events due by time t
+    uint64_t settle();      // run every pending event, the master idle: returns the time it ends
+
+private:
+    struct LineState {
+        uint32_t low = 0;           // drivers pulling the line low, bit per driver
+        bool level = true;          // logic level
+        uint64_t released = 0;      // time the last driver released it
+        uint32_t generation = 0;    // cancels a rise, when the line is pulled low again
+        uint32_t rise_ns = 0;
+    };
+    struct Event {
+        uint64_t t;
+        uint64_t seq;
+        std::function<void()> action;
+        bool operator>(const Event & other) const { return t != other.t ? t > other.t : seq > other.seq; }
+    };
+
+    void set_drive(unsigned driver, Line line, bool release, uint64_t t);
+    void notify(Line line, bool level, uint64_t begin, uint64_t end);
+
+    Monitor & monitor_;
+    std::vector<Device *> devices_;
+    LineState lines_[2];
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    uint64_t seq_ = 0;
+    uint64_t now_ = 0;
+    bool master_scl_ = true;
+    bool master_sda_ = true;
+};
+
+} // namespace i2c_sim
+
+#endif /* TOOLS_I2CSIM_I2C_SIM_H_ */
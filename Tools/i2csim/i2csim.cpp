@@ -0,0 +1,240 @@
+/*
+ * i2csim.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Run the firmware's soft I2C master (soft_i2c.c, unmodified) against the simulated bus
+ *
+ *  Usage: i2csim [-m std|fast|fast+] [-r rise_ns] [-g gpio_ns] [-t timer_ns] [-s stretch_us]
+ *    -m  speed mode to check the timing against, default std (UM10204 Standard-mode)
+ *    -r  SCL and SDA rise time, default 300 ns
+ *    -g  time taken by each GPIO read or write, default 250 ns
+ *    -t  time taken by each timer read, default 140 ns (the delay loops spin reading TIM4)
+ *    -s  clock stretch by the stretching device, after each byte, default 50 us
+ *
+ *  Time is virtual (host_time_virtual()): the run is deterministic, and the GPIO and timer costs
+ *  stand in for the board's instruction timing.  The bus carries a DS3231 (0x68), an AT24C32
+ *  (0x50) with a 5 ms write cycle, and a clock stretching register file (0x42).  Each scenario is
+ *  listed with its bus throughput, then the timing measured against the speed mode.
+ *  Exits 1 if a scenario fails, or there's a protocol or timing violation.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "i2c_sim.h"
+#include "i2c_devices.h"
+
+extern "C" {
+#include "main.h"
+#include "soft_i2c.h"
+}
+
+using namespace i2c_sim;
+
+namespace {
+
+struct Devices {
+    Ds3231 rtc;
+    At24c32 eeprom;
+    Stretcher stretcher;
+};
+
+std::string hex(const uint8_t * data, std::size_t count)
+{
+    std::string text;
+    char byte[4];
+    for(std::size_t i=0;i<count;i++) {
+        std::snprintf(byte, sizeof(byte), i ? " %02X" : "%02X", data[i]);
+        text += byte;
+    }
+    return text;
+}
+
+bool bus_check(Devices & devices, std::string & detail)
+{
+    (void)devices;
+    if(soft_i2c_bus_check()) return true;
+    detail = "bus held";
+    return false;
+}
+
+bool scan(Devices & devices, std::string & detail)
+{
+    std::string found;
+    for(uint8_t address=I2C_ADDRESS_MIN;address<=I2C_ADDRESS_MAX;address++) {
+        if(!i2c_device_ready(address)) continue;
+        char text[8];
+        std::snprintf(text, sizeof(text), found.empty() ? "%02X" : " %02X", address);
+        found += text;
+    }
+    char expected[16];
+    std::snprintf(expected, sizeof(expected), "%02X %02X %02X", devices.stretcher.address(),
+            devices.eeprom.address(), devices.rtc.address());
+    detail = "found " + found;
+    return found == expected;
+}
+
+bool rtc_read(Devices & devices, std::string & detail)
+{
+    uint8_t reg = 0;
+    uint8_t data[0x13];
+    if(i2c_write_read(DS3231_ADDRESS, &reg, 1, data, sizeof(data))) {
+        detail = "NAK";
+        return false;
+    }
+    detail = "time " + hex(data, 3);
+    for(std::size_t i=0;i<sizeof(data);i++)
+        if(data[i] != devices.rtc.reg(i)) return false;
+    return true;
+}
+
+bool rtc_write(Devices & devices, std::string & detail)
+{
+    uint8_t time[] = {0x00, 0x30, 0x45, 0x09}; // register 0, 09:45:30
+    uint8_t data[3] = {};
+    if(i2c_write_read(DS3231_ADDRESS, time, sizeof(time), nullptr, 0) ||
+            i2c_write_read(DS3231_ADDRESS, time, 1, data, sizeof(data))) {
+        detail = "NAK";
+        return false;
+    }
+    detail = "read back " + hex(data, sizeof(data));
+    return !std::memcmp(data, time + 1, sizeof(data)) && devices.rtc.reg(2) == 0x09;
+}
+
+// Page write, acknowledge polling through the write cycle, read back
+bool eeprom(Devices & devices, std::string & detail)
+{
+    const uint16_t address = 0x0100;
+    uint8_t write[2 + 16] = {address >> 8, address & 0xFF};
+    for(unsigned i=0;i<16;i++) write[2 + i] = (uint8_t)(i * 7 + 3);
+    if(i2c_write_read(devices.eeprom.address(), write, sizeof(write), nullptr, 0)) {
+        detail = "write NAK";
+        return false;
+    }
+    uint64_t start = host_time_ns();
+    unsigned polls = 0;
+    while(!i2c_device_ready(devices.eeprom.address()) && polls < 1000) polls++;
+    uint64_t ready = host_time_ns() - start;
+    uint8_t read[16] = {};
+    if(i2c_write_read(devices.eeprom.address(), write, 2, read, sizeof(read))) {
+        detail = "read NAK";
+        return false;
+    }
+    char text[64];
+    std::snprintf(text, sizeof(text), "%u polls, ready after %.0f us", polls, ready / 1000.0);
+    detail = text;
+    return polls && polls < 1000 && !std::memcmp(read, write + 2, sizeof(read)) &&
+            devices.eeprom.data(address) == write[2];
+}
+
+bool stretch(Devices & devices, std::string & detail)
+{
+    uint64_t before = devices.stretcher.stretched_ns();
+    uint8_t write[] = {0x04, 0xA5, 0x5A, 0xC3};
+    uint8_t read[3] = {};
+    if(i2c_write_read(devices.stretcher.address(), write, sizeof(write), nullptr, 0) ||
+            i2c_write_read(devices.stretcher.address(), write, 1, read, sizeof(read))) {
+        detail = "NAK or timeout";
+        return false;
+    }
+    char text[64];
+    std::snprintf(text, sizeof(text), "held SCL %.0f us", (devices.stretcher.stretched_ns() - before) / 1000.0);
+    detail = text;
+    return !std::memcmp(read, write + 1, sizeof(read));
+}
+
+struct Scenario {
+    const char * name;
+    bool (*run)(Devices & devices, std::string & detail);
+};
+
+const Scenario kScenarios[] = {
+    {"bus check", bus_check},
+    {"scan", scan},
+    {"DS3231 read", rtc_read},
+    {"DS3231 write", rtc_write},
+    {"AT24C32 page", eeprom},
+    {"stretch", stretch},
+};
+
+bool number(const char * text, uint32_t & value)
+{
+    char * end;
+    unsigned long n = std::strtoul(text, &end, 0);
+    if(!*text || *end || n > UINT32_MAX) return false;
+    value = (uint32_t)n;
+    return true;
+}
+
+void usage(const char * name)
+{
+    std::fprintf(stderr, "Usage: %s [-m std|fast|fast+] [-r rise_ns] [-g gpio_ns] [-t timer_ns] [-s stretch_us]\n", name);
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    Mode mode = Mode::Standard;
+    uint32_t rise_ns = 300, gpio_ns = 250, timer_ns = 140, stretch_us = 50;
+    for(int i=1;i<argc;i++) {
+        bool ok = i + 1 < argc;
+        if(ok && !std::strcmp(argv[i], "-m")) ok = parse_mode(argv[++i], mode);
+        else if(ok && !std::strcmp(argv[i], "-r")) ok = number(argv[++i], rise_ns);
+        else if(ok && !std::strcmp(argv[i], "-g")) ok = number(argv[++i], gpio_ns);
+        else if(ok && !std::strcmp(argv[i], "-t")) ok = number(argv[++i], timer_ns);
+        else if(ok && !std::strcmp(argv[i], "-s")) ok = number(argv[++i], stretch_us);
+        else ok = false;
+        if(!ok) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    host_time_virtual(gpio_ns, timer_ns);
+    Monitor monitor(mode);
+    Bus bus(monitor);
+    Devices devices;
+    devices.stretcher.set_stretch_ns(stretch_us * 1000);
+    bus.set_rise_ns(rise_ns, rise_ns);
+    bus.add(devices.rtc);
+    bus.add(devices.eeprom);
+    bus.add(devices.stretcher);
+    bus.attach();
+    HAL_GPIO_WritePin(Soft_SCL_GPIO_Port, Soft_SCL_Pin|Soft_SDA_Pin, GPIO_PIN_SET); // MX_GPIO_Init()
+
+    std::printf("Soft I2C on the simulated bus: rise %lu ns, GPIO %lu ns, timer read %lu ns\n\n",
+            (unsigned long)rise_ns, (unsigned long)gpio_ns, (unsigned long)timer_ns);
+    std::printf("Scenario       Result  Transfers  Bytes   Time us   Busy us  SCL kHz  Bytes/s\n");
+    unsigned failed = 0;
+    for(const Scenario & scenario : kScenarios) {
+        uint64_t transactions = monitor.transactions(), clocks = monitor.clocks(), bytes = monitor.bytes();
+        uint64_t busy = monitor.busy_ns(), start = host_time_ns();
+        std::string detail;
+        bool ok = scenario.run(devices, detail);
+        if(!ok) failed++;
+        uint64_t settled = bus.settle(); // the last STOP's rise
+        if(settled > host_time_ns()) host_time_advance(settled - host_time_ns());
+        transactions = monitor.transactions() - transactions;
+        clocks = monitor.clocks() - clocks;
+        bytes = monitor.bytes() - bytes;
+        busy = monitor.busy_ns() - busy;
+        uint64_t elapsed = host_time_ns() - start;
+        std::printf("%-14s %-6s %9lu %6lu %9.1f %9.1f %8.1f %8.0f  %s\n", scenario.name, ok ? "ok" : "FAIL",
+                (unsigned long)transactions, (unsigned long)bytes, elapsed / 1000.0, busy / 1000.0,
+                busy ? clocks * 1e6 / busy : 0.0, elapsed ? bytes * 1e9 / elapsed : 0.0, detail.c_str());
+    }
+    std::printf("%-14s %-6s %9lu %6lu %9.1f %9.1f %8.1f %8.0f\n\n", "total", failed ? "FAIL" : "ok",
+            (unsigned long)monitor.transactions(), (unsigned long)monitor.bytes(), host_time_ns() / 1000.0,
+            monitor.busy_ns() / 1000.0, monitor.busy_ns() ? monitor.clocks() * 1e6 / monitor.busy_ns() : 0.0,
+            host_time_ns() ? monitor.bytes() * 1e9 / host_time_ns() : 0.0);
+    std::fflush(stdout);
+    monitor.report(std::cout);
+    bus.detach();
+    return failed || monitor.violation_count() ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * i2ctx2json.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Convert an I2C transaction trace dump to Chrome trace JSON, for ui.perfetto.dev or
+ *  chrome://tracing
+ *
+ *  Usage: i2ctx2json [capture.txt|-] [trace.json]
+ *
+ *  Input is a terminal capture containing one or more "i2ctx dump" outputs (see i2c_txtrace.h),
+ *  other lines are ignored.  Each dump becomes a process, with tracks:
+ *    bus       every transaction, while it held the bus - gaps are idle bus time
+ *    <caller>  one per cooperative / kernel task, the whole call, with the time spent waiting for
+ *              the bus (contention) as a nested "wait" slice
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "i2c_txtrace.h"
+
+namespace {
+
+uint32_t get_u32(const uint8_t * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t get_u16(const uint8_t * p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+int hex_value(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+std::string json_string(const std::string & text)
+{
+    std::string out = "\"";
+    for(char c : text) {
+        if(c == '"' || c == '\\') out += '\\';
+        if(static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+class ChromeTrace {
+public:
+    explicit ChromeTrace(std::ostream & out) : out_(out) { out_ << "{\"traceEvents\":[\n"; }
+    ~ChromeTrace() { out_ << "\n],\"displayTimeUnit\":\"ns\"}\n"; }
+
+    void metadata(const char * what, int pid, int tid, const std::string & name)
+    {
+        begin_event();
+        out_ << "{\"name\":\"" << what << "\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+             << ",\"args\":{\"name\":" << json_string(name) << "}}";
+    }
+
+    void slice(int pid, int tid, const std::string & name, uint64_t ts, uint64_t dur, const std::string & args)
+    {
+        begin_event();
+        out_ << "{\"name\":" << json_string(name) << ",\"cat\":\"i2c\",\"ph\":\"X\",\"pid\":" << pid
+             << ",\"tid\":" << tid << ",\"ts\":" << ts << ",\"dur\":" << dur;
+        if(!args.empty()) out_ << ",\"args\":{" << args << "}";
+        out_ << "}";
+    }
+
+private:
+    void begin_event()
+    {
+        if(events_++) out_ << ",\n";
+    }
+
+    std::ostream & out_;
+    unsigned long events_ = 0;
+};
+
+const int BUS_TID = 1;
+
+// Convert one dump image.  Returns false if the image is malformed.
+bool convert_image(const std::vector<uint8_t> & image, int pid, ChromeTrace & trace)
+{
+    if(image.size() < sizeof(I2C_TX_HEADER) || std::memcmp(image.data(), I2C_TX_MAGIC, 4)) return false;
+    const uint8_t * p = image.data();
+    unsigned record_size = p[5];
+    unsigned caller_count = p[6];
+    uint32_t record_count = get_u32(p + 8);
+    if(p[4] != I2C_TX_VERSION || record_size < sizeof(I2C_TX_RECORD)) return false;
+    std::size_t offset = sizeof(I2C_TX_HEADER);
+    std::vector<std::string> callers;
+    for(unsigned i=0;i<caller_count;i++) {
+        if(offset >= image.size() || offset + 1 + image[offset] > image.size()) return false;
+        callers.emplace_back(reinterpret_cast<const char *>(&image[offset + 1]), image[offset]);
+        offset += 1 + image[offset];
+    }
+    if(offset + static_cast<uint64_t>(record_count) * record_size > image.size()) return false;
+
+    trace.metadata("process_name", pid, 0, "NUCLEO-F103RB I2C (dump " + std::to_string(pid) + ")");
+    trace.metadata("thread_name", pid, BUS_TID, "bus");
+    for(std::size_t i=0;i<callers.size();i++)
+        trace.metadata("thread_name", pid, BUS_TID + 1 + static_cast<int>(i), callers[i]);
+
+    // The 32-bit microsecond times wrap - records are in order of completion, unwrap the end times
+    uint64_t end64 = 0;
+    uint32_t last_end = 0;
+    for(uint32_t n=0;n<record_count;n++, offset += record_size) {
+        const uint8_t * r = &image[offset];
+        uint32_t start = get_u32(r), end = get_u32(r + 4);
+        unsigned wait = get_u16(r + 8), addr = r[10], flags = r[11];
+        unsigned writes = r[12], reads = r[13], caller = r[14];
+        end64 = n ? end64 + (end - last_end) : end;
+        last_end = end;
+        uint64_t start64 = end64 - (end - start);
+        uint64_t locked64 = start64 + wait;
+
+        const char * op = flags & I2C_TX_PROBE ? "probe" :
+                (flags & I2C_TX_WRITE) && (flags & I2C_TX_READ) ? "wr" :
+                flags & I2C_TX_READ ? "read" : "write";
+        char name[32];
+        std::snprintf(name, sizeof(name), "%s 0x%02X%s", op, addr, flags & I2C_TX_NAK ? " NAK" : "");
+        std::string caller_name = caller < callers.size() ? callers[caller] : "?";
+        char args[160];
+        std::snprintf(args, sizeof(args), "\"addr\":\"0x%02X\",\"write\":%u,\"read\":%u,\"ack\":%s,\"wait_us\":%u,\"caller\":%s",
+                addr, writes, reads, flags & I2C_TX_NAK ? "false" : "true", wait, json_string(caller_name).c_str());
+
+        trace.slice(pid, BUS_TID, name, locked64, end64 - locked64, args);
+        int tid = BUS_TID + 1 + static_cast<int>(caller);
+        trace.slice(pid, tid, name, start64, end64 - start64, args);
+        if(wait) trace.slice(pid, tid, "wait", start64, wait, "");
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    if(argc > 3 || (argc > 1 && (!std::strcmp(argv[1], "-h") || !std::strcmp(argv[1], "--help")))) {
+        std::fprintf(stderr, "Usage: %s [capture.txt|-] [trace.json]\n", argv[0]);
+        return 2;
+    }
+    std::ifstream in_file;
+    std::istream * in = &std::cin;
+    if(argc > 1 && std::strcmp(argv[1], "-")) {
+        in_file.open(argv[1]);
+        if(!in_file) {
+            std::fprintf(stderr, "Can't open %s\n", argv[1]);
+            return 1;
+        }
+        in = &in_file;
+    }
+    std::ofstream out_file;
+    std::ostream * out = &std::cout;
+    if(argc > 2) {
+        out_file.open(argv[2]);
+        if(!out_file) {
+            std::fprintf(stderr, "Can't create %s\n", argv[2]);
+            return 1;
+        }
+        out = &out_file;
+    }
+
+    int dumps = 0, bad = 0;
+    {
+        ChromeTrace trace(*out);
+        std::string line;
+        std::vector<uint8_t> image;
+        bool in_dump = false;
+        while(std::getline(*in, line)) {
+            if(!line.empty() && line.back() == '\r') line.pop_back();
+            if(line.rfind("I2CTX BEGIN", 0) == 0) {
+                in_dump = true;
+                image.clear();
+            } else if(line.rfind("I2CTX END", 0) == 0) {
+                if(in_dump && convert_image(image, dumps + 1, trace)) dumps++;
+                else bad++;
+                in_dump = false;
+            } else if(in_dump) {
+                for(std::size_t i=0;i+1<line.size();i+=2) {
+                    int high = hex_value(line[i]), low = hex_value(line[i + 1]);
+                    if(high < 0 || low < 0) break;
+                    image.push_back(static_cast<uint8_t>(high << 4 | low));
+                }
+            }
+        }
+    }
+    out->flush();
+    std::fprintf(stderr, "%d dumps converted", dumps);
+    if(bad) std::fprintf(stderr, ", %d malformed", bad);
+    std::fprintf(stderr, "\n");
+    return dumps && out->good() ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/*
+ * pcprof.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Symbolize "pcsample dump" output against the firmware ELF file, as a flat profile
+ *
+ *  Usage: pcprof <firmware.elf> [capture.txt|-]
+ *
+ *  Input is a terminal capture containing a "pcsample dump" (see pcsample.h), other lines are
+ *  ignored - with several dumps, the last one is used.  Sampled PCs are charged to the function
+ *  (ELF STT_FUNC symbol) holding them:
+ *    self    samples executing in the function - where the time goes
+ *    callers samples by the interrupted code's return address (LR), so a leaf function's
+ *            time can be traced to who called it
+ *  The symbol table is read directly from the ELF file, no binutils needed.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Symbol {
+    uint32_t addr;
+    uint32_t size;
+    std::string name;
+};
+
+struct Sample {
+    uint32_t addr;
+    uint32_t count;
+};
+
+uint32_t get_u32(const uint8_t * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t get_u16(const uint8_t * p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// Function symbols of a 32-bit little endian ELF file, sorted by address
+bool read_symbols(const char * path, std::vector<Symbol> & symbols)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file) {
+        std::fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> elf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(elf.size() < 52 || std::memcmp(elf.data(), "\177ELF", 4) || elf[4] != 1 || elf[5] != 1) {
+        std::fprintf(stderr, "%s: not a 32-bit little endian ELF file\n", path);
+        return false;
+    }
+    uint32_t shoff = get_u32(&elf[32]);
+    unsigned shentsize = get_u16(&elf[46]), shnum = get_u16(&elf[48]);
+    if(shentsize < 40 || shoff + static_cast<uint64_t>(shnum) * shentsize > elf.size()) {
+        std::fprintf(stderr, "%s: bad section headers\n", path);
+        return false;
+    }
+    for(unsigned s=0;s<shnum;s++) {
+        const uint8_t * sh = &elf[shoff + s * shentsize];
+        if(get_u32(sh + 4) != 2) continue; // SHT_SYMTAB
+        uint32_t offset = get_u32(sh + 16), size = get_u32(sh + 20), link = get_u32(sh + 24);
+        uint32_t entsize = get_u32(sh + 36);
+        if(link >= shnum || entsize < 16 || offset + static_cast<uint64_t>(size) > elf.size()) break;
+        const uint8_t * strtab_sh = &elf[shoff + link * shentsize];
+        uint32_t str_offset = get_u32(strtab_sh + 16), str_size = get_u32(strtab_sh + 20);
+        if(str_offset + static_cast<uint64_t>(str_size) > elf.size()) break;
+        for(uint32_t e=0;e+entsize<=size;e+=entsize) {
+            const uint8_t * sym = &elf[offset + e];
+            uint32_t name = get_u32(sym), value = get_u32(sym + 4), sym_size = get_u32(sym + 8);
+            if((sym[12] & 0xF) != 2 || !get_u16(sym + 14) || name >= str_size) continue; // defined STT_FUNC
+            const char * text = reinterpret_cast<const char *>(&elf[str_offset + name]);
+            symbols.push_back({value & ~1u, sym_size, std::string(text, strnlen(text, str_size - name))});
+        }
+    }
+    if(symbols.empty()) {
+        std::fprintf(stderr, "%s: no function symbols (stripped?)\n", path);
+        return false;
+    }
+    // At the same address, the largest symbol sorts last - that's the one find_symbol() picks
+    std::sort(symbols.begin(), symbols.end(), [](const Symbol & a, const Symbol & b) {
+        return a.addr != b.addr ? a.addr < b.addr : a.size < b.size;
+    });
+    return true;
+}
+
+// Function holding an address, or nullptr
+const Symbol * find_symbol(const std::vector<Symbol> & symbols, uint32_t addr)
+{
+    auto it = std::upper_bound(symbols.begin(), symbols.end(), addr,
+            [](uint32_t a, const Symbol & s) { return a < s.addr; });
+    if(it == symbols.begin()) return nullptr;
+    --it;
+    // Zero size (assembly) symbols extend to the next symbol
+    if(it->size ? addr < it->addr + it->size : std::next(it) != symbols.end()) return &*it;
+    return nullptr;
+}
+
+// Total the samples per function, most first
+void print_profile(const char * title, const std::vector<Sample> & samples, const std::vector<Symbol> & symbols)
+{
+    std::map<std::string, uint64_t> totals;
+    uint64_t all = 0;
+    for(const Sample & sample : samples) {
+        const Symbol * symbol = find_symbol(symbols, sample.addr);
+        char unknown[24];
+        std::snprintf(unknown, sizeof(unknown), "?? 0x%08X", sample.addr);
+        totals[symbol ? symbol->name : unknown] += sample.count;
+        all += sample.count;
+    }
+    std::vector<std::pair<std::string, uint64_t>> sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto & a, const auto & b) { return a.second > b.second; });
+    std::printf("\n%s\n  %%      cum%%   samples  function\n", title);
+    uint64_t cumulative = 0;
+    for(const auto & entry : sorted) {
+        cumulative += entry.second;
+        std::printf("%6.2f  %6.2f  %8llu  %s\n", all ? 100.0 * entry.second / all : 0.0,
+                all ? 100.0 * cumulative / all : 0.0, static_cast<unsigned long long>(entry.second), entry.first.c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char * argv[])
+{
+    if(argc < 2 || argc > 3 || !std::strcmp(argv[1], "-h") || !std::strcmp(argv[1], "--help")) {
+        std::fprintf(stderr, "Usage: %s <firmware.elf> [capture.txt|-]\n", argv[0]);
+        return 2;
+    }
+    std::vector<Symbol> symbols;
+    if(!read_symbols(argv[1], symbols)) return 1;
+    std::ifstream in_file;
+    std::istream * in = &std::cin;
+    if(argc > 2 && std::strcmp(argv[2], "-")) {
+        in_file.open(argv[2]);
+        if(!in_file) {
+            std::fprintf(stderr, "Can't open %s\n", argv[2]);
+            return 1;
+        }
+        in = &in_file;
+    }
+
+    std::string line, header;
+    std::vector<Sample> pcs, lrs, dump_pcs, dump_lrs;
+    bool in_dump = false, found = false;
+    while(std::getline(*in, line)) {
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        if(line.rfind("PCSAMPLE BEGIN", 0) == 0) {
+            in_dump = true;
+            header = line.substr(15);
+            dump_pcs.clear();
+            dump_lrs.clear();
+        } else if(line.rfind("PCSAMPLE END", 0) == 0) {
+            if(in_dump) {
+                pcs.swap(dump_pcs);
+                lrs.swap(dump_lrs);
+                found = true;
+            }
+            in_dump = false;
+        } else if(in_dump && line.size() > 2 && (line[0] == 'P' || line[0] == 'L') && line[1] == ' ') {
+            char * end;
+            uint32_t addr = static_cast<uint32_t>(std::strtoul(line.c_str() + 2, &end, 16));
+            uint32_t count = static_cast<uint32_t>(std::strtoul(end, nullptr, 10));
+            (line[0] == 'P' ? dump_pcs : dump_lrs).push_back({addr, count});
+        }
+    }
+    if(!found) {
+        std::fprintf(stderr, "No \"pcsample dump\" output found\n");
+        return 1;
+    }
+    std::printf("pcsample %s\n", header.c_str());
+    print_profile("Flat profile (self)", pcs, symbols);
+    print_profile("Callers (LR)", lrs, symbols);
+    return 0;
+}
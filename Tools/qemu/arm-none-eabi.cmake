@@ -0,0 +1,12 @@
+# GNU Arm Embedded toolchain, for the QEMU image (see CMakeLists.txt)
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(CMAKE_C_COMPILER arm-none-eabi-gcc)
+set(CMAKE_ASM_COMPILER arm-none-eabi-gcc)
+set(CMAKE_OBJCOPY arm-none-eabi-objcopy)
+set(CMAKE_SIZE arm-none-eabi-size)
+
+# No OS to link test programs against
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
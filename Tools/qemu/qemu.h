@@ -0,0 +1,21 @@
+/*
+ * qemu.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  QEMU benchmark image - target support, see qemu_target.c
+ */
+
+#ifndef QEMU_QEMU_H_
+#define QEMU_QEMU_H_
+
+#include <stdint.h>
+
+#define QEMU_SYSCLK_HZ      24000000 // stm32vldiscovery machine, SysTick runs at the CPU clock
+#define QEMU_I2C_ADDRESS    0x68     // the stub target answers here (DS3231_ADDRESS)
+
+void qemu_init(void);               // clocks, SysTick timebase, console, I2C pins
+void qemu_exit(int status);         // end the emulation (semihosting), QEMU exits with status
+
+#endif /* QEMU_QEMU_H_ */
@@ -0,0 +1,161 @@
+/*
+ * qemu_bench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  Soft I2C benchmarks - main() of the QEMU image
+ *
+ *  Each benchmark runs an operation a number of times, timed with the microsecond timebase.  The
+ *  results are virtual nanoseconds per operation.  Under -icount shift=0 (see run_bench.sh) every
+ *  instruction takes 1ns of virtual time, so they're instruction counts: the same on every run of
+ *  the same image, whatever the host.  "ideal" is the time the I2C delays alone should take
+ *  (I2C_SCL_LOW_DELAY etc.), "overhead" is what the code adds - the hot path cost.  The loop and
+ *  the call through the table are included, a few instructions.
+ *
+ *  Output, a line per benchmark, then "done" (QEMU exits with status 0):
+ *      bench <name> <count> <ns/op> <ideal ns> <overhead ns>
+ *  If the stub target doesn't answer as expected, "FAIL ..." and status 1.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "timebase.h"
+#include "soft_i2c.h"
+#include "qemu.h"
+
+#define BIT_US      (I2C_SCL_LOW_DELAY + I2C_SCL_HIGH_DELAY)
+#define BYTE_US     (9 * BIT_US)                            // 8 bits and the acknowledge
+#define START_US    (I2C_BUF_DELAY + I2C_START_DELAY)       // after a STOP: the bus free time first
+#define STOP_US     (I2C_SCL_LOW_DELAY + I2C_STOP_DELAY)
+#define PROBE_US    (START_US + BYTE_US + STOP_US)          // address only
+
+#define WR_WRITE    1   // write_read: register pointer
+#define WR_READ     7   // DS3231 time and date registers
+
+typedef struct {
+    const char * name;
+    uint32_t count;
+    uint32_t ideal_us;      // I2C delays in one operation
+    void (*setup)(void);    // before timing, or NULL
+    void (*op)(void);
+    void (*teardown)(void); // after timing, or NULL
+} BENCH;
+
+static volatile uint32_t sink; // results, so the operations aren't optimized away
+
+static void timebase_op(void)
+{
+    sink = timebase_us32();
+}
+
+static void delay_op(void)
+{
+    i2c_delay_us(5);
+}
+
+static void start_stop_op(void)
+{
+    soft_i2c_start();
+    soft_i2c_stop();
+}
+
+static void write_setup(void)
+{
+    soft_i2c_start();
+    soft_i2c_write8(QEMU_I2C_ADDRESS << 1);
+}
+
+static void write_op(void)
+{
+    sink = soft_i2c_write8(0x55);
+}
+
+static void read_setup(void)
+{
+    soft_i2c_start();
+    soft_i2c_write8(QEMU_I2C_ADDRESS << 1 | 1);
+}
+
+static void read_op(void)
+{
+    sink = soft_i2c_read8(false); // ACK, more to come
+}
+
+static void read_teardown(void)
+{
+    soft_i2c_read8(true); // NAK the last
+    soft_i2c_stop();
+}
+
+static void probe_op(void)
+{
+    sink = i2c_device_ready(QEMU_I2C_ADDRESS);
+}
+
+static void probe_nak_op(void)
+{
+    sink = i2c_device_ready(QEMU_I2C_ADDRESS + 1);
+}
+
+static void write_read_op(void)
+{
+    uint8_t reg = 0;
+    uint8_t data[WR_READ];
+    sink = (uint32_t)i2c_write_read(QEMU_I2C_ADDRESS, &reg, WR_WRITE, data, WR_READ);
+}
+
+static const BENCH benches[] = {
+    {"timebase_us32", 10000, 0,                         NULL,        timebase_op,   NULL},
+    {"delay_5us",     1000,  5,                         NULL,        delay_op,      NULL},
+    {"start_stop",    1000,  START_US + STOP_US,        NULL,        start_stop_op, NULL},
+    {"write8",        1000,  BYTE_US,                   write_setup, write_op,      soft_i2c_stop},
+    {"read8",         1000,  BYTE_US,                   read_setup,  read_op,       read_teardown},
+    {"probe",         200,   PROBE_US,                  NULL,        probe_op,      NULL},
+    {"probe_nak",     200,   PROBE_US,                  NULL,        probe_nak_op,  NULL},
+    {"write_read",    100,   START_US + (1 + WR_WRITE) * BYTE_US + STOP_US +
+                             START_US + (1 + WR_READ) * BYTE_US + STOP_US,
+                                                        NULL,        write_read_op, NULL},
+};
+
+static void bench_run(const BENCH * bench)
+{
+    if(bench->setup) bench->setup();
+    uint64_t start = timebase_us64();
+    for(uint32_t i=0;i<bench->count;i++)
+        bench->op();
+    uint64_t elapsed = timebase_us64() - start;
+    if(bench->teardown) bench->teardown();
+    uint32_t ns = (uint32_t)(elapsed * 1000 / bench->count);
+    uint32_t ideal = bench->ideal_us * 1000;
+    printf("bench %-14s %6lu %9lu %9lu %9ld\n", bench->name, (unsigned long)bench->count,
+            (unsigned long)ns, (unsigned long)ideal, (long)ns - (long)ideal);
+}
+
+// The stub target must answer as a device would, or the benchmarks time the wrong paths
+static bool target_check(void)
+{
+    uint8_t reg = 0;
+    uint8_t data[WR_READ];
+    static const uint8_t expected[WR_READ] = {0, 1, 2, 3, 4, 5, 6};
+    return i2c_device_ready(QEMU_I2C_ADDRESS) && !i2c_device_ready(QEMU_I2C_ADDRESS + 1) &&
+            !i2c_write_read(QEMU_I2C_ADDRESS, &reg, WR_WRITE, data, WR_READ) &&
+            !memcmp(data, expected, sizeof(data));
+}
+
+int main(void)
+{
+    qemu_init();
+    printf("\nSoft I2C benchmarks, QEMU %lu Hz, virtual ns per operation\n", (unsigned long)SystemCoreClock);
+    if(!soft_i2c_bus_check() || !target_check()) {
+        printf("FAIL stub target\n");
+        qemu_exit(1);
+    }
+    printf("#     name            count     ns/op     ideal  overhead\n");
+    for(unsigned i=0;i<sizeof(benches)/sizeof(benches[0]);i++)
+        bench_run(&benches[i]);
+    printf("done\n");
+    qemu_exit(0);
+    return 0;
+}
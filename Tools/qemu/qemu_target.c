@@ -0,0 +1,171 @@
+/*
+ * qemu_target.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jim Merkle
+ *
+ *  QEMU benchmark image - what the stm32vldiscovery machine doesn't provide
+ *
+ *  The machine emulates the Cortex-M3 core (NVIC, SysTick), flash, 8K SRAM and the USARTs.  RCC,
+ *  GPIO and the timers are unimplemented: reads return 0, writes are ignored.  So:
+ *  - the clock isn't configured, SystemCoreClock is set to the machine's fixed QEMU_SYSCLK_HZ
+ *  - time is SysTick (TIMEBASE_SYSTICK), interrupt driven by the HAL's 1ms tick
+ *  - the console is USART2 (as on the board) written by polling, -serial null -serial stdio
+ *  - the soft I2C pins are latches in RAM, with a stub target on the bus (below)
+ *  - command line, scheduler and power modules aren't built, their hooks are stubbed
+ *
+ *  The stub target follows the master's SCL/SDA writes: after START it takes the address byte, and
+ *  answers QEMU_I2C_ADDRESS - it ACKs written bytes, and reads return a count (0, 1, 2 ...) until
+ *  the master NAKs.  There's no clock stretching: SCL reads back as written.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "main.h"
+#include "timebase.h"
+#include "soft_i2c.h"
+#include "command_line.h"
+#include "sched.h"
+#include "power.h"
+#include "qemu.h"
+
+// command_line.c, sched.c and power.c aren't part of the image
+int argc;
+char * argv[1];
+
+TASK * cl_start_task(const char * name, TASK_FUNC function, void * ctx)
+{
+    (void)name;
+    (void)function;
+    (void)ctx;
+    return NULL; // commands aren't run
+}
+
+TASK * sched_current(void)
+{
+    return NULL;
+}
+
+void power_idle(uint32_t idle_ms)
+{
+    (void)idle_ms;
+    __WFI();
+}
+
+void SysTick_Handler(void)
+{
+    HAL_IncTick();
+}
+
+void HardFault_Handler(void)
+{
+    printf("\nHardFault, CFSR 0x%08lX\n", SCB->CFSR);
+    qemu_exit(2);
+}
+
+// Console, USART2 - the transmit register is always empty on QEMU, the wait is for the board
+int __io_putchar(int ch)
+{
+    while(!(USART2->SR & USART_SR_TXE)) ;
+    USART2->DR = (uint8_t)ch;
+    return 1;
+}
+
+// Semihosting SYS_EXIT_EXTENDED: QEMU exits with the status (-semihosting-config enable=on)
+void qemu_exit(int status)
+{
+    fflush(stdout);
+    uint32_t block[2] = {0x20026, (uint32_t)status}; // ADP_Stopped_ApplicationExit
+    register uint32_t r0 __asm__("r0") = 0x20;
+    register uint32_t r1 __asm__("r1") = (uint32_t)block;
+    __asm__ volatile("bkpt 0xAB" : : "r"(r0), "r"(r1) : "memory");
+    while(1) ; // not under QEMU
+}
+
+// Soft I2C pins, and the stub target
+static uint32_t pins = Soft_SCL_Pin | Soft_SDA_Pin; // master outputs, released
+static struct {
+    bool active;        // between START and STOP
+    bool selected;      // addressed us
+    bool read;          // R/W bit
+    bool nak;           // the master NAKed a read, we're done
+    uint8_t address;    // address byte, shifted in
+    uint32_t clocks;    // bits clocked since START: SCL falling edges, after the one ending START
+} target;
+
+// The target pulls SDA low: acknowledges, and zero bits of read data
+static bool target_sda_low(void)
+{
+    if(!target.active || !target.selected || target.nak) return false;
+    uint32_t byte = target.clocks / 9;
+    uint32_t bit = target.clocks % 9;
+    if(bit == 8) return !byte || !target.read; // ACK the address, and written bytes
+    if(!target.read) return false;
+    uint8_t data = (uint8_t)(byte - 1);
+    return !(data & (0x80 >> bit));
+}
+
+static bool bus_sda(void)
+{
+    return (pins & Soft_SDA_Pin) && !target_sda_low();
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef * port, GPIO_InitTypeDef * init)
+{
+    (void)port;
+    (void)init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state)
+{
+    if(port != Soft_SCL_GPIO_Port) return;
+    bool scl = pins & Soft_SCL_Pin;
+    bool sda = bus_sda();
+    if(state == GPIO_PIN_RESET)
+        pins &= ~(uint32_t)pin;
+    else
+        pins |= pin;
+    bool scl_now = pins & Soft_SCL_Pin;
+    bool sda_now = bus_sda();
+
+    if(scl && scl_now && sda != sda_now) {
+        // START or STOP
+        target.active = !sda_now;
+        target.selected = false;
+        target.read = false;
+        target.nak = false;
+        target.address = 0;
+        target.clocks = UINT32_MAX; // SCL falls to end START
+    } else if(target.active && !scl && scl_now) {
+        // SCL rising: sample
+        uint32_t bit = target.clocks % 9;
+        if(target.clocks < 8)
+            target.address = (uint8_t)(target.address << 1 | sda_now);
+        else if(bit == 8 && target.read && target.clocks > 8 && sda_now)
+            target.nak = true;
+    } else if(target.active && scl && !scl_now) {
+        // SCL falling: next bit
+        if(++target.clocks == 8) {
+            target.selected = (target.address >> 1) == QEMU_I2C_ADDRESS;
+            target.read = target.address & 1;
+        }
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef * port, uint16_t pin)
+{
+    if(port != Soft_SCL_GPIO_Port) return GPIO_PIN_RESET;
+    if(pin == Soft_SDA_Pin) return bus_sda() ? GPIO_PIN_SET : GPIO_PIN_RESET;
+    return (pins & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void qemu_init(void)
+{
+    SystemCoreClock = QEMU_SYSCLK_HZ; // no RCC: the clock is the machine's
+    HAL_Init();                       // SysTick 1ms
+    timebase_init();
+
+    __HAL_RCC_USART2_CLK_ENABLE();
+    USART2->BRR = QEMU_SYSCLK_HZ / 2 / 115200; // PCLK1 = HCLK / 2
+    USART2->CR1 = USART_CR1_UE | USART_CR1_TE;
+}
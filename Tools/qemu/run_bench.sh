@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# run_bench.sh
+#
+#  Run the QEMU benchmark image (qemu_bench.c), optionally comparing with a baseline
+#
+#  Usage: run_bench.sh <nucleo_bench.elf> [baseline.txt [tolerance_%]]
+#
+#  The image's output goes to stdout - save it, and it's the baseline for later commits:
+#      run_bench.sh build-qemu/nucleo_bench.elf > bench-$(git rev-parse --short HEAD).txt
+#  With a baseline, each benchmark's change is listed (stderr), and any slower by more than the
+#  tolerance (default 1%) is a regression: exit status 1.
+#
+#  -icount shift=0 makes each instruction 1ns of virtual time, sleep=off keeps idle time off the
+#  host's clock: runs of the same image give the same numbers.  Set QEMU to use another binary.
+
+ELF=$1
+BASELINE=$2
+TOLERANCE=${3:-1}
+QEMU=${QEMU:-qemu-system-arm}
+if [ -z "$ELF" ]; then
+    echo "Usage: $0 <nucleo_bench.elf> [baseline.txt [tolerance_%]]" >&2
+    exit 2
+fi
+
+OUT=$(mktemp)
+trap 'rm -f "$OUT"' EXIT
+
+# USART1 to nowhere, USART2 (the firmware's console) to stdout
+timeout 300 "$QEMU" -M stm32vldiscovery -kernel "$ELF" -icount shift=0,sleep=off \
+    -display none -monitor none -serial null -serial stdio \
+    -semihosting-config enable=on,target=native | tr -d '\r' > "$OUT"
+cat "$OUT"
+if ! grep -q '^done$' "$OUT"; then
+    echo "$0: the benchmarks didn't complete" >&2
+    exit 1
+fi
+[ -n "$BASELINE" ] || exit 0
+
+awk -v tol="$TOLERANCE" '
+    FNR == NR { if($1 == "bench") base[$2] = $4; next }
+    $1 == "bench" && ($2 in base) {
+        slower = $4 > base[$2] * (1 + tol / 100)
+        change = base[$2] ? ($4 - base[$2]) * 100 / base[$2] : 0
+        printf "%-14s %9d -> %9d ns/op  %+7.2f%%%s\n", $2, base[$2], $4, change, slower ? "  REGRESSION" : ""
+        if(slower) failed = 1
+    }
+    END { exit failed }' "$BASELINE" "$OUT" >&2